@@ -51,11 +51,70 @@ extern "C" {
  * MINIMOD_INITFLAG_UNZIP - Mods are downloaded as ZIP files from mod.io.
  *	If your game cannot handle those directly and needs the files to be
  *	unpacked, this flag is what you are looking for.
+ * MINIMOD_INITFLAG_PREWARM - Call <minimod_prewarm()> with
+ *	MINIMOD_PREWARM_API during initialisation.
  */
 enum minimod_initflag
 {
 	MINIMOD_INITFLAG_TESTENV = 1,
 	MINIMOD_INITFLAG_UNZIP = 2,
+	MINIMOD_INITFLAG_PREWARM = 4,
+};
+
+/* Enum: minimod_prewarmflag
+ *
+ * Selects the hosts to connect to with <minimod_prewarm()>.
+ *
+ * MINIMOD_PREWARM_API - The API endpoint, i.e. api.mod.io
+ * MINIMOD_PREWARM_DOWNLOAD - Hosts modfiles were downloaded from
+ *	during recent sessions.
+ */
+enum minimod_prewarmflag
+{
+	MINIMOD_PREWARM_API = 1,
+	MINIMOD_PREWARM_DOWNLOAD = 2,
+};
+
+/* Enum: minimod_loglevel
+ *
+ * Severity of log messages. Each level includes all levels above it.
+ *
+ * MINIMOD_LOGLEVEL_NONE - Nothing is logged.
+ * MINIMOD_LOGLEVEL_ERROR - Failures, i.e. of requests or file operations.
+ *	This is the default.
+ * MINIMOD_LOGLEVEL_WARNING - Unexpected, but recoverable situations.
+ * MINIMOD_LOGLEVEL_INFO - Progress of requests and installations.
+ * MINIMOD_LOGLEVEL_DEBUG - Everything. Default if the library was built
+ *	with ENABLE_LOG=1.
+ */
+enum minimod_loglevel
+{
+	MINIMOD_LOGLEVEL_NONE,
+	MINIMOD_LOGLEVEL_ERROR,
+	MINIMOD_LOGLEVEL_WARNING,
+	MINIMOD_LOGLEVEL_INFO,
+	MINIMOD_LOGLEVEL_DEBUG,
+};
+
+/* Enum: minimod_transport
+ *
+ * How requests are sent, see <minimod_set_transport()>.
+ *
+ * MINIMOD_TRANSPORT_NETWORK - Requests go to the server. This is the
+ *	default.
+ * MINIMOD_TRANSPORT_RECORD - Requests go to the server, responses are
+ *	recorded into a file.
+ * MINIMOD_TRANSPORT_REPLAY - Responses are taken from a recorded file,
+ *	as fast as possible.
+ * MINIMOD_TRANSPORT_REPLAY_TIMED - Like MINIMOD_TRANSPORT_REPLAY, but
+ *	each response takes as long as it did when it was recorded.
+ */
+enum minimod_transport
+{
+	MINIMOD_TRANSPORT_NETWORK,
+	MINIMOD_TRANSPORT_RECORD,
+	MINIMOD_TRANSPORT_REPLAY,
+	MINIMOD_TRANSPORT_REPLAY_TIMED,
 };
 
 /* Enum: minimod_err
@@ -134,6 +193,122 @@ enum minimod_modstatus
 	MINIMOD_MODSTATUS_DELETED = 3,
 };
 
+/* Enum: minimod_endpoint
+ *
+ * Groups of requests for which <minimod_get_stats()> collects timings.
+ *
+ * MINIMOD_ENDPOINT_GAMES - <minimod_get_games()>
+ * MINIMOD_ENDPOINT_MODS - <minimod_get_mods()>
+ * MINIMOD_ENDPOINT_MODFILES - <minimod_get_modfiles()>
+ * MINIMOD_ENDPOINT_EVENTS - <minimod_get_mod_events()>,
+ *	<minimod_get_user_events()>
+ * MINIMOD_ENDPOINT_DEPENDENCIES - <minimod_get_dependencies()>
+ * MINIMOD_ENDPOINT_ME - <minimod_get_me()>
+ * MINIMOD_ENDPOINT_AUTH - <minimod_email_request()>,
+ *	<minimod_email_exchange()>, <minimod_steam_auth()>
+ * MINIMOD_ENDPOINT_RATINGS - <minimod_rate()>, <minimod_get_ratings()>
+ * MINIMOD_ENDPOINT_SUBSCRIPTIONS - <minimod_get_subscriptions()>,
+ *	<minimod_subscribe()>, <minimod_unsubscribe()>
+ * MINIMOD_ENDPOINT_DOWNLOAD - Downloads of modfiles by <minimod_install()>
+ */
+enum minimod_endpoint
+{
+	MINIMOD_ENDPOINT_GAMES,
+	MINIMOD_ENDPOINT_MODS,
+	MINIMOD_ENDPOINT_MODFILES,
+	MINIMOD_ENDPOINT_EVENTS,
+	MINIMOD_ENDPOINT_DEPENDENCIES,
+	MINIMOD_ENDPOINT_ME,
+	MINIMOD_ENDPOINT_AUTH,
+	MINIMOD_ENDPOINT_RATINGS,
+	MINIMOD_ENDPOINT_SUBSCRIPTIONS,
+	MINIMOD_ENDPOINT_DOWNLOAD,
+	MINIMOD_ENDPOINT_COUNT,
+};
+
+/* Enum: minimod_phase
+ *
+ * Phases of a request, which are timed separately.
+ *
+ * MINIMOD_PHASE_NETWORK - From issuing the request until the complete
+ *	response is available: queueing, DNS lookup, connecting, TLS handshake,
+ *	waiting for and transferring the response. netw does not report
+ *	these individually.
+ * MINIMOD_PHASE_DECODE - Decompressing the response.
+ * MINIMOD_PHASE_PARSE - Parsing the response's JSON.
+ * MINIMOD_PHASE_POPULATE - Filling minimod-structs from the parsed JSON.
+ * MINIMOD_PHASE_CALLBACK - Time spent in your callback function.
+ * MINIMOD_PHASE_EXTRACT - Unpacking downloaded mods.
+ */
+enum minimod_phase
+{
+	MINIMOD_PHASE_NETWORK,
+	MINIMOD_PHASE_DECODE,
+	MINIMOD_PHASE_PARSE,
+	MINIMOD_PHASE_POPULATE,
+	MINIMOD_PHASE_CALLBACK,
+	MINIMOD_PHASE_EXTRACT,
+	MINIMOD_PHASE_COUNT,
+};
+
+#define MINIMOD_HISTOGRAM_BUCKETS 28
+
+/* Struct: minimod_histogram
+ *
+ * Distribution of durations of one <minimod_phase>.
+ *
+ * count - Number of recorded durations
+ * total_us - Sum of all durations in microseconds
+ * max_us - Longest duration in microseconds
+ * buckets - *buckets[0]* counts durations below 1 microsecond,
+ *	*buckets[i]* durations in [2^(i-1); 2^i) microseconds.
+ *	The last bucket also counts everything longer.
+ */
+struct minimod_histogram
+{
+	uint64_t count;
+	uint64_t total_us;
+	uint64_t max_us;
+	uint64_t buckets[MINIMOD_HISTOGRAM_BUCKETS];
+};
+
+/* Struct: minimod_endpoint_stats
+ *
+ * See <minimod_get_stats()>.
+ *
+ * nrequests - Number of completed requests
+ * nfailed - Number of requests that were not successful (HTTP status)
+ * nbytes - Bytes received, before decompression
+ * phases - Timings, indexed by <minimod_phase>
+ */
+struct minimod_endpoint_stats
+{
+	uint64_t nrequests;
+	uint64_t nfailed;
+	uint64_t nbytes;
+	struct minimod_histogram phases[MINIMOD_PHASE_COUNT];
+};
+
+/* Struct: minimod_log_message
+ *
+ * See <minimod_log_callback()>.
+ *
+ * time - Timestamp in nanoseconds of a monotonic clock, taken when the
+ *	message was logged.
+ * module - Part of minimod that logged the message, i.e. "minimod", "util".
+ * text - The message, without trailing newline. Long messages are
+ *	truncated.
+ * level - Severity of the message.
+ */
+struct minimod_log_message
+{
+	uint64_t time;
+	char const *module;
+	char const *text;
+	enum minimod_loglevel level;
+	char _padding[4];
+};
+
 /* Struct: minimod_game
  *
  * https://docs.mod.io/#game-object
@@ -197,6 +372,32 @@ struct minimod_mod
 	char _padding[4];
 };
 
+/* Struct: minimod_mod_columns
+ *
+ * The fields of a list of <minimod_mod>s, each as an array of *count*
+ * elements, see <minimod_get_mods_columns()>. Element i of every array
+ * belongs to the same mod.
+ *
+ * Only fields of the mod itself and its stats are included, the
+ * submitted_by user can be reached through *more*.
+ */
+struct minimod_mod_columns
+{
+	size_t count;
+	uint64_t const *id;
+	uint64_t const *game_id;
+	uint64_t const *modfile_id;
+	uint64_t const *date_updated;
+	uint64_t const *ndownloads;
+	uint64_t const *nsubscribers;
+	uint64_t const *nratings_positive;
+	uint64_t const *nratings_negative;
+	enum minimod_modstatus const *status;
+	char const *const *name;
+	char const *const *summary;
+	void const *const *more;
+};
+
 /* Struct: minimod_modfile
  *
  * https://docs.mod.io/#modfile-object
@@ -248,6 +449,37 @@ struct minimod_event
 	char _padding[4];
 };
 
+/* Struct: minimod_installed_mod
+ *
+ * What minimod recorded when installing a mod.
+ *
+ * date_updated - Of the mod, when it was installed
+ * filesize - Of the installed modfile
+ * path - Either the ZIP file or the directory the mod was extracted to
+ */
+struct minimod_installed_mod
+{
+	uint64_t game_id;
+	uint64_t mod_id;
+	uint64_t modfile_id;
+	uint64_t date_updated;
+	uint64_t filesize;
+	char const *name;
+	char const *path;
+};
+
+/* Struct: minimod_modfs
+ *
+ * An installed mod opened by <minimod_mod_open()>, opaque.
+ */
+struct minimod_modfs;
+
+/* Struct: minimod_modfs_file
+ *
+ * A file within a mod opened by <minimod_mod_file_open()>, opaque.
+ */
+struct minimod_modfs_file;
+
 /* Struct: minimod_pagination
  *
  * https://docs.mod.io/#pagination
@@ -275,6 +507,9 @@ struct minimod_pagination
  *   - <minimod_get_more_bool()>
  *   - <minimod_get_more_float()>
  *
+ *   Nested fields are reached with the *minimod_path_get*-functions, see
+ *   <minimod_path_compile()>.
+ *
  *   This way neither memory nor time is spent on extracting/converting
  *   fields of the underlying JSON object, which may not even be required
  *   by the calling code.
@@ -326,6 +561,16 @@ typedef void (*minimod_get_mods_callback)(
   struct minimod_mod const *mods,
   struct minimod_pagination const *pagi);
 
+/* Callback: minimod_get_mods_columns_callback()
+ *
+ * See:
+ *  <minimod_get_mods_columns()>
+ */
+typedef void (*minimod_get_mods_columns_callback)(
+  void *userdata,
+  struct minimod_mod_columns const *mods,
+  struct minimod_pagination const *pagi);
+
 /* Callback: minimod_get_modfiles_callback()
  *
  * See:
@@ -402,6 +647,32 @@ typedef void (*minimod_enum_installed_mods_callback)(
   uint64_t in_mod_id,
   char const *in_path);
 
+/* Callback: minimod_get_installed_mods_callback()
+ *
+ * Called once with all the installed mods.
+ *
+ * See:
+ *  <minimod_get_installed_mods()>
+ */
+typedef void (*minimod_get_installed_mods_callback)(
+  void *in_userdata,
+  size_t in_nmods,
+  struct minimod_installed_mod const *in_mods);
+
+/* Callback: minimod_installed_changed_callback()
+ *
+ * Called whenever a mod is installed or uninstalled, by minimod or, while
+ * watched, by others. Called from one of minimod's threads.
+ *
+ * See:
+ *  <minimod_watch_installed()>
+ */
+typedef void (*minimod_installed_changed_callback)(
+  void *in_userdata,
+  uint64_t in_game_id,
+  uint64_t in_mod_id,
+  bool in_installed);
+
 /* Callback: minimod_get_events_callback()
  *
  * See:
@@ -456,6 +727,52 @@ typedef void (*minimod_subscription_change_callback)(
   uint64_t mod_id,
   int change);
 
+/* Callback: minimod_log_callback()
+ *
+ * Receives log messages. It is called from minimod's logging thread,
+ * one message at a time, in the order the messages were logged.
+ *
+ * *in_message* and its strings are only valid during the call.
+ *
+ * See:
+ *  <minimod_set_log()>
+ */
+typedef void (*minimod_log_callback)(
+  void *userdata,
+  struct minimod_log_message const *in_message);
+
+/* Callback: minimod_alloc_callback()
+ *
+ * Returns:
+ *	*bytes* of memory, aligned for any type, or NULL.
+ *
+ * See:
+ *  <minimod_set_allocator()>
+ */
+typedef void *(*minimod_alloc_callback)(void *userdata, size_t bytes);
+
+/* Callback: minimod_realloc_callback()
+ *
+ * Resize *ptr*, which is NULL or was returned by one of the
+ * allocator's functions, to *bytes* of memory.
+ *
+ * See:
+ *  <minimod_set_allocator()>
+ */
+typedef void *(*minimod_realloc_callback)(
+  void *userdata,
+  void *ptr,
+  size_t bytes);
+
+/* Callback: minimod_free_callback()
+ *
+ * Free *ptr*, which may be NULL.
+ *
+ * See:
+ *  <minimod_set_allocator()>
+ */
+typedef void (*minimod_free_callback)(void *userdata, void *ptr);
+
 /* Function: minimod_init()
  *
  * Not surprisingly this needs to be called before any other minimod_*
@@ -518,6 +835,201 @@ minimod_is_ratelimited(void);
 MINIMOD_LIB void
 minimod_set_debugtesting(int error_rate, int min_delay, int max_delay);
 
+/* Function: minimod_set_log()
+ *
+ * Select which messages are logged and where they go.
+ *
+ * Messages are formatted on the thread that logs them and queued in a
+ * lock-free ring buffer. A thread started by <minimod_init()> passes
+ * them on to *in_callback*. Before <minimod_init()> and after
+ * <minimod_deinit()> *in_callback* is called right away instead.
+ * Messages that do not fit into the ring buffer are dropped and counted.
+ *
+ * Messages below *in_level* are discarded before they are formatted.
+ *
+ * Parameters:
+ *	in_level - Least severe level to log.
+ *	in_callback - Receives the messages. If NULL they are written to
+ *		stdout, errors and warnings to stderr.
+ *	in_userdata - Passed to *in_callback*.
+ */
+MINIMOD_LIB void
+minimod_set_log(
+  enum minimod_loglevel in_level,
+  minimod_log_callback in_callback,
+  void *in_userdata);
+
+/* Function: minimod_set_endpoint()
+ *
+ * Send API requests to *in_url* instead of mod.io, i.e. to a local
+ * stand-in server for testing and benchmarking.
+ *
+ * The setting persists across <minimod_init()> and <minimod_deinit()>
+ * and takes precedence over MINIMOD_INITFLAG_TESTENV.
+ *
+ * Attention:
+ *	Only call it while minimod is not initialized.
+ *
+ * Parameters:
+ *	in_url - Base URL of the API, including its version,
+ *		i.e. "http://127.0.0.1:8080/v1". NULL restores the default.
+ */
+MINIMOD_LIB void
+minimod_set_endpoint(char const *in_url);
+
+/* Function: minimod_set_transport()
+ *
+ * Record responses into a file or serve them from a recorded file,
+ * i.e. to run tests and benchmarks offline and reproducibly.
+ *
+ * Responses are recorded with their HTTP status, the headers minimod
+ * uses, body and duration. Downloaded modfiles are recorded as well.
+ * The API key is left out of the recorded URIs.
+ *
+ * When replaying, requests are matched by HTTP verb and URI, without
+ * the API key. Repeated requests cycle through all matching responses.
+ * Requests without a matching response fail with HTTP status 404.
+ * Settings of <minimod_set_debugtesting()> apply to replayed responses,
+ * too.
+ *
+ * The setting persists across <minimod_init()> and <minimod_deinit()>.
+ * <minimod_deinit()> closes the recorded file, the next <minimod_init()>
+ * appends to it.
+ *
+ * Attention:
+ *	Only call it while minimod is not initialized.
+ *
+ * Parameters:
+ *	in_transport - See <minimod_transport>.
+ *	in_path - File to record to or to replay from. Ignored for
+ *		MINIMOD_TRANSPORT_NETWORK.
+ *
+ * Returns:
+ *	false if the file could not be opened or is not a recorded file.
+ *	In this case MINIMOD_TRANSPORT_NETWORK is used.
+ */
+MINIMOD_LIB bool
+minimod_set_transport(
+  enum minimod_transport in_transport,
+  char const *in_path);
+
+/* Function: minimod_set_allocator()
+ *
+ * Make minimod allocate memory through the given functions instead of
+ * malloc(), realloc() and free(). This includes the memory used by
+ * miniz and qajson4c on behalf of minimod, but not the memory used by
+ * the platform's HTTP stack.
+ *
+ * All three functions have to be given, or none to restore the default.
+ * They may be called from any thread, also concurrently.
+ *
+ * Attention:
+ *	Call it before any other minimod function, or after <minimod_deinit()>
+ *	when all threads which called minimod functions have exited.
+ *	Memory must not be freed by another allocator than the one it
+ *	was allocated by.
+ *
+ * Parameters:
+ *	in_alloc - Like malloc().
+ *	in_realloc - Like realloc().
+ *	in_free - Like free().
+ *	in_userdata - Passed to all three functions.
+ *
+ * Returns:
+ *	false if minimod is initialized or only some functions are given.
+ */
+MINIMOD_LIB bool
+minimod_set_allocator(
+  minimod_alloc_callback in_alloc,
+  minimod_realloc_callback in_realloc,
+  minimod_free_callback in_free,
+  void *in_userdata);
+
+/* Function: minimod_prewarm()
+ *
+ * Open connections to the hosts selected by *in_flags* in the background,
+ * so that the first actual request does not have to wait for DNS lookup
+ * and TLS handshake.
+ *
+ * Whether a connection is kept open after prewarming depends on the
+ * platform's HTTP stack (See the README's design notes on connections).
+ *
+ * Parameters:
+ *	in_flags - Combination of <minimod_prewarmflag>s.
+ */
+MINIMOD_LIB void
+minimod_prewarm(unsigned int in_flags);
+
+/* Function: minimod_get_stats()
+ *
+ * Get timings of all requests made to *in_endpoint* since the library
+ * was loaded.
+ *
+ * Statistics are collected without locks. The returned numbers are
+ * not guaranteed to be consistent with each other while requests are
+ * in flight.
+ *
+ * Parameters:
+ *	in_endpoint - Any of <minimod_endpoint>, but MINIMOD_ENDPOINT_COUNT.
+ *	out_stats - Receives the statistics.
+ */
+MINIMOD_LIB void
+minimod_get_stats(
+  enum minimod_endpoint in_endpoint,
+  struct minimod_endpoint_stats *out_stats);
+
+/* Function: minimod_set_tracing()
+ *
+ * Start or stop recording a timeline of requests, responses, their
+ * processing phases (see <minimod_phase>) and of installations.
+ *
+ * Events are kept in a ring buffer per thread, holding the most recent
+ * 4096 events of each thread. Recording is disabled by default.
+ *
+ * Attention:
+ *	Not thread-safe. Call it from one thread only.
+ */
+MINIMOD_LIB void
+minimod_set_tracing(bool in_enable);
+
+/* Function: minimod_write_trace()
+ *
+ * Write the events recorded since <minimod_set_tracing()> was first
+ * enabled to *in_path*, using Chrome's trace event format.
+ * Open the file with chrome://tracing or https://ui.perfetto.dev
+ *
+ * Returns:
+ *	false if the file could not be written.
+ */
+MINIMOD_LIB bool
+minimod_write_trace(char const *in_path);
+
+/* Function: minimod_set_batch_size()
+ *
+ * Deliver the items of list responses in batches of up to *in_items*,
+ * for <minimod_get_games()>, <minimod_get_mods()>, <minimod_get_modfiles()>
+ * and the event functions.
+ *
+ * Each item of the response is parsed on its own, so that the first
+ * batch is passed to the callback before the rest of the response is
+ * parsed. The callback is called once per batch with a NULL pagination,
+ * and a last time with the pagination, with the remaining items or none.
+ * Failed requests still get a single call with no items and no pagination.
+ *
+ * Items and their *more* data are only valid until the callback returns.
+ * Items are parsed while they are populated, thusly <minimod_get_stats()>
+ * records the time of both as populate phase, once per batch.
+ *
+ * Requests minimod makes on its own, i.e. for <minimod_install()>, are
+ * not batched.
+ *
+ * Parameters:
+ *	in_items - Maximum number of items per call, 0 passes all items at
+ *		once (default).
+ */
+MINIMOD_LIB void
+minimod_set_batch_size(size_t in_items);
+
 /* Topic: Queries */
 
 /* Topic: [Filtering Sorting Pagination]
@@ -576,6 +1088,26 @@ minimod_get_mods(
   minimod_get_mods_callback in_callback,
   void *in_userdata);
 
+/* Function: minimod_get_mods_columns()
+ *
+ * Like <minimod_get_mods()> for a list of mods, but the callback gets
+ * each field as an array of its own (<minimod_mod_columns>), i.e. to
+ * sort or score many mods by a few of their fields.
+ *
+ * Delivery in batches with <minimod_set_batch_size()> applies as well.
+ * On failure the callback gets no mods and no pagination.
+ *
+ *	Parameters:
+ *		in_filter - Can be NULL, otherwise see <[Filtering Sorting Pagination]>
+ *		in_game_id - ID of the game for which a list of mods shall be retrieved
+ */
+MINIMOD_LIB void
+minimod_get_mods_columns(
+  char const *in_filter,
+  uint64_t in_game_id,
+  minimod_get_mods_columns_callback in_callback,
+  void *in_userdata);
+
 /* Function: minimod_get_modfiles()
  *
  * Retrieve a list of available modfiles for a certain mod.
@@ -775,6 +1307,15 @@ minimod_get_user_events(
  * ZIP file or, if MINIMOD_INITFLAG_UNZIP was set, decompress the ZIP file
  * into a directory.
  *
+ * Updating an installed mod does not touch its files until the new ones
+ * are complete. They are written next to them, under names starting with
+ * '.', and then swapped in, which is atomic on Linux. Elsewhere the mod is
+ * missing for a moment in between. The old files are deleted like by
+ * <minimod_uninstall()>, those still open stay readable until closed.
+ * On Windows files cannot be replaced while open, thusly the update fails
+ * then. If downloading or extracting fails, the old files are left as they
+ * were.
+ *
  * Parameters:
  *	in_game_id - Cannot be 0.
  *	in_mod_id - Cannot be 0.
@@ -791,11 +1332,28 @@ minimod_install(
 /* Function: minimod_uninstall()
  *
  * Attempt to uninstall (delete) the specified mod.
+ *
+ * The mod's files are moved to the directory ".trash" in the root
+ * directory and deleted from there in the background, thusly this returns
+ * without waiting for large mods to be deleted. Whatever is not deleted
+ * by <minimod_deinit()> is deleted after the next <minimod_init()>. If the
+ * files cannot be moved, i.e. because the mod directory is on another
+ * file system, they are deleted right away.
+ *
+ * Returns:
+ *	false if the mod is not installed.
  */
 MINIMOD_LIB bool
 minimod_uninstall(uint64_t in_game_id, uint64_t in_mod_id);
 
 /* Function: minimod_is_installed()
+ *
+ * Answered from an index of the mod directory, which installing and
+ * uninstalling keep up to date. The index is saved to the file "manifest"
+ * in the root directory, so that <minimod_init()> can load it without
+ * reading the mod directory. Only if the manifest is missing or invalid
+ * the mod directory is scanned again, thusly changes made to it by others
+ * are not noticed, unless <minimod_watch_installed()> is used.
  *
  * Returns:
  *	true if the specified mod is installed.
@@ -813,7 +1371,10 @@ minimod_is_downloading(uint64_t in_game_id, uint64_t in_mod_id);
 
 /* Function: minimod_enum_installed_mods()
  *
- * Enumerate all currently installed mods.
+ * Enumerate all currently installed mods, in no particular order.
+ * Like <minimod_is_installed()>, it does not access the mod directory.
+ * The callback may install and uninstall mods, which are not reflected in
+ * the ongoing enumeration.
  *
  * Parameters:
  *  in_game_id - Can either specify a game-id to limit the enumeration
@@ -825,6 +1386,45 @@ minimod_enum_installed_mods(
   minimod_enum_installed_mods_callback in_callback,
   void *in_userdata);
 
+/* Function: minimod_get_installed_mods()
+ *
+ * Like <minimod_enum_installed_mods()>, but with all the information the
+ * index has, and in a single call.
+ *
+ * Parameters:
+ *  in_game_id - Can either specify a game-id to limit the list or 0 to
+ *		list all installed mods.
+ */
+MINIMOD_LIB void
+minimod_get_installed_mods(
+  uint64_t in_game_id,
+  minimod_get_installed_mods_callback in_callback,
+  void *in_userdata);
+
+/* Function: minimod_watch_installed()
+ *
+ * Watch the mod directory for changes made by others, i.e. a launcher
+ * removing a mod, and keep the index of installed mods up to date, so that
+ * <minimod_is_installed()> and the enumerations stay correct.
+ * *in_callback* is told about every mod installed or uninstalled from
+ * there on.
+ *
+ * On Linux inotify reports the changes as they happen. Elsewhere, or if
+ * inotify is not available, the mod directory is listed every 2 seconds.
+ * Either way the mod directory is listed once right away, to catch up with
+ * changes made while minimod was not running.
+ *
+ * Parameters:
+ *  in_callback - NULL to stop watching.
+ *
+ * Returns:
+ *  false if watching could not be started.
+ */
+MINIMOD_LIB bool
+minimod_watch_installed(
+  minimod_installed_changed_callback in_callback,
+  void *in_userdata);
+
 /* Function: minimod_get_installed_mod()
  *
  * Get the cached information for a installed mod.
@@ -842,6 +1442,118 @@ minimod_get_installed_mod(
   minimod_get_mods_callback in_callback,
   void *in_userdata);
 
+/* Function: minimod_get_installed_modfile_id()
+ *
+ * To find out whether an installed mod is outdated, without loading all
+ * of its information with <minimod_get_installed_mod()>.
+ *
+ * Returns:
+ *	The id of the installed modfile, 0 if the mod is not installed.
+ */
+MINIMOD_LIB uint64_t
+minimod_get_installed_modfile_id(uint64_t in_game_id, uint64_t in_mod_id);
+
+/* Function: minimod_mod_open()
+ *
+ * Open an installed mod to read the files within its ZIP file, without
+ * extracting it. The ZIP file is mapped into memory and its directory is
+ * read once, opening the mod again while it is open shares both. Stored
+ * files are read straight from the mapping, deflated files are inflated
+ * as they are read, in blocks of 64 KiB of which the 64 used last are
+ * kept per mod.
+ *
+ * A mod may be used from several threads at once, a single file may not.
+ * Updating or uninstalling the mod does not affect it until it is closed,
+ * except on Windows, where doing so fails while it is open.
+ *
+ * Returns:
+ *	NULL if the mod is not installed as a ZIP file, i.e. because it was
+ *	extracted by MINIMOD_INITFLAG_UNZIP.
+ */
+MINIMOD_LIB struct minimod_modfs *
+minimod_mod_open(uint64_t in_game_id, uint64_t in_mod_id);
+
+/* Function: minimod_mod_close()
+ *
+ * All files of the mod have to be closed before.
+ */
+MINIMOD_LIB void
+minimod_mod_close(struct minimod_modfs *in_mod);
+
+/* Function: minimod_mod_file_open()
+ *
+ * Parameters:
+ *	in_path - Path of the file within the ZIP file, using '/'. The case
+ *		does not matter.
+ *
+ * Returns:
+ *	NULL if there is no such file, or if it is compressed with anything
+ *	but deflate.
+ */
+MINIMOD_LIB struct minimod_modfs_file *
+minimod_mod_file_open(struct minimod_modfs *in_mod, char const *in_path);
+
+/* Function: minimod_mod_file_close()
+ */
+MINIMOD_LIB void
+minimod_mod_file_close(struct minimod_modfs_file *in_file);
+
+/* Function: minimod_mod_file_read()
+ *
+ * Read up to *in_bytes* from the current position, which advances past
+ * them.
+ *
+ * Returns:
+ *	The bytes read, less than *in_bytes* at the end of the file or if the
+ *	ZIP file is corrupt.
+ */
+MINIMOD_LIB size_t
+minimod_mod_file_read(
+  struct minimod_modfs_file *in_file,
+  void *out_data,
+  size_t in_bytes);
+
+/* Function: minimod_mod_file_seek()
+ *
+ * Set the current position, relative to the start of the file. Seeking
+ * back within a deflated file is fast as long as the blocks are still
+ * kept, otherwise it is inflated from its start again.
+ *
+ * Returns:
+ *	false if *in_position* is past the end of the file.
+ */
+MINIMOD_LIB bool
+minimod_mod_file_seek(
+  struct minimod_modfs_file *in_file,
+  uint64_t in_position);
+
+/* Function: minimod_mod_file_tell()
+ *
+ * Returns:
+ *	The current position.
+ */
+MINIMOD_LIB uint64_t
+minimod_mod_file_tell(struct minimod_modfs_file const *in_file);
+
+/* Function: minimod_mod_file_size()
+ *
+ * Returns:
+ *	The uncompressed size of the file.
+ */
+MINIMOD_LIB uint64_t
+minimod_mod_file_size(struct minimod_modfs_file const *in_file);
+
+/* Function: minimod_mod_file_data()
+ *
+ * Get the contents of a stored file without copying them.
+ *
+ * Returns:
+ *	The contents of the file, valid until the mod is closed. NULL if the
+ *	file is deflated, use <minimod_mod_file_read()> then.
+ */
+MINIMOD_LIB void const *
+minimod_mod_file_data(struct minimod_modfs_file const *in_file);
+
 
 /* Topic: Ratings */
 
@@ -972,6 +1684,101 @@ minimod_get_more_float(void const *in_more, char const *in_name);
 MINIMOD_LIB bool
 minimod_get_more_bool(void const *in_more, char const *in_name);
 
+/* Struct: minimod_path
+ *
+ * Opaque, see <minimod_path_compile()>.
+ */
+struct minimod_path;
+
+/* Function: minimod_path_compile()
+ *
+ * Prepare a path into *more* data for repeated use with the
+ * *minimod_path_get*-functions, which unlike the *minimod_get_more*-
+ * functions also reach into nested objects and arrays.
+ *
+ * Keys are separated by '.', array elements are selected by their index
+ * in brackets, i.e. "logo.thumb_320x180", "modfile.filehash.md5" or
+ * "media.images[0].original". A path which does not match the data, such
+ * as an index into an object, leads nowhere.
+ *
+ * A compiled path can be used with the *more* of any item and remembers
+ * where it found its keys, thusly lookups in items of the same list are
+ * fastest. It can be used from any thread.
+ *
+ * Returns:
+ *	NULL if *in_path* is not a valid path, otherwise free it with
+ *	<minimod_path_free()>.
+ */
+MINIMOD_LIB struct minimod_path *
+minimod_path_compile(char const *in_path);
+
+/* Function: minimod_path_free()
+ */
+MINIMOD_LIB void
+minimod_path_free(struct minimod_path *in_path);
+
+/* Function: minimod_path_get_string()
+ *
+ * Access data of *in_more* by a path compiled with
+ * <minimod_path_compile()>.
+ *
+ * Returns:
+ *	NULL if the path does not lead to a string.
+ */
+MINIMOD_LIB char const *
+minimod_path_get_string(void const *in_more, struct minimod_path *in_path);
+
+/* Function: minimod_path_get_int()
+ *
+ * Returns:
+ *	0 if the path does not lead to an integer.
+ */
+MINIMOD_LIB int64_t
+minimod_path_get_int(void const *in_more, struct minimod_path *in_path);
+
+/* Function: minimod_path_get_float()
+ *
+ * Returns:
+ *	0 if the path does not lead to a number.
+ */
+MINIMOD_LIB double
+minimod_path_get_float(void const *in_more, struct minimod_path *in_path);
+
+/* Function: minimod_path_get_bool()
+ *
+ * Returns:
+ *	false if the path does not lead to a boolean.
+ */
+MINIMOD_LIB bool
+minimod_path_get_bool(void const *in_more, struct minimod_path *in_path);
+
+/* Function: minimod_retain()
+ *
+ * Keep the parsed response *in_more* belongs to after the callback
+ * returns, so that the strings and *more* pointers of the structs passed
+ * to the callback stay valid without copying them.
+ * The structs themselves are not kept, copy them.
+ *
+ * A response is kept as a whole. For lists this includes all items, but
+ * with <minimod_set_batch_size()> every item is kept on its own.
+ *
+ * Each call needs to be matched by a call of <minimod_release()> before
+ * <minimod_deinit()>.
+ *
+ * Returns:
+ *	false if *in_more* is not part of a response that is still alive.
+ */
+MINIMOD_LIB bool
+minimod_retain(void const *in_more);
+
+/* Function: minimod_release()
+ *
+ * Undo <minimod_retain()>. Any pointer into the same response can be
+ * passed, i.e. the *more* of another item of the same list.
+ */
+MINIMOD_LIB void
+minimod_release(void const *in_more);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
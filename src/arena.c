@@ -0,0 +1,235 @@
+#include "arena.h"
+
+#include "log.h"
+#include "util.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#pragma GCC diagnostic push
+#ifdef __clang__
+#pragma GCC diagnostic ignored "-Wgnu-zero-variadic-macro-arguments"
+#endif
+#pragma GCC diagnostic ignored "-Wunused-macros"
+
+#define LOG(FMT, ...) LOG_DEBUG("arena", FMT, ##__VA_ARGS__)
+#define LOGE(FMT, ...) LOG_ERROR("arena", FMT, ##__VA_ARGS__)
+// bypasses the queue, since the process stops right after
+#define LOGA(FMT, ...) fprintf(stderr, "[arena] " FMT "\n", ##__VA_ARGS__)
+
+#define ASSERT(in_condition)                      \
+	do                                            \
+	{                                             \
+		if (__builtin_expect(!(in_condition), 0)) \
+		{                                         \
+			LOGA(                                 \
+			  "[assertion] %s:%i: '%s'",          \
+			  __FILE__,                           \
+			  __LINE__,                           \
+			  #in_condition);                     \
+			__asm__ volatile("int $0x03");        \
+			__builtin_unreachable();              \
+		}                                         \
+	} while (__LINE__ == -1)
+
+#pragma GCC diagnostic pop
+
+// CONFIG
+// ------
+// size of the first block of each thread
+#define ARENA_MIN_BLOCK (64 * 1024)
+#define ARENA_ALIGN 16
+
+
+// blocks are chained when an allocation does not fit into the current
+// one. once everything is released again, they are merged into a single
+// block of their combined size.
+struct arena_block
+{
+	struct arena_block *prev;
+	// bytes of data following the header
+	size_t size;
+	size_t used;
+	char _padding[8];
+};
+
+
+struct arena
+{
+	struct arena_block *top;
+	// number of marks not released yet
+	size_t depth;
+};
+
+
+// the arena of each thread
+static tss_t l_key;
+static bool l_has_key;
+
+
+static struct arena_block *
+new_block(struct arena_block *in_prev, size_t in_size)
+{
+	struct arena_block *block = mem_alloc(sizeof *block + in_size);
+	if (!block)
+	{
+		LOGE("could not allocate block of %zu bytes", in_size);
+		return NULL;
+	}
+	block->prev = in_prev;
+	block->size = in_size;
+	block->used = 0;
+	return block;
+}
+
+
+static void
+free_arena(void *in_arena)
+{
+	struct arena *arena = in_arena;
+	struct arena_block *block = arena->top;
+	while (block)
+	{
+		struct arena_block *prev = block->prev;
+		mem_free(block);
+		block = prev;
+	}
+	mem_free(arena);
+}
+
+
+static struct arena *
+get_arena(void)
+{
+	struct arena *arena = tss_get(l_key);
+	if (!arena)
+	{
+		arena = mem_calloc(1, sizeof *arena);
+		ASSERT(arena);
+		tss_set(l_key, arena);
+	}
+	return arena;
+}
+
+
+void
+arena_start(void)
+{
+	if (l_has_key)
+	{
+		return;
+	}
+	if (tss_create(&l_key, free_arena) != thrd_success)
+	{
+		LOGE("could not create thread-specific storage");
+		return;
+	}
+	l_has_key = true;
+}
+
+
+void
+arena_stop(void)
+{
+	if (!l_has_key)
+	{
+		return;
+	}
+	struct arena *arena = tss_get(l_key);
+	if (arena)
+	{
+		free_arena(arena);
+		tss_set(l_key, NULL);
+	}
+}
+
+
+struct arena_mark
+arena_mark(void)
+{
+	struct arena *arena = get_arena();
+	++arena->depth;
+	return (struct arena_mark){
+		.block = arena->top,
+		.used = arena->top ? arena->top->used : 0,
+	};
+}
+
+
+void
+arena_release(struct arena_mark in_mark)
+{
+	struct arena *arena = tss_get(l_key);
+	ASSERT(arena && arena->depth > 0);
+	--arena->depth;
+
+	// blocks added since the mark was taken
+	size_t freed = 0;
+	while (arena->top != in_mark.block)
+	{
+		struct arena_block *prev = arena->top->prev;
+		freed += arena->top->size;
+		mem_free(arena->top);
+		arena->top = prev;
+	}
+	if (arena->top)
+	{
+		arena->top->used = in_mark.used;
+	}
+
+	// once nothing is in use anymore, grow to the high-water mark,
+	// so that the next round fits into a single block
+	if (freed > 0 && arena->depth == 0)
+	{
+		size_t const size = freed + (arena->top ? arena->top->size : 0);
+		mem_free(arena->top);
+		arena->top = new_block(NULL, size);
+	}
+}
+
+
+void *
+arena_alloc(size_t in_bytes)
+{
+	size_t const bytes =
+	  (in_bytes + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+	struct arena *arena = tss_get(l_key);
+	ASSERT(arena && arena->depth > 0);
+	struct arena_block *top = arena->top;
+	if (!top || top->size - top->used < bytes)
+	{
+		size_t size = top ? top->size * 2 : ARENA_MIN_BLOCK;
+		while (size < bytes)
+		{
+			size *= 2;
+		}
+		struct arena_block *block = new_block(top, size);
+		if (!block)
+		{
+			return NULL;
+		}
+		top = arena->top = block;
+	}
+
+	void *ptr = (char *)(top + 1) + top->used;
+	top->used += bytes;
+	return ptr;
+}
+
+
+void *
+arena_calloc(size_t in_count, size_t in_bytes)
+{
+	if (in_bytes > 0 && in_count > SIZE_MAX / in_bytes)
+	{
+		return NULL;
+	}
+	void *ptr = arena_alloc(in_count * in_bytes);
+	if (ptr)
+	{
+		memset(ptr, 0, in_count * in_bytes);
+	}
+	return ptr;
+}
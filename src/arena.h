@@ -0,0 +1,99 @@
+// vi: filetype=c
+#pragma once
+#ifndef MINIMOD_ARENA_H_INCLUDED
+#define MINIMOD_ARENA_H_INCLUDED
+
+/* Title: arena
+ *
+ * Topic: Introduction
+ *
+ * Per-thread stack of memory for data that only lives while a response
+ * is handled, like the structs passed to callbacks.
+ *
+ * Allocations are released in bulk by going back to a <arena_mark>,
+ * taken before the allocations were made, thusly allocations can only
+ * be made while a mark is held. Marks nest, so that a callback can make
+ * allocations of its own while its caller's data is still in use.
+ *
+ * Memory is kept when released and reused by the next allocations of
+ * the same thread, thusly after the first few responses no more heap
+ * allocations are necessary.
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Section: API */
+
+/* Struct: arena_mark
+ *
+ * Position in the calling thread's arena, see <arena_mark()>.
+ */
+struct arena_mark
+{
+	void *block;
+	size_t used;
+};
+
+/* Function: arena_start()
+ *
+ * Set up thread-specific storage. Needs to be called before any of the
+ * other functions.
+ *
+ * Attention:
+ *	Not thread-safe.
+ */
+void
+arena_start(void);
+
+/* Function: arena_stop()
+ *
+ * Free the calling thread's arena. The arenas of other threads are freed
+ * when those threads exit.
+ */
+void
+arena_stop(void);
+
+/* Function: arena_mark()
+ *
+ * Returns:
+ *	The current position in the calling thread's arena, to be passed to
+ *	<arena_release()>.
+ */
+struct arena_mark
+arena_mark(void);
+
+/* Function: arena_release()
+ *
+ * Release everything allocated since *in_mark* was taken.
+ * Marks have to be released in the opposite order they were taken in.
+ */
+void
+arena_release(struct arena_mark in_mark);
+
+/* Function: arena_alloc()
+ *
+ * Like malloc(), with memory of the calling thread's arena.
+ * The memory is aligned to 16 bytes.
+ *
+ * Returns:
+ *	NULL if the heap is exhausted.
+ */
+void *
+arena_alloc(size_t in_bytes);
+
+/* Function: arena_calloc()
+ *
+ * Like calloc(), with memory of the calling thread's arena.
+ */
+void *
+arena_calloc(size_t in_count, size_t in_bytes);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,298 @@
+#include "jsonindex.h"
+
+#include <string.h>
+
+#if defined(MINIMOD_SIMD_ENABLE) && defined(__x86_64__)
+#define HAS_X86_SIMD
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+// CONFIG
+// ------
+#define BLOCK_SIZE 64
+
+
+// bit masks of a block, one bit per byte
+struct classes
+{
+	// brackets, braces, colons and commas
+	uint64_t ops;
+	uint64_t quotes;
+	uint64_t backslashes;
+};
+
+
+typedef struct classes (*classify_fn)(char const *in_block);
+
+
+// bit i of the result is set if byte i of *in_word* equals *in_c*
+static uint64_t
+swar_eq(uint64_t in_word, uint8_t in_c)
+{
+	uint64_t const low7 = 0x7f7f7f7f7f7f7f7full;
+	uint64_t const x = in_word ^ (0x0101010101010101ull * in_c);
+	// bit 7 of each byte is set if the byte is 0
+	uint64_t const zero = ~(((x & low7) + low7) | x | low7);
+	// gathers bit 7 of each byte into the top byte
+	return (zero >> 7) * 0x0102040810204080ull >> 56;
+}
+
+
+// 8 bytes at a time, within a general-purpose register
+static struct classes
+classify_scalar(char const *in_block)
+{
+	struct classes out = { 0 };
+	for (unsigned i = 0; i < BLOCK_SIZE; i += 8)
+	{
+		uint64_t word = 0;
+		for (unsigned k = 0; k < 8; ++k)
+		{
+			word |= (uint64_t)(uint8_t)in_block[i + k] << (k * 8);
+		}
+		// see classify_sse2()
+		uint64_t const folded = word | 0x2020202020202020ull;
+		out.ops |= (swar_eq(folded, '{') | swar_eq(folded, '}') |
+		             swar_eq(word, ':') | swar_eq(word, ','))
+		  << i;
+		out.quotes |= swar_eq(word, '"') << i;
+		out.backslashes |= swar_eq(word, '\\') << i;
+	}
+	return out;
+}
+
+
+static classify_fn l_classify = classify_scalar;
+
+
+#ifdef HAS_X86_SIMD
+// '[' and '{' as well as ']' and '}' only differ in bit 5, thusly setting
+// it finds both of them with a single comparison
+static struct classes
+classify_sse2(char const *in_block)
+{
+	__m128i const bit5 = _mm_set1_epi8(0x20);
+	__m128i const open = _mm_set1_epi8('{');
+	__m128i const close = _mm_set1_epi8('}');
+	__m128i const colon = _mm_set1_epi8(':');
+	__m128i const comma = _mm_set1_epi8(',');
+	__m128i const quote = _mm_set1_epi8('"');
+	__m128i const backslash = _mm_set1_epi8('\\');
+
+	struct classes out = { 0 };
+	for (unsigned i = 0; i < BLOCK_SIZE; i += 16)
+	{
+		__m128i const v = _mm_loadu_si128((__m128i const *)(in_block + i));
+		__m128i const folded = _mm_or_si128(v, bit5);
+		__m128i const ops = _mm_or_si128(
+		  _mm_or_si128(
+		    _mm_cmpeq_epi8(folded, open),
+		    _mm_cmpeq_epi8(folded, close)),
+		  _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+		out.ops |= (uint64_t)(uint16_t)_mm_movemask_epi8(ops) << i;
+		out.quotes |= (uint64_t)(uint16_t)_mm_movemask_epi8(
+		                _mm_cmpeq_epi8(v, quote))
+		  << i;
+		out.backslashes |= (uint64_t)(uint16_t)_mm_movemask_epi8(
+		                     _mm_cmpeq_epi8(v, backslash))
+		  << i;
+	}
+	return out;
+}
+
+
+// same as classify_sse2()
+__attribute__((target("avx2"))) static struct classes
+classify_avx2(char const *in_block)
+{
+	__m256i const bit5 = _mm256_set1_epi8(0x20);
+	__m256i const open = _mm256_set1_epi8('{');
+	__m256i const close = _mm256_set1_epi8('}');
+	__m256i const colon = _mm256_set1_epi8(':');
+	__m256i const comma = _mm256_set1_epi8(',');
+	__m256i const quote = _mm256_set1_epi8('"');
+	__m256i const backslash = _mm256_set1_epi8('\\');
+
+	struct classes out = { 0 };
+	for (unsigned i = 0; i < BLOCK_SIZE; i += 32)
+	{
+		__m256i const v =
+		  _mm256_loadu_si256((__m256i const *)(in_block + i));
+		__m256i const folded = _mm256_or_si256(v, bit5);
+		__m256i const ops = _mm256_or_si256(
+		  _mm256_or_si256(
+		    _mm256_cmpeq_epi8(folded, open),
+		    _mm256_cmpeq_epi8(folded, close)),
+		  _mm256_or_si256(
+		    _mm256_cmpeq_epi8(v, colon),
+		    _mm256_cmpeq_epi8(v, comma)));
+		out.ops |= (uint64_t)(uint32_t)_mm256_movemask_epi8(ops) << i;
+		out.quotes |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+		                _mm256_cmpeq_epi8(v, quote))
+		  << i;
+		out.backslashes |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+		                     _mm256_cmpeq_epi8(v, backslash))
+		  << i;
+	}
+	return out;
+}
+
+
+static bool
+has_avx2(void)
+{
+	unsigned a, b, c, d;
+	if (!__get_cpuid(1, &a, &b, &c, &d) || !(c & bit_OSXSAVE) ||
+	  !(c & bit_AVX))
+	{
+		return false;
+	}
+	// the OS has to save the upper halves of the registers
+	uint32_t xcr0, xcr0_high;
+	__asm__ volatile("xgetbv" : "=a"(xcr0), "=d"(xcr0_high) : "c"(0));
+	if ((xcr0 & 6) != 6)
+	{
+		return false;
+	}
+	return __get_cpuid_count(7, 0, &a, &b, &c, &d) && (b & bit_AVX2);
+}
+#endif
+
+
+// bit i is the parity of the bits 0 to i
+static uint64_t
+prefix_xor(uint64_t in_bits)
+{
+	in_bits ^= in_bits << 1;
+	in_bits ^= in_bits << 2;
+	in_bits ^= in_bits << 4;
+	in_bits ^= in_bits << 8;
+	in_bits ^= in_bits << 16;
+	in_bits ^= in_bits << 32;
+	return in_bits;
+}
+
+
+// marks the bytes following unescaped backslashes. backslashes are rare,
+// so they are visited one by one.
+static uint64_t
+find_escaped(uint64_t in_backslashes, uint64_t *io_escape)
+{
+	uint64_t escaped = *io_escape;
+	uint64_t backslashes = in_backslashes & ~escaped;
+	*io_escape = 0;
+	while (backslashes)
+	{
+		uint64_t const bit = backslashes & (~backslashes + 1);
+		uint64_t const next = bit << 1;
+		if (!next)
+		{
+			*io_escape = 1;
+		}
+		escaped |= next;
+		backslashes &= ~(bit | next);
+	}
+	return escaped;
+}
+
+
+enum jsonindex_isa
+jsonindex_start(void)
+{
+	if (jsonindex_use(JSONINDEX_AVX2))
+	{
+		return JSONINDEX_AVX2;
+	}
+	if (jsonindex_use(JSONINDEX_SSE2))
+	{
+		return JSONINDEX_SSE2;
+	}
+	jsonindex_use(JSONINDEX_SCALAR);
+	return JSONINDEX_SCALAR;
+}
+
+
+bool
+jsonindex_use(enum jsonindex_isa in_isa)
+{
+	if (in_isa == JSONINDEX_SCALAR)
+	{
+		l_classify = classify_scalar;
+		return true;
+	}
+#ifdef HAS_X86_SIMD
+	if (in_isa == JSONINDEX_SSE2)
+	{
+		l_classify = classify_sse2;
+		return true;
+	}
+	if (in_isa == JSONINDEX_AVX2 && has_avx2())
+	{
+		l_classify = classify_avx2;
+		return true;
+	}
+#endif
+	return false;
+}
+
+
+void
+jsonindex_init(
+  struct jsonindex *out_index,
+  char const *in_text,
+  size_t in_len)
+{
+	*out_index = (struct jsonindex){
+		.text = in_text,
+		.len = in_len,
+	};
+}
+
+
+size_t
+jsonindex_peek(struct jsonindex *in_index)
+{
+	struct jsonindex *index = in_index;
+	while (!index->mask)
+	{
+		if (index->next >= index->len)
+		{
+			return index->len;
+		}
+
+		struct classes classes;
+		size_t const left = index->len - index->next;
+		if (left >= BLOCK_SIZE)
+		{
+			classes = l_classify(index->text + index->next);
+		}
+		else
+		{
+			// spaces are not structural, so the padding yields nothing
+			char block[BLOCK_SIZE];
+			memset(block, ' ', sizeof block);
+			memcpy(block, index->text + index->next, left);
+			classes = l_classify(block);
+		}
+
+		uint64_t const escaped =
+		  find_escaped(classes.backslashes, &index->escape);
+		uint64_t const quotes = classes.quotes & ~escaped;
+		// set from each opening quote up to its closing quote
+		uint64_t const in_string = prefix_xor(quotes) ^ index->in_string;
+		index->in_string = 0 - (in_string >> 63);
+		index->mask = (classes.ops & ~in_string) | quotes;
+		index->next += BLOCK_SIZE;
+	}
+	return index->next - BLOCK_SIZE + (size_t)__builtin_ctzll(index->mask);
+}
+
+
+size_t
+jsonindex_next(struct jsonindex *in_index)
+{
+	size_t const pos = jsonindex_peek(in_index);
+	in_index->mask &= in_index->mask - 1;
+	return pos;
+}
@@ -0,0 +1,127 @@
+// vi: filetype=c
+#pragma once
+#ifndef MINIMOD_JSONINDEX_H_INCLUDED
+#define MINIMOD_JSONINDEX_H_INCLUDED
+
+/* Title: jsonindex
+ *
+ * Topic: Introduction
+ *
+ * Finds the structural characters of JSON text, that is brackets, braces,
+ * colons and commas outside of strings as well as the quotes delimiting
+ * strings, without looking at the text in between.
+ *
+ * The text is classified in blocks of 64 bytes, one bit per byte, with
+ * SSE2 or AVX2 if the build enables them (ENABLE_SIMD in the Makefile) and
+ * the CPU supports them, otherwise byte by byte. Strings are masked out
+ * with bit operations on the whole block, thusly the cost mostly depends
+ * on the number of blocks and structural characters, not on the length
+ * of the strings.
+ *
+ * The text is not validated. Malformed text yields some positions which
+ * are not meaningful, but never positions beyond the text.
+ */
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Section: API */
+
+/* Enum: jsonindex_isa
+ *
+ * Instruction set used to classify blocks.
+ *
+ * JSONINDEX_SCALAR - Byte by byte, available everywhere.
+ * JSONINDEX_SSE2 - 16 bytes at a time.
+ * JSONINDEX_AVX2 - 32 bytes at a time.
+ */
+enum jsonindex_isa
+{
+	JSONINDEX_SCALAR,
+	JSONINDEX_SSE2,
+	JSONINDEX_AVX2,
+};
+
+/* Struct: jsonindex
+ *
+ * Position within a text, see <jsonindex_init()>. The members are
+ * private.
+ */
+struct jsonindex
+{
+	char const *text;
+	size_t len;
+	// start of the next block to classify
+	size_t next;
+	// structural characters of the previous block not returned yet
+	uint64_t mask;
+	// all bits set if the previous block ended within a string
+	uint64_t in_string;
+	// 1 if the previous block ended with an unescaped backslash
+	uint64_t escape;
+};
+
+/* Function: jsonindex_start()
+ *
+ * Select the fastest instruction set which is enabled in the build and
+ * supported by the CPU.
+ *
+ * Attention:
+ *	Not thread-safe. Do not call it while texts are indexed.
+ *
+ * Returns:
+ *	The instruction set selected.
+ */
+enum jsonindex_isa
+jsonindex_start(void);
+
+/* Function: jsonindex_use()
+ *
+ * Select *in_isa*, to compare the instruction sets with each other.
+ * Same restrictions as <jsonindex_start()>.
+ *
+ * Returns:
+ *	false if *in_isa* is not available, the selection is kept then.
+ */
+bool
+jsonindex_use(enum jsonindex_isa in_isa);
+
+/* Function: jsonindex_init()
+ *
+ * Start indexing *in_text*, which has to stay valid while *out_index*
+ * is used.
+ */
+void
+jsonindex_init(
+  struct jsonindex *out_index,
+  char const *in_text,
+  size_t in_len);
+
+/* Function: jsonindex_peek()
+ *
+ * Returns:
+ *	The position of the next structural character, without moving past
+ *	it, or the length of the text if there is none.
+ */
+size_t
+jsonindex_peek(struct jsonindex *in_index);
+
+/* Function: jsonindex_next()
+ *
+ * Like <jsonindex_peek()>, but moves past the character.
+ */
+size_t
+jsonindex_next(struct jsonindex *in_index);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,505 @@
+#include "jsontree.h"
+
+#include "arena.h"
+#include "jsonindex.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// CONFIG
+// ------
+// text nested deeper is left to QAJ4C_parse_opt()
+#define JSONTREE_MAX_DEPTH 64
+// bytes of text per container initially expected, there is room for more
+// once those are used up
+#define JSONTREE_BYTES_PER_CONTAINER 128
+
+
+struct tree
+{
+	struct jsonindex index;
+	// the copy within the buffer, modified while the tree is built
+	char *text;
+	size_t len;
+	// values within each object and array, in the order of their opening
+	// brackets
+	uint32_t *counts;
+	size_t ncounts;
+	size_t capacity;
+	QAJ4C_Builder builder;
+};
+
+
+static bool
+is_space(char in_c)
+{
+	return in_c == ' ' || in_c == '\n' || in_c == '\r' || in_c == '\t';
+}
+
+
+static size_t
+skip_space(struct tree const *in_tree, size_t in_pos)
+{
+	while (in_pos < in_tree->len && is_space(in_tree->text[in_pos]))
+	{
+		++in_pos;
+	}
+	return in_pos;
+}
+
+
+// the previous counts are left in the arena, which at most doubles the
+// memory used
+static bool
+grow_counts(struct tree *io_tree)
+{
+	size_t const capacity = io_tree->capacity * 2;
+	uint32_t *counts = arena_alloc(capacity * sizeof *counts);
+	if (!counts)
+	{
+		return false;
+	}
+	memcpy(counts, io_tree->counts, io_tree->ncounts * sizeof *counts);
+	io_tree->counts = counts;
+	io_tree->capacity = capacity;
+	return true;
+}
+
+
+// first pass, fills tree.counts
+static bool
+count_values(struct tree *io_tree)
+{
+	// of the containers entered, their index in counts
+	size_t stack[JSONTREE_MAX_DEPTH];
+	size_t depth = 0;
+	struct jsonindex index;
+	jsonindex_init(&index, io_tree->text, io_tree->len);
+	size_t last = 0;
+	for (size_t pos; (pos = jsonindex_next(&index)) < io_tree->len;
+	     last = pos)
+	{
+		char const c = io_tree->text[pos];
+		if (c == '{' || c == '[')
+		{
+			if (depth == JSONTREE_MAX_DEPTH ||
+			  (io_tree->ncounts == io_tree->capacity && !grow_counts(io_tree)))
+			{
+				return false;
+			}
+			stack[depth++] = io_tree->ncounts;
+			io_tree->counts[io_tree->ncounts++] = 0;
+		}
+		else if (c == ',' && depth > 0)
+		{
+			++io_tree->counts[stack[depth - 1]];
+		}
+		else if (c == '}' || c == ']')
+		{
+			if (depth == 0)
+			{
+				return false;
+			}
+			uint32_t *count = &io_tree->counts[stack[--depth]];
+			// the value after the last comma, unless there is none at all.
+			// only a scalar leaves no structural character of its own.
+			char const prev = io_tree->text[last];
+			bool const empty = (prev == '{' || prev == '[') &&
+			  skip_space(io_tree, last + 1) == pos;
+			*count += !empty;
+		}
+	}
+	return depth == 0;
+}
+
+
+// moves past the next structural character, which has to be *in_c* and
+// the first after *in_from* apart from space
+static bool
+take(struct tree *io_tree, size_t in_from, char in_c, size_t *out_pos)
+{
+	size_t const pos = jsonindex_next(&io_tree->index);
+	*out_pos = pos;
+	return pos < io_tree->len && io_tree->text[pos] == in_c &&
+	  skip_space(io_tree, in_from) == pos;
+}
+
+
+static bool
+parse_hex(char const *in_text, char const *in_end, uint32_t *out_code)
+{
+	if (in_end - in_text < 4)
+	{
+		return false;
+	}
+	uint32_t code = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		char const c = in_text[i];
+		uint32_t const digit = c >= '0' && c <= '9' ? (uint32_t)(c - '0')
+		  : c >= 'a' && c <= 'f'                   ? (uint32_t)(c - 'a' + 10)
+		  : c >= 'A' && c <= 'F'                   ? (uint32_t)(c - 'A' + 10)
+		                                           : 16;
+		if (digit == 16)
+		{
+			return false;
+		}
+		code = code << 4 | digit;
+	}
+	*out_code = code;
+	return true;
+}
+
+
+static char *
+put_utf8(char *out, uint32_t in_code)
+{
+	if (in_code < 0x80)
+	{
+		*out++ = (char)in_code;
+	}
+	else if (in_code < 0x800)
+	{
+		*out++ = (char)(0xc0 | in_code >> 6);
+		*out++ = (char)(0x80 | (in_code & 0x3f));
+	}
+	else if (in_code < 0x10000)
+	{
+		*out++ = (char)(0xe0 | in_code >> 12);
+		*out++ = (char)(0x80 | (in_code >> 6 & 0x3f));
+		*out++ = (char)(0x80 | (in_code & 0x3f));
+	}
+	else
+	{
+		*out++ = (char)(0xf0 | in_code >> 18);
+		*out++ = (char)(0x80 | (in_code >> 12 & 0x3f));
+		*out++ = (char)(0x80 | (in_code >> 6 & 0x3f));
+		*out++ = (char)(0x80 | (in_code & 0x3f));
+	}
+	return out;
+}
+
+
+// unescapes *in_len* bytes in place, which never makes them longer, and
+// terminates them
+static bool
+unescape(char *io_text, size_t in_len)
+{
+	char const *in = memchr(io_text, '\\', in_len);
+	char const *const end = io_text + in_len;
+	char *out = in ? io_text + (in - io_text) : io_text + in_len;
+	while (in && in < end)
+	{
+		char const c = *in++;
+		if (c != '\\')
+		{
+			*out++ = c;
+			continue;
+		}
+		if (in == end)
+		{
+			return false;
+		}
+		uint32_t code;
+		switch (*in++)
+		{
+		case '"':
+		case '\\':
+		case '/':
+			*out++ = in[-1];
+			break;
+		case 'b':
+			*out++ = '\b';
+			break;
+		case 'f':
+			*out++ = '\f';
+			break;
+		case 'n':
+			*out++ = '\n';
+			break;
+		case 'r':
+			*out++ = '\r';
+			break;
+		case 't':
+			*out++ = '\t';
+			break;
+		case 'u':
+			if (!parse_hex(in, end, &code))
+			{
+				return false;
+			}
+			in += 4;
+			uint32_t low;
+			// a surrogate pair, escaped one by one
+			if (code >= 0xd800 && code < 0xdc00 && end - in >= 6 &&
+			  in[0] == '\\' && in[1] == 'u' && parse_hex(in + 2, end, &low) &&
+			  low >= 0xdc00 && low < 0xe000)
+			{
+				code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+				in += 6;
+			}
+			out = put_utf8(out, code);
+			break;
+		default:
+			return false;
+		}
+	}
+	*out = '\0';
+	return true;
+}
+
+
+// the string's opening quote at *in_open* was moved past already. the
+// string is unescaped in place and terminated instead of its closing quote.
+static char const *
+build_string(struct tree *io_tree, size_t in_open, size_t *out_end)
+{
+	size_t const close = jsonindex_next(&io_tree->index);
+	if (close >= io_tree->len || io_tree->text[close] != '"')
+	{
+		return NULL;
+	}
+	char *string = io_tree->text + in_open + 1;
+	if (!unescape(string, close - in_open - 1))
+	{
+		return NULL;
+	}
+	*out_end = close + 1;
+	return string;
+}
+
+
+static bool
+match(struct tree const *in_tree, size_t in_pos, char const *in_word)
+{
+	size_t const len = strlen(in_word);
+	return in_tree->len - in_pos >= len &&
+	  0 == memcmp(in_tree->text + in_pos, in_word, len);
+}
+
+
+// numbers, true, false and null, which are no structural characters
+static bool
+build_scalar(
+  struct tree *io_tree,
+  size_t in_pos,
+  QAJ4C_Value *out_value,
+  size_t *out_end)
+{
+	char const *start = io_tree->text + in_pos;
+	if (match(io_tree, in_pos, "true") || match(io_tree, in_pos, "false"))
+	{
+		QAJ4C_set_bool(out_value, *start == 't');
+		*out_end = in_pos + (*start == 't' ? 4 : 5);
+		return true;
+	}
+	if (match(io_tree, in_pos, "null"))
+	{
+		QAJ4C_set_null(out_value);
+		*out_end = in_pos + 4;
+		return true;
+	}
+
+	size_t const len = strspn(start, "+-.0123456789eE");
+	if (len == 0 || (*start != '-' && (*start < '0' || *start > '9')))
+	{
+		return false;
+	}
+	// the copy of the text is terminated, thusly strto*() stop in time
+	char *end;
+	errno = 0;
+	if (memchr(start, '.', len) || memchr(start, 'e', len) ||
+	  memchr(start, 'E', len))
+	{
+		QAJ4C_set_double(out_value, strtod(start, &end));
+	}
+	else if (*start == '-')
+	{
+		QAJ4C_set_int64(out_value, strtoll(start, &end, 10));
+	}
+	else
+	{
+		QAJ4C_set_uint64(out_value, strtoull(start, &end, 10));
+	}
+	// integers too large for 64 bits
+	if (errno == ERANGE)
+	{
+		QAJ4C_set_double(out_value, strtod(start, &end));
+	}
+	*out_end = (size_t)(end - io_tree->text);
+	return end == start + len;
+}
+
+
+static bool
+build_value(
+  struct tree *io_tree,
+  size_t in_from,
+  QAJ4C_Value *out_value,
+  size_t *out_end);
+
+
+static bool
+build_object(
+  struct tree *io_tree,
+  size_t in_open,
+  QAJ4C_Value *out_value,
+  size_t *out_end)
+{
+	uint32_t const count = io_tree->counts[io_tree->ncounts++];
+	QAJ4C_set_object(out_value, count, &io_tree->builder);
+	size_t from = in_open + 1;
+	size_t pos;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		char const *key;
+		if (!take(io_tree, from, '"', &pos) ||
+		  !(key = build_string(io_tree, pos, &from)) ||
+		  !take(io_tree, from, ':', &pos))
+		{
+			return false;
+		}
+		QAJ4C_Value *value = QAJ4C_object_create_member_by_ref(out_value, key);
+		if (!build_value(io_tree, pos + 1, value, &from) ||
+		  !take(io_tree, from, i + 1 < count ? ',' : '}', &pos))
+		{
+			return false;
+		}
+		from = pos + 1;
+	}
+	if (count == 0 && !take(io_tree, from, '}', &pos))
+	{
+		return false;
+	}
+	// sorts the members like QAJ4C_parse_opt(), for lookups by bisection
+	QAJ4C_object_optimize(out_value);
+	*out_end = pos + 1;
+	return true;
+}
+
+
+static bool
+build_array(
+  struct tree *io_tree,
+  size_t in_open,
+  QAJ4C_Value *out_value,
+  size_t *out_end)
+{
+	uint32_t const count = io_tree->counts[io_tree->ncounts++];
+	QAJ4C_set_array(out_value, count, &io_tree->builder);
+	size_t from = in_open + 1;
+	size_t pos;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		QAJ4C_Value *value = QAJ4C_array_get_rw(out_value, i);
+		if (!build_value(io_tree, from, value, &from) ||
+		  !take(io_tree, from, i + 1 < count ? ',' : ']', &pos))
+		{
+			return false;
+		}
+		from = pos + 1;
+	}
+	if (count == 0 && !take(io_tree, from, ']', &pos))
+	{
+		return false;
+	}
+	*out_end = pos + 1;
+	return true;
+}
+
+
+// builds the value following *in_from*, *out_end* is set past it. the
+// depth is limited by count_values().
+static bool
+build_value(
+  struct tree *io_tree,
+  size_t in_from,
+  QAJ4C_Value *out_value,
+  size_t *out_end)
+{
+	size_t const pos = skip_space(io_tree, in_from);
+	if (pos >= io_tree->len)
+	{
+		return false;
+	}
+	char const c = io_tree->text[pos];
+	if (c != '"' && c != '{' && c != '[')
+	{
+		return build_scalar(io_tree, pos, out_value, out_end);
+	}
+	if (jsonindex_next(&io_tree->index) != pos)
+	{
+		return false;
+	}
+	if (c == '{')
+	{
+		return build_object(io_tree, pos, out_value, out_end);
+	}
+	if (c == '[')
+	{
+		return build_array(io_tree, pos, out_value, out_end);
+	}
+	char const *string = build_string(io_tree, pos, out_end);
+	if (string)
+	{
+		QAJ4C_set_string_ref(out_value, string);
+	}
+	return string != NULL;
+}
+
+
+size_t
+jsontree_buffer_size(char const *in_text, size_t in_len)
+{
+	return QAJ4C_calculate_max_buffer_size_n(in_text, in_len) + in_len + 1;
+}
+
+
+QAJ4C_Value const *
+jsontree_parse(
+  char const *in_text,
+  size_t in_len,
+  void *out_buffer,
+  size_t in_size)
+{
+	// the tree in front, the copy of the text behind it
+	size_t const ntree = in_size - in_len - 1;
+	struct tree tree = {
+		.text = (char *)out_buffer + ntree,
+		.len = in_len,
+	};
+	memcpy(tree.text, in_text, in_len);
+	tree.text[in_len] = '\0';
+
+	struct arena_mark const mark = arena_mark();
+	tree.capacity = in_len / JSONTREE_BYTES_PER_CONTAINER + 16;
+	tree.counts = in_len <= UINT32_MAX
+	  ? arena_alloc(tree.capacity * sizeof *tree.counts)
+	  : NULL;
+	QAJ4C_Value *root = NULL;
+	if (tree.counts && count_values(&tree))
+	{
+		QAJ4C_builder_init(&tree.builder, out_buffer, ntree);
+		root = QAJ4C_builder_get_document(&tree.builder);
+		jsonindex_init(&tree.index, tree.text, in_len);
+		tree.ncounts = 0;
+		size_t end;
+		if (!build_value(&tree, 0, root, &end) ||
+		  skip_space(&tree, end) != in_len)
+		{
+			root = NULL;
+		}
+	}
+	arena_release(mark);
+	if (root)
+	{
+		return root;
+	}
+
+	QAJ4C_Value const *document = NULL;
+	QAJ4C_parse_opt(in_text, in_len, 0, out_buffer, ntree, &document);
+	return document;
+}
@@ -0,0 +1,73 @@
+// vi: filetype=c
+#pragma once
+#ifndef MINIMOD_JSONTREE_H_INCLUDED
+#define MINIMOD_JSONTREE_H_INCLUDED
+
+/* Title: jsontree
+ *
+ * Topic: Introduction
+ *
+ * Builds the same tree of values as QAJ4C_parse_opt(), but walks the
+ * structural characters found by <jsonindex> instead of every byte, and
+ * builds the tree with the builder functions of qajson4c.
+ *
+ * The text is copied into the end of the buffer once. Strings are
+ * unescaped within the copy and terminated in place of their closing
+ * quote, thusly the tree refers to them instead of copying each.
+ *
+ * Containers are counted in a first pass over the structural characters,
+ * since qajson4c needs the size of an object or array before its members
+ * are added. The counts are kept in the calling thread's arena, see
+ * arena.h.
+ */
+
+#pragma GCC diagnostic push
+#ifdef __clang__
+#pragma GCC diagnostic ignored "-Wdocumentation"
+#endif
+#include "qajson4c/src/qajson4c/qajson4c.h"
+#pragma GCC diagnostic pop
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Section: API */
+
+/* Function: jsontree_buffer_size()
+ *
+ * Returns:
+ *	The size of the buffer <jsontree_parse()> needs for *in_text*.
+ */
+size_t
+jsontree_buffer_size(char const *in_text, size_t in_len);
+
+/* Function: jsontree_parse()
+ *
+ * Like QAJ4C_parse_opt() without options. Text which is not valid JSON
+ * is passed on to QAJ4C_parse_opt() after all, so that errors are
+ * reported the same way.
+ *
+ * Parameters:
+ *	out_buffer - Of <jsontree_buffer_size()> bytes at least, aligned like
+ *		the buffers passed to QAJ4C_parse_opt(). The tree is valid as
+ *		long as the buffer is.
+ *
+ * Attention:
+ *	Needs <jsonindex_start()> and <arena_start()>, and an arena mark
+ *	held by the calling thread.
+ */
+QAJ4C_Value const *
+jsontree_parse(
+  char const *in_text,
+  size_t in_len,
+  void *out_buffer,
+  size_t in_size);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
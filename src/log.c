@@ -0,0 +1,329 @@
+#include "log.h"
+
+#include "util.h"
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define UNUSED(X) __pragma(warning(suppress : 4100)) X
+#else
+#define UNUSED(X) __attribute__((unused)) X
+#endif
+
+// CONFIG
+// ------
+// number of messages that can be queued. needs to be a power of two.
+#define LOG_CAPACITY 256
+// longer messages are truncated
+#define LOG_MAX_TEXT 240
+
+#ifdef MINIMOD_LOG_ENABLE
+enum minimod_loglevel log_level = MINIMOD_LOGLEVEL_DEBUG;
+#else
+enum minimod_loglevel log_level = MINIMOD_LOGLEVEL_ERROR;
+#endif
+
+
+// slot i of the ring is used by positions i, i + LOG_CAPACITY, ...
+// *sequence* tells whose turn it is, relative to i so that a
+// zero-initialized ring is ready to use:
+// - sequence + i == position: free for the producer of *position*
+// - sequence + i == position + 1: filled, ready for the consumer
+struct log_slot
+{
+	uint64_t sequence;
+	uint64_t time;
+	char const *module;
+	enum minimod_loglevel level;
+	char text[LOG_MAX_TEXT];
+	char _padding[4];
+};
+
+
+struct log
+{
+	struct log_slot slots[LOG_CAPACITY];
+	// next position to write, shared by all producers
+	uint64_t tail;
+	// next position to read, only used by the consumer
+	uint64_t head;
+	// messages which did not fit into the ring
+	uint64_t ndropped;
+	minimod_log_callback callback;
+	void *userdata;
+	thrd_t thread;
+	// the logging thread waits on *wake* while the ring is empty. both
+	// are kept once created, since producers may still signal after
+	// log_stop().
+	mtx_t mtx;
+	cnd_t wake;
+	bool running;
+	// set by the logging thread before it waits, so that producers only
+	// signal *wake* when needed
+	bool waiting;
+	bool has_wake;
+	char _padding[5];
+};
+static struct log l_log;
+
+
+static void
+print_message(
+  void *UNUSED(in_userdata),
+  struct minimod_log_message const *in_message)
+{
+	FILE *out =
+	  in_message->level <= MINIMOD_LOGLEVEL_WARNING ? stderr : stdout;
+	fprintf(out, "[%s] %s\n", in_message->module, in_message->text);
+}
+
+
+static void
+deliver(struct log_slot const *in_slot)
+{
+	struct minimod_log_message const message = {
+		.time = in_slot->time,
+		.module = in_slot->module,
+		.text = in_slot->text,
+		.level = in_slot->level,
+	};
+	if (l_log.callback)
+	{
+		l_log.callback(l_log.userdata, &message);
+	}
+	else
+	{
+		print_message(NULL, &message);
+	}
+}
+
+
+static void
+format(
+  struct log_slot *out_slot,
+  enum minimod_loglevel in_level,
+  char const *in_module,
+  char const *in_format,
+  va_list in_args)
+{
+	out_slot->time = sys_nanoseconds();
+	out_slot->module = in_module;
+	out_slot->level = in_level;
+	vsnprintf(out_slot->text, sizeof out_slot->text, in_format, in_args);
+}
+
+
+void
+log_write(
+  enum minimod_loglevel in_level,
+  char const *in_module,
+  char const *in_format,
+  ...)
+{
+	va_list args;
+	va_start(args, in_format);
+
+	// without logging thread, deliver right away
+	if (!__atomic_load_n(&l_log.running, __ATOMIC_ACQUIRE))
+	{
+		struct log_slot slot;
+		format(&slot, in_level, in_module, in_format, args);
+		va_end(args);
+		deliver(&slot);
+		return;
+	}
+
+	// claim a position
+	uint64_t pos = __atomic_load_n(&l_log.tail, __ATOMIC_RELAXED);
+	struct log_slot *slot;
+	for (;;)
+	{
+		uint64_t const index = pos & (LOG_CAPACITY - 1);
+		slot = &l_log.slots[index];
+		uint64_t const seq =
+		  __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) + index;
+		if (seq == pos)
+		{
+			if (__atomic_compare_exchange_n(
+			      &l_log.tail,
+			      &pos,
+			      pos + 1,
+			      true,
+			      __ATOMIC_RELAXED,
+			      __ATOMIC_RELAXED))
+			{
+				break;
+			}
+		}
+		else if (seq < pos)
+		{
+			// the consumer did not get to this slot yet: ring is full
+			__atomic_fetch_add(&l_log.ndropped, 1, __ATOMIC_RELAXED);
+			va_end(args);
+			return;
+		}
+		else
+		{
+			pos = __atomic_load_n(&l_log.tail, __ATOMIC_RELAXED);
+		}
+	}
+
+	format(slot, in_level, in_module, in_format, args);
+	va_end(args);
+	uint64_t const index = pos & (LOG_CAPACITY - 1);
+	// sequentially consistent, so that either this sees the logging
+	// thread waiting, or the logging thread sees the message
+	__atomic_store_n(&slot->sequence, pos + 1 - index, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&l_log.waiting, __ATOMIC_SEQ_CST))
+	{
+		mtx_lock(&l_log.mtx);
+		cnd_signal(&l_log.wake);
+		mtx_unlock(&l_log.mtx);
+	}
+}
+
+
+// delivers all queued messages. returns false if there were none.
+static bool
+drain(void)
+{
+	bool delivered = false;
+	for (;;)
+	{
+		uint64_t const pos = l_log.head;
+		uint64_t const index = pos & (LOG_CAPACITY - 1);
+		struct log_slot *slot = &l_log.slots[index];
+		uint64_t const seq =
+		  __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) + index;
+		if (seq != pos + 1)
+		{
+			break;
+		}
+		deliver(slot);
+		__atomic_store_n(
+		  &slot->sequence,
+		  pos + LOG_CAPACITY - index,
+		  __ATOMIC_RELEASE);
+		l_log.head = pos + 1;
+		delivered = true;
+	}
+
+	uint64_t const ndropped =
+	  __atomic_exchange_n(&l_log.ndropped, 0, __ATOMIC_RELAXED);
+	if (ndropped > 0)
+	{
+		struct log_slot slot = {
+			.time = sys_nanoseconds(),
+			.module = "log",
+			.level = MINIMOD_LOGLEVEL_WARNING,
+		};
+		snprintf(
+		  slot.text,
+		  sizeof slot.text,
+		  "%" PRIu64 " messages dropped",
+		  ndropped);
+		deliver(&slot);
+	}
+
+	return delivered;
+}
+
+
+// whether a message or a count of dropped ones is waiting at the head
+static bool
+is_pending(void)
+{
+	uint64_t const pos = l_log.head;
+	uint64_t const index = pos & (LOG_CAPACITY - 1);
+	uint64_t const seq =
+	  __atomic_load_n(&l_log.slots[index].sequence, __ATOMIC_SEQ_CST) +
+	  index;
+	return seq == pos + 1 ||
+	  __atomic_load_n(&l_log.ndropped, __ATOMIC_RELAXED) > 0;
+}
+
+
+static int
+run(void *UNUSED(in_userdata))
+{
+	while (__atomic_load_n(&l_log.running, __ATOMIC_ACQUIRE))
+	{
+		if (drain())
+		{
+			continue;
+		}
+		// producers signal only while *waiting* is set, hence the ring is
+		// checked once more after setting it. *mtx* is held until the
+		// wait starts, so that no signal falls in between.
+		mtx_lock(&l_log.mtx);
+		__atomic_store_n(&l_log.waiting, true, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&l_log.running, __ATOMIC_ACQUIRE) &&
+		  !is_pending())
+		{
+			cnd_wait(&l_log.wake, &l_log.mtx);
+		}
+		__atomic_store_n(&l_log.waiting, false, __ATOMIC_RELAXED);
+		mtx_unlock(&l_log.mtx);
+	}
+	return 0;
+}
+
+
+void
+log_start(void)
+{
+	if (l_log.running)
+	{
+		return;
+	}
+	if (!l_log.has_wake)
+	{
+		mtx_init(&l_log.mtx, mtx_plain);
+		cnd_init(&l_log.wake);
+		l_log.has_wake = true;
+	}
+	__atomic_store_n(&l_log.running, true, __ATOMIC_RELEASE);
+	if (thrd_create(&l_log.thread, run, NULL) != thrd_success)
+	{
+		__atomic_store_n(&l_log.running, false, __ATOMIC_RELEASE);
+	}
+}
+
+
+void
+log_stop(void)
+{
+	if (!l_log.running)
+	{
+		return;
+	}
+	__atomic_store_n(&l_log.running, false, __ATOMIC_RELEASE);
+	mtx_lock(&l_log.mtx);
+	cnd_signal(&l_log.wake);
+	mtx_unlock(&l_log.mtx);
+	thrd_join(l_log.thread, NULL);
+	// whatever was queued after the thread's last round
+	drain();
+}
+
+
+void
+log_configure(
+  enum minimod_loglevel in_level,
+  minimod_log_callback in_callback,
+  void *in_userdata)
+{
+	// the logging thread is the only one calling the callback.
+	// pause it, so that it never sees a half-changed callback.
+	bool const was_running = l_log.running;
+	log_stop();
+	l_log.callback = in_callback;
+	l_log.userdata = in_userdata;
+	__atomic_store_n(&log_level, in_level, __ATOMIC_RELAXED);
+	if (was_running)
+	{
+		log_start();
+	}
+}
@@ -0,0 +1,102 @@
+// vi: filetype=c
+#pragma once
+#ifndef MINIMOD_LOG_H_INCLUDED
+#define MINIMOD_LOG_H_INCLUDED
+
+/* Title: log
+ *
+ * Topic: Introduction
+ *
+ * Backend of the LOG()/LOGE() macros of minimod's source files.
+ *
+ * Messages are formatted by the thread logging them and put into a
+ * lock-free ring buffer, which is emptied by a background thread that
+ * passes them on to the <minimod_log_callback()>.
+ *
+ * The level check happens in the macros, so a disabled level costs a
+ * load and a branch and its arguments are not evaluated.
+ */
+
+#include "minimod/minimod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Variable: log_level
+ *
+ * Least severe level that is logged. Read it with relaxed atomics only.
+ */
+extern enum minimod_loglevel log_level;
+
+#pragma GCC diagnostic push
+#ifdef __clang__
+#pragma GCC diagnostic ignored "-Wgnu-zero-variadic-macro-arguments"
+#endif
+
+#define LOG_AT(in_level, in_module, FMT, ...)                              \
+	do                                                                     \
+	{                                                                      \
+		if (__builtin_expect(                                              \
+		      __atomic_load_n(&log_level, __ATOMIC_RELAXED) >= (in_level), \
+		      0))                                                          \
+		{                                                                  \
+			log_write(in_level, in_module, FMT, ##__VA_ARGS__);            \
+		}                                                                  \
+	} while (__LINE__ == -1)
+
+#define LOG_DEBUG(in_module, FMT, ...) \
+	LOG_AT(MINIMOD_LOGLEVEL_DEBUG, in_module, FMT, ##__VA_ARGS__)
+#define LOG_ERROR(in_module, FMT, ...) \
+	LOG_AT(MINIMOD_LOGLEVEL_ERROR, in_module, FMT, ##__VA_ARGS__)
+
+#pragma GCC diagnostic pop
+
+/* Section: API */
+
+/* Function: log_write()
+ *
+ * Queue a message. Use the macros instead, which check the level first.
+ *
+ * Parameters:
+ *	in_module - Only the pointer is stored, thusly it has to be
+ *		a string literal.
+ */
+void
+log_write(
+  enum minimod_loglevel in_level,
+  char const *in_module,
+  char const *in_format,
+  ...) __attribute__((format(printf, 3, 4)));
+
+/* Function: log_configure()
+ *
+ * Implementation of <minimod_set_log()>.
+ */
+void
+log_configure(
+  enum minimod_loglevel in_level,
+  minimod_log_callback in_callback,
+  void *in_userdata);
+
+/* Function: log_start()
+ *
+ * Start the thread delivering queued messages.
+ * Until then messages are delivered right away by the logging thread.
+ */
+void
+log_start(void);
+
+/* Function: log_stop()
+ *
+ * Stop the thread started by <log_start()>, after it delivered all
+ * messages queued so far.
+ */
+void
+log_stop(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -1,8 +1,18 @@
 #include "minimod/minimod.h"
 #undef minimod_init
 
+#include "arena.h"
+#include "jsonindex.h"
+#include "jsontree.h"
+#include "modindex.h"
 #include "netw/netw.h"
+#include "trace.h"
+#include "transport.h"
+#include "trash.h"
+#include "log.h"
 #include "util.h"
+#include "watch.h"
+#include "zipfs.h"
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wpadded"
@@ -19,8 +29,10 @@
 #include <ctype.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #if defined(_MSC_VER) && !defined(__clang__)
 #define UNUSED(X) __pragma(warning(suppress : 4100)) X
@@ -34,19 +46,17 @@
 #endif
 #pragma GCC diagnostic ignored "-Wunused-macros"
 
-#ifdef MINIMOD_LOG_ENABLE
-#define LOG(FMT, ...) printf("[minimod] " FMT "\n", ##__VA_ARGS__)
-#else
-#define LOG(...)
-#endif
-#define LOGE(FMT, ...) fprintf(stderr, "[minimod] " FMT "\n", ##__VA_ARGS__)
+#define LOG(FMT, ...) LOG_DEBUG("minimod", FMT, ##__VA_ARGS__)
+#define LOGE(FMT, ...) LOG_ERROR("minimod", FMT, ##__VA_ARGS__)
+// bypasses the queue, since the process stops right after
+#define LOGA(FMT, ...) fprintf(stderr, "[minimod] " FMT "\n", ##__VA_ARGS__)
 
 #define ASSERT(in_condition)                      \
 	do                                            \
 	{                                             \
 		if (__builtin_expect(!(in_condition), 0)) \
 		{                                         \
-			LOGE(                                 \
+			LOGA(                                 \
 			  "[assertion] %s:%i: '%s'",          \
 			  __FILE__,                           \
 			  __LINE__,                           \
@@ -61,6 +71,29 @@
 // CONFIG
 // ------
 #define DEFAULT_ROOT "_minimod"
+// number of hosts remembered in <root>/hosts
+#define MAX_KNOWN_HOSTS 8
+// seconds until a remembered host is dropped again
+#define HOSTS_TTL (7 * 24 * 60 * 60)
+// number of finished tasks kept for reuse by later requests
+#define MAX_FREE_TASKS 64
+// number of released documents kept for reuse by later responses
+#define MAX_FREE_DOCUMENTS 32
+// released documents larger than this are freed instead of kept
+#define MAX_FREE_DOCUMENT_SIZE (2 * 1024 * 1024)
+// slots of the key lookup in populate_*(), more than any object has fields
+#define SCHEMA_SLOT_BITS 5
+#define SCHEMA_SLOTS (1 << SCHEMA_SLOT_BITS)
+// identifies manifests written by this version, in the host's byte order.
+// others are ignored and the mods indexed anew.
+#define MANIFEST_MAGIC 0x324d4d4du
+// directories modified less than this many seconds before they are listed
+// are listed again by the next minimod_init(), as file systems record the
+// modification time this coarsely
+#define MTIME_RESOLUTION 2
+// gzip responses which claim to inflate to more than this many times their
+// size are not allocated up front, but grown while inflating
+#define GZIP_MAX_RATIO 64
 
 
 struct callback
@@ -69,6 +102,7 @@ struct callback
 	{
 		minimod_get_games_callback get_games;
 		minimod_get_mods_callback get_mods;
+		minimod_get_mods_columns_callback get_mods_columns;
 		minimod_email_request_callback email_request;
 		minimod_access_token_callback access_token;
 		minimod_get_users_callback get_users;
@@ -87,15 +121,50 @@ struct callback
 enum task_flag
 {
 	TASK_FLAG_AUTH_TOKEN = 1,
+	// mods are delivered to callback.fptr.get_mods_columns
+	TASK_FLAG_COLUMNS = 2,
+	// lists are delivered in one go regardless of l_batch_size, for
+	// minimod's own requests
+	TASK_FLAG_NO_BATCHES = 4,
 };
 
 
+// same signature as netw's request callback
+typedef void (*response_handler)(
+  void *udata,
+  void const *data,
+  size_t len,
+  int error,
+  struct netw_header const *header);
+
+
 struct task
 {
 	struct callback callback;
+	response_handler handler;
 	uint64_t meta64;
+	// sys_nanoseconds() when the request was issued
+	uint64_t issued;
 	int32_t meta32;
 	uint32_t flags;
+	enum minimod_endpoint endpoint;
+	char _padding[4];
+	// next in l_mmi.free_tasks, while not in use
+	struct task *next_free;
+};
+
+
+// parsed JSON of a response, referenced by the handler while the callback
+// runs and by clients through minimod_retain(). the parser's buffer
+// follows the header.
+struct document
+{
+	// in l_mmi.free_documents while not referenced
+	struct document *next;
+	size_t size;
+	size_t refs;
+	// keeps the buffer 16-byte aligned
+	char _padding[8];
 };
 
 
@@ -105,56 +174,366 @@ struct install_request
 	void *userdata;
 	uint64_t game_id;
 	uint64_t mod_id;
+	// the staged zip, see publish()
 	char *zip_path;
 	FILE *file;
 	struct install_request *next;
+	uint64_t issued;
+	// added to l_mmi.installed once the mod is published
+	uint64_t modfile_id;
+	uint64_t date_updated;
+	uint64_t filesize;
+	char *name;
 	int waiting;
 	char _padding[4];
 };
 
 
+// files of an installed mod, the flags of its entry in l_mmi.installed
+enum installed_flag
+{
+	// <mod>.json, the mod counts as installed once it exists
+	INSTALLED_JSON = 1,
+	// <mod>.zip
+	INSTALLED_ZIP = 2,
+	// <mod>/, the extracted zip
+	INSTALLED_DIR = 4,
+};
+
+
+// a host minimod talked to in this or a previous session.
+// used to set up connections before the first request needs them.
+struct known_host
+{
+	char name[256];
+	time_t expires;
+};
+
+
+// a mod's zip opened by minimod_mod_open(), shared while it is open
+struct minimod_modfs
+{
+	struct zipfs *zip;
+	struct minimod_modfs *next;
+	uint64_t game_id;
+	uint64_t mod_id;
+	// of the zip, which an update replaces, thusly it is opened anew
+	uint64_t modfile_id;
+	size_t refs;
+};
+
+
+struct minimod_modfs_file
+{
+	struct zipfs_file *file;
+};
+
+
 struct mmi
 {
 	char *api_key;
 	char *root_path;
 	char *cache_tokenpath;
+	char *cache_hostspath;
 	char *token;
 	char *token_bearer;
+	// base URL of the API, without trailing '/'
+	char const *endpoint;
 	struct install_request *install_requests;
 	mtx_t install_requests_mtx;
+	struct task *free_tasks;
+	size_t nfree_tasks;
+	mtx_t free_tasks_mtx;
+	// the referenced documents, ordered by address
+	struct document **documents;
+	size_t ndocuments;
+	size_t documents_capacity;
+	struct document *free_documents;
+	size_t nfree_documents;
+	mtx_t documents_mtx;
+	// the files in mods/, read once by minimod_init() and then kept up to
+	// date by installing and uninstalling, and by the watcher if started
+	struct modindex installed;
+	// string table of the mods' names, offset 0 is the empty string
+	char *installed_names;
+	size_t ninstalled_names;
+	size_t installed_names_capacity;
+	// when mods/ and each game's directory were modified before they were
+	// listed last, guarded by installed_mtx
+	struct dir_mtime *dir_mtimes;
+	size_t ndir_mtimes;
+	size_t dir_mtimes_capacity;
+	mtx_t installed_mtx;
+	// set by minimod_watch_installed(), guarded by installed_mtx
+	minimod_installed_changed_callback installed_callback;
+	void *installed_userdata;
+	// serializes writing the manifest, locked before installed_mtx is
+	// unlocked, so that the manifest is written in the order of changes
+	mtx_t manifest_mtx;
+	char *cache_manifestpath;
+	struct minimod_modfs *open_mods;
+	mtx_t open_mods_mtx;
+	struct known_host hosts[MAX_KNOWN_HOSTS];
+	mtx_t hosts_mtx;
 	time_t rate_limited_until;
 	int env;
 	bool unzip;
 	bool is_apikey_invalid;
-	char _padding[2];
+	bool hosts_dirty;
+	// l_mmi.installed changed since the manifest was written
+	bool installed_dirty;
 };
 static struct mmi l_mmi;
 
+// collected over the lifetime of the library, not per minimod_init()
+static struct minimod_endpoint_stats l_stats[MINIMOD_ENDPOINT_COUNT];
+
+// used as categories and names of trace events
+static char const *const endpoint_names[MINIMOD_ENDPOINT_COUNT] = {
+	"games",   "mods",    "modfiles", "events",        "dependencies",
+	"me",      "auth",    "ratings",  "subscriptions", "download",
+};
+static char const *const phase_names[MINIMOD_PHASE_COUNT] = {
+	"network", "decode", "parse", "populate", "callback", "extract",
+};
+
 
 static char const *endpoints[2] = {
 	"https://api.mod.io/v1",
 	"https://api.test.mod.io/v1",
 };
 
+// set by minimod_set_endpoint(), replaces endpoints[]
+static char *l_custom_endpoint;
+
+// set by minimod_set_batch_size(), 0 delivers list responses at once
+static size_t l_batch_size;
+
 
 static struct task *
 alloc_task(void)
 {
-	return calloc(1, sizeof(struct task));
+	mtx_lock(&l_mmi.free_tasks_mtx);
+	struct task *task = l_mmi.free_tasks;
+	if (task)
+	{
+		l_mmi.free_tasks = task->next_free;
+		--l_mmi.nfree_tasks;
+	}
+	mtx_unlock(&l_mmi.free_tasks_mtx);
+
+	if (!task)
+	{
+		return mem_calloc(1, sizeof(struct task));
+	}
+	*task = (struct task){ 0 };
+	return task;
 }
 
 
 static void
 free_task(struct task *task)
 {
-	free(task);
+	mtx_lock(&l_mmi.free_tasks_mtx);
+	if (l_mmi.nfree_tasks < MAX_FREE_TASKS)
+	{
+		task->next_free = l_mmi.free_tasks;
+		l_mmi.free_tasks = task;
+		++l_mmi.nfree_tasks;
+		task = NULL;
+	}
+	mtx_unlock(&l_mmi.free_tasks_mtx);
+	mem_free(task);
+}
+
+
+// the position of the first referenced document at or after *in_ptr*,
+// l_mmi.documents_mtx has to be locked
+static size_t
+bisect_documents(void const *in_ptr)
+{
+	uintptr_t const ptr = (uintptr_t)in_ptr;
+	size_t lo = 0;
+	size_t hi = l_mmi.ndocuments;
+	while (lo < hi)
+	{
+		size_t const mid = lo + (hi - lo) / 2;
+		if ((uintptr_t)l_mmi.documents[mid] < ptr)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+
+// takes the smallest free document that fits, or allocates a new one.
+// the returned document is referenced once.
+static struct document *
+open_document(size_t in_bytes)
+{
+	mtx_lock(&l_mmi.documents_mtx);
+	struct document **best = NULL;
+	for (struct document **it = &l_mmi.free_documents; *it; it = &(*it)->next)
+	{
+		if ((*it)->size >= in_bytes && (!best || (*it)->size < (*best)->size))
+		{
+			best = it;
+		}
+	}
+	struct document *doc = NULL;
+	if (best)
+	{
+		doc = *best;
+		*best = doc->next;
+		--l_mmi.nfree_documents;
+	}
+	mtx_unlock(&l_mmi.documents_mtx);
+
+	if (!doc)
+	{
+		doc = mem_alloc(sizeof *doc + in_bytes);
+		if (!doc)
+		{
+			return NULL;
+		}
+		doc->size = in_bytes;
+	}
+	doc->refs = 1;
+	doc->next = NULL;
+
+	mtx_lock(&l_mmi.documents_mtx);
+	if (l_mmi.ndocuments == l_mmi.documents_capacity)
+	{
+		size_t const capacity =
+		  l_mmi.documents_capacity ? l_mmi.documents_capacity * 2 : 64;
+		struct document **documents =
+		  mem_realloc(l_mmi.documents, capacity * sizeof *documents);
+		if (!documents)
+		{
+			mtx_unlock(&l_mmi.documents_mtx);
+			mem_free(doc);
+			return NULL;
+		}
+		l_mmi.documents = documents;
+		l_mmi.documents_capacity = capacity;
+	}
+	// usually at the end, as the allocator tends to hand out increasing
+	// addresses
+	size_t const pos = bisect_documents(doc);
+	memmove(
+	  l_mmi.documents + pos + 1,
+	  l_mmi.documents + pos,
+	  (l_mmi.ndocuments - pos) * sizeof *l_mmi.documents);
+	l_mmi.documents[pos] = doc;
+	++l_mmi.ndocuments;
+	mtx_unlock(&l_mmi.documents_mtx);
+	return doc;
+}
+
+
+// puts *in_doc* into the free list, unless it is too large to be kept.
+// once the list is full, it replaces the largest free document if that is
+// larger. returns the document to be freed, if any. l_mmi.documents_mtx
+// has to be locked.
+static struct document *
+keep_free_document(struct document *in_doc)
+{
+	if (in_doc->size > MAX_FREE_DOCUMENT_SIZE)
+	{
+		return in_doc;
+	}
+	struct document *dropped = NULL;
+	if (l_mmi.nfree_documents == MAX_FREE_DOCUMENTS)
+	{
+		struct document **largest = &l_mmi.free_documents;
+		for (struct document **it = largest; *it; it = &(*it)->next)
+		{
+			if ((*it)->size > (*largest)->size)
+			{
+				largest = it;
+			}
+		}
+		if ((*largest)->size <= in_doc->size)
+		{
+			return in_doc;
+		}
+		dropped = *largest;
+		*largest = dropped->next;
+		--l_mmi.nfree_documents;
+	}
+	in_doc->next = l_mmi.free_documents;
+	l_mmi.free_documents = in_doc;
+	++l_mmi.nfree_documents;
+	return dropped;
+}
+
+
+// the last reference puts the document back into the free list
+static void
+release_document(struct document *doc)
+{
+	mtx_lock(&l_mmi.documents_mtx);
+	ASSERT(doc->refs > 0);
+	if (--doc->refs > 0)
+	{
+		doc = NULL;
+	}
+	else
+	{
+		size_t const pos = bisect_documents(doc);
+		ASSERT(pos < l_mmi.ndocuments && l_mmi.documents[pos] == doc);
+		--l_mmi.ndocuments;
+		memmove(
+		  l_mmi.documents + pos,
+		  l_mmi.documents + pos + 1,
+		  (l_mmi.ndocuments - pos) * sizeof *l_mmi.documents);
+		doc = keep_free_document(doc);
+	}
+	mtx_unlock(&l_mmi.documents_mtx);
+	mem_free(doc);
+}
+
+
+// the referenced document *in_ptr* points into, l_mmi.documents_mtx has to
+// be locked
+static struct document *
+find_document(void const *in_ptr)
+{
+	// the last document starting before *in_ptr*
+	size_t const pos = bisect_documents(in_ptr);
+	if (pos == 0)
+	{
+		return NULL;
+	}
+	struct document *doc = l_mmi.documents[pos - 1];
+	uintptr_t const ptr = (uintptr_t)in_ptr;
+	uintptr_t const data = (uintptr_t)(doc + 1);
+	return ptr >= data && ptr - data < doc->size ? doc : NULL;
+}
+
+
+static void
+free_documents(struct document *in_list)
+{
+	while (in_list)
+	{
+		struct document *next = in_list->next;
+		mem_free(in_list);
+		in_list = next;
+	}
 }
 
 
 static struct install_request *
 alloc_install_request(void)
 {
-	struct install_request *r = calloc(1, sizeof(struct install_request));
+	struct install_request *r =
+	  mem_calloc(1, sizeof(struct install_request));
 	mtx_lock(&l_mmi.install_requests_mtx);
 	r->next = l_mmi.install_requests;
 	l_mmi.install_requests = r;
@@ -171,8 +550,9 @@ free_install_request(struct install_request *req)
 	if (l_mmi.install_requests == req)
 	{
 		l_mmi.install_requests = l_mmi.install_requests->next;
-		free(req->zip_path);
-		free(req);
+		mem_free(req->zip_path);
+		mem_free(req->name);
+		mem_free(req);
 	}
 	else
 	{
@@ -184,8 +564,9 @@ free_install_request(struct install_request *req)
 				// remove from list
 				r->next = r->next->next;
 				// free it
-				free(req->zip_path);
-				free(req);
+				mem_free(req->zip_path);
+				mem_free(req->name);
+				mem_free(req);
 				break;
 			}
 			r = r->next;
@@ -195,258 +576,2299 @@ free_install_request(struct install_request *req)
 }
 
 
+// what is known about an installed mod besides its files.
+// members which are 0 or NULL are left as they are.
+struct installed_info
+{
+	uint64_t modfile_id;
+	uint64_t date_updated;
+	uint64_t filesize;
+	char const *name;
+};
+
+
+// when a directory in mods/ was modified, see sync_modified()
+struct dir_mtime
+{
+	// 0 for mods/ itself
+	uint64_t game_id;
+	// of fsu_mtimeat()
+	uint64_t mtime;
+};
+
+
+// header of the manifest, a single file with everything in
+// l_mmi.installed. the header is followed by l_mmi.dir_mtimes, the entries
+// as they are and then by the string table their names point into.
+struct manifest_header
+{
+	uint32_t magic;
+	// in case the entries change
+	uint32_t entry_size;
+	uint64_t ndirs;
+	uint64_t nentries;
+	// bytes of the string table
+	uint64_t nstrings;
+};
+
+
 static char *
-get_tokenpath(void)
+get_manifestpath(void)
 {
 	ASSERT(l_mmi.root_path);
 
-	if (!l_mmi.cache_tokenpath)
+	if (!l_mmi.cache_manifestpath)
 	{
-		asprintf(&l_mmi.cache_tokenpath, "%s/token", l_mmi.root_path);
+		mem_asprintf(
+		  &l_mmi.cache_manifestpath,
+		  "%s/manifest",
+		  l_mmi.root_path);
 	}
 
-	return l_mmi.cache_tokenpath;
+	return l_mmi.cache_manifestpath;
 }
 
 
-static bool
-read_token(void)
+// adds *in_name* to l_mmi.installed_names and returns its offset,
+// l_mmi.installed_mtx has to be locked
+static uint32_t
+add_installed_name(char const *in_name)
 {
-	int64_t fsize = fsu_fsize(get_tokenpath());
-	if (fsize > 0)
+	size_t const len = strlen(in_name) + 1;
+	size_t const offset = l_mmi.ninstalled_names ? l_mmi.ninstalled_names : 1;
+	if (len == 1 || offset + len > UINT32_MAX)
 	{
-		// read file into l_mmi.token (does null-terminate it)
-		FILE *f = fsu_fopen(get_tokenpath(), "rb");
-		ASSERT(f);
-		l_mmi.token = malloc((size_t)(fsize + 1));
-		fread(l_mmi.token, (size_t)fsize, 1, f);
-		l_mmi.token[fsize] = '\0';
-		fclose(f);
-		asprintf(&l_mmi.token_bearer, "Bearer %s", l_mmi.token);
-		return true;
+		return 0;
 	}
-	return false;
+	if (offset + len > l_mmi.installed_names_capacity)
+	{
+		size_t capacity = l_mmi.installed_names_capacity * 2 + 4096;
+		while (capacity < offset + len)
+		{
+			capacity *= 2;
+		}
+		char *names = mem_realloc(l_mmi.installed_names, capacity);
+		if (!names)
+		{
+			LOGE("could not grow names to %zu bytes", capacity);
+			return 0;
+		}
+		l_mmi.installed_names = names;
+		l_mmi.installed_names_capacity = capacity;
+	}
+	l_mmi.installed_names[0] = '\0';
+	memcpy(l_mmi.installed_names + offset, in_name, len);
+	l_mmi.ninstalled_names = offset + len;
+	return (uint32_t)offset;
 }
 
 
+// sets and clears flags of the mod's entry in l_mmi.installed and adds
+// *in_info*, if not NULL. the entry is removed once no flags are left.
 static void
-populate_game(struct minimod_game *game, QAJ4C_Value const *node)
+update_installed(
+  uint64_t in_game_id,
+  uint64_t in_mod_id,
+  uint32_t in_set,
+  uint32_t in_clear,
+  struct installed_info const *in_info)
 {
-	ASSERT(game);
-	ASSERT(QAJ4C_is_object(node));
+	mtx_lock(&l_mmi.installed_mtx);
+	struct modindex_entry *entry =
+	  modindex_put(&l_mmi.installed, in_game_id, in_mod_id);
+	uint32_t old_flags = 0;
+	uint32_t new_flags = 0;
+	if (entry)
+	{
+		old_flags = entry->flags;
+		entry->flags = (entry->flags | in_set) & ~in_clear;
+		new_flags = entry->flags;
+		if (in_info && in_info->modfile_id)
+		{
+			entry->modfile_id = in_info->modfile_id;
+		}
+		if (in_info && in_info->date_updated)
+		{
+			entry->date_updated = in_info->date_updated;
+		}
+		if (in_info && in_info->filesize)
+		{
+			entry->filesize = in_info->filesize;
+		}
+		if (in_info && in_info->name)
+		{
+			entry->name = add_installed_name(in_info->name);
+		}
+		if (!entry->flags)
+		{
+			modindex_remove(&l_mmi.installed, in_game_id, in_mod_id);
+		}
+		l_mmi.installed_dirty = true;
+	}
+	minimod_installed_changed_callback const callback =
+	  l_mmi.installed_callback;
+	void *const userdata = l_mmi.installed_userdata;
+	mtx_unlock(&l_mmi.installed_mtx);
 
-	game->id = QAJ4C_get_uint64(QAJ4C_object_get(node, "id"));
-	game->name = QAJ4C_get_string(QAJ4C_object_get(node, "name"));
-	game->more = node;
+	if (callback && ((old_flags ^ new_flags) & INSTALLED_JSON))
+	{
+		callback(
+		  userdata,
+		  in_game_id,
+		  in_mod_id,
+		  new_flags & INSTALLED_JSON);
+	}
 }
 
 
+// writes l_mmi.installed to the manifest, if it changed since it was
+// written last. the names are compacted on the way.
 static void
-populate_user(struct minimod_user *user, QAJ4C_Value const *node)
+save_installed(void)
 {
-	ASSERT(user);
-	ASSERT(QAJ4C_is_object(node));
+	mtx_lock(&l_mmi.installed_mtx);
+	if (!l_mmi.installed_dirty)
+	{
+		mtx_unlock(&l_mmi.installed_mtx);
+		return;
+	}
+	l_mmi.installed_dirty = false;
+
+	struct modindex const *index = &l_mmi.installed;
+	size_t nstrings = 1;
+	for (size_t i = 0; i < index->capacity; ++i)
+	{
+		if (index->entries[i].mod_id && index->entries[i].name)
+		{
+			nstrings +=
+			  strlen(l_mmi.installed_names + index->entries[i].name) + 1;
+		}
+	}
+	struct manifest_header const header = {
+		.magic = MANIFEST_MAGIC,
+		.entry_size = sizeof(struct modindex_entry),
+		.ndirs = l_mmi.ndir_mtimes,
+		.nentries = index->count,
+		.nstrings = nstrings,
+	};
+	size_t const ndirs = l_mmi.ndir_mtimes * sizeof *l_mmi.dir_mtimes;
+	size_t const size = sizeof header + ndirs +
+	  index->count * sizeof(struct modindex_entry) + nstrings;
+	void *data = mem_alloc(size);
+	if (!data)
+	{
+		LOGE("could not allocate %zu bytes for the manifest", size);
+		mtx_unlock(&l_mmi.installed_mtx);
+		return;
+	}
+
+	memcpy(data, &header, sizeof header);
+	if (ndirs > 0)
+	{
+		memcpy((char *)data + sizeof header, l_mmi.dir_mtimes, ndirs);
+	}
+	struct modindex_entry *entries =
+	  (void *)((char *)data + sizeof header + ndirs);
+	char *strings = (char *)(entries + index->count);
+	strings[0] = '\0';
+	size_t nentries = 0;
+	nstrings = 1;
+	for (size_t i = 0; i < index->capacity; ++i)
+	{
+		struct modindex_entry *entry = &index->entries[i];
+		if (!entry->mod_id)
+		{
+			continue;
+		}
+		if (entry->name)
+		{
+			char const *name = l_mmi.installed_names + entry->name;
+			size_t const len = strlen(name) + 1;
+			memcpy(strings + nstrings, name, len);
+			entry->name = (uint32_t)nstrings;
+			nstrings += len;
+		}
+		entries[nentries++] = *entry;
+	}
+	// the compacted names replace the old ones
+	if (l_mmi.installed_names)
+	{
+		memcpy(l_mmi.installed_names, strings, nstrings);
+		l_mmi.ninstalled_names = nstrings;
+	}
+
+	mtx_lock(&l_mmi.manifest_mtx);
+	mtx_unlock(&l_mmi.installed_mtx);
+
+	// replaces the manifest at once, so that it is never read half-written
+	char *tmppath;
+	mem_asprintf(&tmppath, "%s.tmp", get_manifestpath());
+	FILE *f = fsu_fopen(tmppath, "wb");
+	bool const is_written = f && fwrite(data, size, 1, f) == 1;
+	if (f && 0 != fclose(f))
+	{
+		LOGE("could not write %s", tmppath);
+	}
+	else if (!is_written || !fsu_mvfile(tmppath, get_manifestpath(), true))
+	{
+		LOGE("could not replace %s", get_manifestpath());
+	}
+	mem_free(tmppath);
+
+	mtx_unlock(&l_mmi.manifest_mtx);
+	mem_free(data);
+}
+
+
+// fills l_mmi.installed from a manifest written by save_installed().
+// nothing is added unless the whole manifest is valid.
+static bool
+read_manifest(void const *in_data, size_t in_size)
+{
+	struct manifest_header header;
+	if (in_size < sizeof header)
+	{
+		return false;
+	}
+	memcpy(&header, in_data, sizeof header);
+	size_t const entry_size = sizeof(struct modindex_entry);
+	size_t const dir_size = sizeof(struct dir_mtime);
+	if (header.magic != MANIFEST_MAGIC || header.entry_size != entry_size ||
+	  header.ndirs > (in_size - sizeof header) / dir_size)
+	{
+		return false;
+	}
+	size_t const ndirs = (size_t)header.ndirs;
+	size_t const nrest = in_size - sizeof header - ndirs * dir_size;
+	if (header.nentries > nrest / entry_size)
+	{
+		return false;
+	}
+	size_t const nentries = (size_t)header.nentries;
+	size_t const nstrings = nrest - nentries * entry_size;
+	if (header.nstrings != nstrings || nstrings == 0 || nstrings > UINT32_MAX)
+	{
+		return false;
+	}
+
+	char const *dirs = (char const *)in_data + sizeof header;
+	struct modindex_entry const *entries =
+	  (void const *)(dirs + ndirs * dir_size);
+	char const *strings = (char const *)(entries + nentries);
+	if (strings[nstrings - 1] != '\0')
+	{
+		return false;
+	}
+	for (size_t i = 0; i < nentries; ++i)
+	{
+		if (!entries[i].mod_id || entries[i].name >= nstrings)
+		{
+			return false;
+		}
+	}
+
+	char *names = mem_alloc(nstrings);
+	struct dir_mtime *mtimes = ndirs ? mem_alloc(ndirs * dir_size) : NULL;
+	if (!names || (ndirs && !mtimes) ||
+	  !modindex_reserve(&l_mmi.installed, nentries))
+	{
+		mem_free(mtimes);
+		mem_free(names);
+		return false;
+	}
+	if (ndirs > 0)
+	{
+		memcpy(mtimes, dirs, ndirs * dir_size);
+	}
+	l_mmi.dir_mtimes = mtimes;
+	l_mmi.ndir_mtimes = ndirs;
+	l_mmi.dir_mtimes_capacity = ndirs;
+	memcpy(names, strings, nstrings);
+	l_mmi.installed_names = names;
+	l_mmi.ninstalled_names = nstrings;
+	l_mmi.installed_names_capacity = nstrings;
+	for (size_t i = 0; i < nentries; ++i)
+	{
+		*modindex_put(
+		  &l_mmi.installed,
+		  entries[i].game_id,
+		  entries[i].mod_id) = entries[i];
+	}
+	return true;
+}
+
+
+// the mod id of *in_name* if it is a number followed by *in_suffix*,
+// 0 otherwise
+static uint64_t
+parse_mod_name(char const *in_name, char const *in_suffix)
+{
+	uint64_t id = 0;
+	char const *c = in_name;
+	for (; isdigit((uint8_t)*c); ++c)
+	{
+		id = id * 10 + (uint64_t)(*c - '0');
+	}
+	return c > in_name && 0 == strcmp(c, in_suffix) ? id : 0;
+}
+
+
+// the files found in a game's directory, see list_installed()
+struct listing
+{
+	struct modindex *index;
+	uint64_t game_id;
+	// mods/, while listing all games
+	fsu_dir const *mods_dir;
+};
+
+
+// enough for a mod's id and the suffix of its files
+#define MOD_NAME_SIZE 32
 
-	user->id = QAJ4C_get_uint64(QAJ4C_object_get(node, "id"));
-	user->username = QAJ4C_get_string(QAJ4C_object_get(node, "username"));
-	user->more = node;
+
+// mods/<in_game_id>/, or mods/ if *in_game_id* is 0. FSU_NODIR if it
+// does not exist, unless *in_create*.
+static fsu_dir
+open_game_dir(uint64_t in_game_id, bool in_create)
+{
+	char *path;
+	if (in_game_id)
+	{
+		mem_asprintf(
+		  &path,
+		  "%s/mods/%" PRIu64,
+		  l_mmi.root_path,
+		  in_game_id);
+	}
+	else
+	{
+		mem_asprintf(&path, "%s/mods", l_mmi.root_path);
+	}
+	fsu_dir const dir = fsu_opendir(path, in_create);
+	mem_free(path);
+	return dir;
+}
+
+
+// a mod's file with *in_suffix*, or while it is installed the staged one,
+// which starts with '.' and thusly is skipped by listing and watching
+static void
+mod_file_name(
+  char *out_name,
+  uint64_t in_mod_id,
+  char const *in_suffix,
+  bool in_is_staged)
+{
+	snprintf(
+	  out_name,
+	  MOD_NAME_SIZE,
+	  "%s%" PRIu64 "%s",
+	  in_is_staged ? "." : "",
+	  in_mod_id,
+	  in_suffix);
+}
+
+
+// moves a file or directory to the trash, or deletes it if it cannot be
+// moved
+static void
+discard(fsu_dir in_dir, char const *in_name)
+{
+	if (!trash_moveat(in_dir, in_name) && !fsu_rmfileat(in_dir, in_name))
+	{
+		fsu_rmdirat_recursive(in_dir, in_name);
+	}
+}
+
+
+// replaces a mod's file or directory with the staged one and discards the
+// old one, which those who opened it keep reading. if the platform cannot
+// exchange them atomically, the old one is missing for a moment.
+static bool
+publish(fsu_dir in_dir, uint64_t in_mod_id, char const *in_suffix)
+{
+	char staged[MOD_NAME_SIZE];
+	char live[MOD_NAME_SIZE];
+	mod_file_name(staged, in_mod_id, in_suffix, true);
+	mod_file_name(live, in_mod_id, in_suffix, false);
+	if (fsu_ptypeat(in_dir, staged) == FSU_PATHTYPE_NONE)
+	{
+		return false;
+	}
+	if (fsu_exchangeat(in_dir, staged, in_dir, live))
+	{
+		// the staged name is the old one's now
+		discard(in_dir, staged);
+		return true;
+	}
+	// if there is no old one, or a file which POSIX replaces atomically
+	if (fsu_renameat(in_dir, staged, in_dir, live))
+	{
+		return true;
+	}
+	// the old one stays unless it is what is in the way
+	if (!fsu_renameat_existed())
+	{
+		LOGE("could not publish %s", live);
+		return false;
+	}
+	discard(in_dir, live);
+	return fsu_renameat(in_dir, staged, in_dir, live);
+}
+
+
+static void
+index_game_dir(
+  char const *UNUSED(root),
+  char const *name,
+  bool is_dir,
+  void *in_userdata)
+{
+	struct listing const *listing = in_userdata;
+	uint64_t mod_id;
+	uint32_t flag = 0;
+	if ((mod_id = parse_mod_name(name, ".json")) && !is_dir)
+	{
+		flag = INSTALLED_JSON;
+	}
+	else if ((mod_id = parse_mod_name(name, ".zip")) && !is_dir)
+	{
+		flag = INSTALLED_ZIP;
+	}
+	else if ((mod_id = parse_mod_name(name, "")) && is_dir)
+	{
+		flag = INSTALLED_DIR;
+	}
+	struct modindex_entry *entry = flag
+	  ? modindex_put(listing->index, listing->game_id, mod_id)
+	  : NULL;
+	if (entry)
+	{
+		entry->flags |= flag;
+	}
+}
+
+
+// remembers in l_mmi.dir_mtimes when mods/<in_game_id>/, or mods/ if 0,
+// was modified. read before *in_dir* is listed, so that changes while
+// listing it are found by the next minimod_init().
+static void
+record_dir_mtime(uint64_t in_game_id, fsu_dir in_dir)
+{
+	uint64_t mtime = in_dir != FSU_NODIR ? fsu_mtimeat(in_dir, ".") : 0;
+	// changes within the same tick cannot be told apart, such a time is
+	// replaced by one which never matches
+	if (mtime &&
+	  mtime / 1000000000 + MTIME_RESOLUTION >= (uint64_t)time(NULL))
+	{
+		mtime = 1;
+	}
+
+	mtx_lock(&l_mmi.installed_mtx);
+	size_t i = 0;
+	while (i < l_mmi.ndir_mtimes && l_mmi.dir_mtimes[i].game_id != in_game_id)
+	{
+		++i;
+	}
+	if (i == l_mmi.ndir_mtimes && mtime)
+	{
+		if (i == l_mmi.dir_mtimes_capacity)
+		{
+			size_t const capacity = i * 2 + 8;
+			struct dir_mtime *mtimes = mem_realloc(
+			  l_mmi.dir_mtimes,
+			  capacity * sizeof *l_mmi.dir_mtimes);
+			if (!mtimes)
+			{
+				// the directory is listed again then, nothing more
+				mtx_unlock(&l_mmi.installed_mtx);
+				return;
+			}
+			l_mmi.dir_mtimes = mtimes;
+			l_mmi.dir_mtimes_capacity = capacity;
+		}
+		l_mmi.dir_mtimes[l_mmi.ndir_mtimes++] = (struct dir_mtime){
+			.game_id = in_game_id,
+		};
+	}
+	if (i < l_mmi.ndir_mtimes && l_mmi.dir_mtimes[i].mtime != mtime)
+	{
+		l_mmi.dir_mtimes[i].mtime = mtime;
+		if (!mtime)
+		{
+			l_mmi.dir_mtimes[i] = l_mmi.dir_mtimes[--l_mmi.ndir_mtimes];
+		}
+		l_mmi.installed_dirty = true;
+	}
+	mtx_unlock(&l_mmi.installed_mtx);
+}
+
+
+static void
+index_mods_dir(
+  char const *UNUSED(root),
+  char const *name,
+  bool is_dir,
+  void *in_userdata)
+{
+	struct listing listing = *(struct listing const *)in_userdata;
+	listing.game_id = parse_mod_name(name, "");
+	if (is_dir && listing.game_id)
+	{
+		fsu_dir const dir = fsu_opendirat(*listing.mods_dir, name, false);
+		if (dir != FSU_NODIR)
+		{
+			record_dir_mtime(listing.game_id, dir);
+			fsu_enum_dirat(dir, index_game_dir, &listing);
+			fsu_closedir(dir);
+		}
+	}
+}
+
+
+// fills *out_index* with the files of each mod in mods/, or only of those
+// in mods/<in_game_id>/ if it is not 0. a single listing of each game's
+// directory, the files are not read. records when the directories were
+// modified.
+static void
+list_installed(uint64_t in_game_id, struct modindex *out_index)
+{
+	if (!in_game_id)
+	{
+		// the games' directories which are gone are left out
+		mtx_lock(&l_mmi.installed_mtx);
+		l_mmi.ndir_mtimes = 0;
+		l_mmi.installed_dirty = true;
+		mtx_unlock(&l_mmi.installed_mtx);
+	}
+	fsu_dir const dir = open_game_dir(in_game_id, false);
+	record_dir_mtime(in_game_id, dir);
+	if (dir == FSU_NODIR)
+	{
+		return;
+	}
+	struct listing listing = {
+		.index = out_index,
+		.game_id = in_game_id,
+		.mods_dir = &dir,
+	};
+	fsu_enum_dirat(
+	  dir,
+	  in_game_id ? index_game_dir : index_mods_dir,
+	  &listing);
+	fsu_closedir(dir);
+}
+
+
+static void
+on_scanned_mod(
+  void *in_userdata,
+  size_t in_nmods,
+  struct minimod_mod const *in_mods,
+  struct minimod_pagination const *UNUSED(pagi))
+{
+	struct modindex_entry const *key = in_userdata;
+	if (in_nmods == 0)
+	{
+		return;
+	}
+	// the json file may have been written by anyone, its size stays 0
+	// unless it is where it belongs
+	QAJ4C_Value const *more = in_mods[0].more;
+	QAJ4C_Value const *modfile =
+	  QAJ4C_is_object(more) ? QAJ4C_object_get(more, "modfile") : NULL;
+	QAJ4C_Value const *filesize = QAJ4C_is_object(modfile)
+	  ? QAJ4C_object_get(modfile, "filesize")
+	  : NULL;
+	struct installed_info const info = {
+		.modfile_id = in_mods[0].modfile_id,
+		.date_updated = in_mods[0].date_updated,
+		.filesize =
+		  QAJ4C_is_uint64(filesize) ? QAJ4C_get_uint64(filesize) : 0,
+		.name = in_mods[0].name,
+	};
+	update_installed(key->game_id, key->mod_id, 0, 0, &info);
+}
+
+
+// sets the flags of the mod's entry in l_mmi.installed to *in_flags*.
+// its json file is read if the mod was not installed before.
+static void
+apply_installed(
+  uint64_t in_game_id,
+  uint64_t in_mod_id,
+  uint32_t in_old_flags,
+  uint32_t in_flags)
+{
+	update_installed(in_game_id, in_mod_id, in_flags, ~in_flags, NULL);
+	if (in_flags & ~in_old_flags & INSTALLED_JSON)
+	{
+		struct modindex_entry key = {
+			.game_id = in_game_id,
+			.mod_id = in_mod_id,
+		};
+		minimod_get_installed_mod(
+		  in_game_id,
+		  in_mod_id,
+		  on_scanned_mod,
+		  &key);
+	}
+}
+
+
+// brings the mods of *in_game_id*, or of all games if 0, in
+// l_mmi.installed up to date with the files in mods/
+static void
+sync_installed(uint64_t in_game_id)
+{
+	struct modindex found = { 0 };
+	list_installed(in_game_id, &found);
+
+	// collected first, since applying them locks l_mmi.installed_mtx
+	struct change
+	{
+		uint64_t game_id;
+		uint64_t mod_id;
+		uint32_t old_flags;
+		uint32_t flags;
+	};
+	struct arena_mark const mark = arena_mark();
+	mtx_lock(&l_mmi.installed_mtx);
+	struct modindex const *index = &l_mmi.installed;
+	size_t const capacity = index->count + found.count;
+	struct change *changes = arena_alloc(capacity * sizeof *changes);
+	ASSERT(changes || capacity == 0);
+	size_t nchanges = 0;
+	for (size_t i = 0; i < index->capacity; ++i)
+	{
+		struct modindex_entry const *entry = &index->entries[i];
+		if (!entry->mod_id || (in_game_id && entry->game_id != in_game_id))
+		{
+			continue;
+		}
+		struct modindex_entry const *file =
+		  modindex_get(&found, entry->game_id, entry->mod_id);
+		uint32_t const flags = file ? file->flags : 0;
+		if (flags != entry->flags)
+		{
+			changes[nchanges++] = (struct change){
+				.game_id = entry->game_id,
+				.mod_id = entry->mod_id,
+				.old_flags = entry->flags,
+				.flags = flags,
+			};
+		}
+	}
+	for (size_t i = 0; i < found.capacity; ++i)
+	{
+		struct modindex_entry const *file = &found.entries[i];
+		if (file->mod_id &&
+		  !modindex_get(index, file->game_id, file->mod_id))
+		{
+			changes[nchanges++] = (struct change){
+				.game_id = file->game_id,
+				.mod_id = file->mod_id,
+				.flags = file->flags,
+			};
+		}
+	}
+	mtx_unlock(&l_mmi.installed_mtx);
+	modindex_free(&found);
+
+	for (size_t i = 0; i < nchanges; ++i)
+	{
+		apply_installed(
+		  changes[i].game_id,
+		  changes[i].mod_id,
+		  changes[i].old_flags,
+		  changes[i].flags);
+	}
+	arena_release(mark);
+}
+
+
+// brings a single mod in l_mmi.installed up to date with its files
+static void
+refresh_installed(uint64_t in_game_id, uint64_t in_mod_id)
+{
+	static struct
+	{
+		char const *suffix;
+		enum fsu_pathtype type;
+		enum installed_flag flag;
+	} const files[] = {
+		{ ".json", FSU_PATHTYPE_FILE, INSTALLED_JSON },
+		{ ".zip", FSU_PATHTYPE_FILE, INSTALLED_ZIP },
+		{ "", FSU_PATHTYPE_DIR, INSTALLED_DIR },
+	};
+	uint32_t flags = 0;
+	fsu_dir const dir = open_game_dir(in_game_id, false);
+	if (dir != FSU_NODIR)
+	{
+		for (size_t i = 0; i < sizeof files / sizeof *files; ++i)
+		{
+			char name[MOD_NAME_SIZE];
+			mod_file_name(name, in_mod_id, files[i].suffix, false);
+			if (fsu_ptypeat(dir, name) == files[i].type)
+			{
+				flags |= files[i].flag;
+			}
+		}
+		fsu_closedir(dir);
+	}
+
+	mtx_lock(&l_mmi.installed_mtx);
+	struct modindex_entry const *entry =
+	  modindex_get(&l_mmi.installed, in_game_id, in_mod_id);
+	uint32_t const old_flags = entry ? entry->flags : 0;
+	mtx_unlock(&l_mmi.installed_mtx);
+	if (flags != old_flags)
+	{
+		apply_installed(in_game_id, in_mod_id, old_flags, flags);
+	}
+}
+
+
+// called by the watcher for changes in mods/
+static void
+on_watch(void *UNUSED(in_userdata), char const *in_dir, char const *in_name)
+{
+	uint64_t const game_id = in_dir ? parse_mod_name(in_dir, "") : 0;
+	uint64_t mod_id = 0;
+	if (!in_dir)
+	{
+		sync_installed(0);
+	}
+	else if (!game_id)
+	{
+		// not a game's directory
+		return;
+	}
+	else if (!in_name)
+	{
+		sync_installed(game_id);
+	}
+	else if ((mod_id = parse_mod_name(in_name, ".json")) ||
+	  (mod_id = parse_mod_name(in_name, ".zip")) ||
+	  (mod_id = parse_mod_name(in_name, "")))
+	{
+		refresh_installed(game_id, mod_id);
+	}
+	save_installed();
+}
+
+
+// lists the directories again which were modified since they were listed
+// last, according to the manifest. a game's directory which is added or
+// removed modifies mods/, which lists all of them.
+static void
+sync_modified(void)
+{
+	fsu_dir const mods_dir = open_game_dir(0, false);
+	uint64_t const mods_mtime =
+	  mods_dir != FSU_NODIR ? fsu_mtimeat(mods_dir, ".") : 0;
+
+	struct arena_mark const mark = arena_mark();
+	mtx_lock(&l_mmi.installed_mtx);
+	size_t const ndirs = l_mmi.ndir_mtimes;
+	struct dir_mtime *dirs = arena_alloc(ndirs * sizeof *dirs + 1);
+	ASSERT(dirs);
+	if (ndirs > 0)
+	{
+		memcpy(dirs, l_mmi.dir_mtimes, ndirs * sizeof *dirs);
+	}
+	mtx_unlock(&l_mmi.installed_mtx);
+
+	uint64_t recorded = 0;
+	for (size_t i = 0; i < ndirs; ++i)
+	{
+		recorded = dirs[i].game_id == 0 ? dirs[i].mtime : recorded;
+	}
+	if (recorded != mods_mtime)
+	{
+		LOG("mods/ was modified");
+		sync_installed(0);
+	}
+	for (size_t i = 0; recorded == mods_mtime && i < ndirs; ++i)
+	{
+		char name[MOD_NAME_SIZE];
+		mod_file_name(name, dirs[i].game_id, "", false);
+		if (dirs[i].game_id &&
+		  fsu_mtimeat(mods_dir, name) != dirs[i].mtime)
+		{
+			LOG("mods/%s was modified", name);
+			sync_installed(dirs[i].game_id);
+		}
+	}
+	arena_release(mark);
+	fsu_closedir(mods_dir);
+}
+
+
+// fills l_mmi.installed from the manifest, or from mods/ if there is no
+// valid manifest, which is written then
+static void
+load_installed(void)
+{
+	uint64_t const start = sys_nanoseconds();
+	size_t size = 0;
+	void const *manifest = fsu_mmap(get_manifestpath(), &size);
+	bool const is_read = manifest && read_manifest(manifest, size);
+	fsu_munmap(manifest, size);
+	if (is_read)
+	{
+		sync_modified();
+	}
+	else
+	{
+		if (manifest)
+		{
+			LOGE("ignoring invalid %s", get_manifestpath());
+		}
+		sync_installed(0);
+	}
+	save_installed();
+	LOG(
+	  "indexed %zu mods in %" PRIu64 " us%s",
+	  l_mmi.installed.count,
+	  (sys_nanoseconds() - start) / 1000,
+	  is_read ? " from the manifest" : "");
+}
+
+
+static void
+stats_add(uint64_t *in_counter, uint64_t in_value)
+{
+	__atomic_fetch_add(in_counter, in_value, __ATOMIC_RELAXED);
+}
+
+
+// records the time from in_start until now as a duration of in_phase.
+// returns now, so phases following each other can be chained.
+static uint64_t
+stats_record(
+  enum minimod_endpoint in_endpoint,
+  enum minimod_phase in_phase,
+  uint64_t in_start)
+{
+	uint64_t const now = sys_nanoseconds();
+	uint64_t const us = (now - in_start) / 1000;
+	struct minimod_histogram *h = &l_stats[in_endpoint].phases[in_phase];
+
+	size_t bucket = 0;
+	for (uint64_t v = us; v && bucket < MINIMOD_HISTOGRAM_BUCKETS - 1; v >>= 1)
+	{
+		++bucket;
+	}
+
+	stats_add(&h->count, 1);
+	stats_add(&h->total_us, us);
+	stats_add(&h->buckets[bucket], 1);
+	uint64_t max = __atomic_load_n(&h->max_us, __ATOMIC_RELAXED);
+	while (us > max &&
+	       !__atomic_compare_exchange_n(
+	         &h->max_us,
+	         &max,
+	         us,
+	         true,
+	         __ATOMIC_RELAXED,
+	         __ATOMIC_RELAXED))
+	{
+	}
+
+	trace_complete(
+	  phase_names[in_phase],
+	  endpoint_names[in_endpoint],
+	  in_start,
+	  now,
+	  0);
+	return now;
+}
+
+
+static void
+stats_count_response(
+  enum minimod_endpoint in_endpoint,
+  int in_status,
+  size_t in_bytes)
+{
+	struct minimod_endpoint_stats *stats = &l_stats[in_endpoint];
+	stats_add(&stats->nrequests, 1);
+	if (in_status < 200 || in_status >= 300)
+	{
+		stats_add(&stats->nfailed, 1);
+	}
+	stats_add(&stats->nbytes, in_bytes);
+}
+
+
+static char *
+get_tokenpath(void)
+{
+	ASSERT(l_mmi.root_path);
+
+	if (!l_mmi.cache_tokenpath)
+	{
+		mem_asprintf(&l_mmi.cache_tokenpath, "%s/token", l_mmi.root_path);
+	}
+
+	return l_mmi.cache_tokenpath;
+}
+
+
+static bool
+read_token(void)
+{
+	int64_t fsize = fsu_fsize(get_tokenpath());
+	if (fsize > 0)
+	{
+		// read file into l_mmi.token (does null-terminate it)
+		FILE *f = fsu_fopen(get_tokenpath(), "rb");
+		ASSERT(f);
+		l_mmi.token = mem_alloc((size_t)(fsize + 1));
+		fread(l_mmi.token, (size_t)fsize, 1, f);
+		l_mmi.token[fsize] = '\0';
+		fclose(f);
+		mem_asprintf(&l_mmi.token_bearer, "Bearer %s", l_mmi.token);
+		return true;
+	}
+	return false;
+}
+
+
+static char *
+get_hostspath(void)
+{
+	ASSERT(l_mmi.root_path);
+
+	if (!l_mmi.cache_hostspath)
+	{
+		mem_asprintf(&l_mmi.cache_hostspath, "%s/hosts", l_mmi.root_path);
+	}
+
+	return l_mmi.cache_hostspath;
+}
+
+
+// copies scheme, host and port of *in_url*, i.e. "http://127.0.0.1:8977"
+static bool
+origin_from_url(char const *in_url, char *out_origin, size_t in_bytes)
+{
+	char const *host = strstr(in_url, "://");
+	if (!host)
+	{
+		return false;
+	}
+	host += 3;
+	size_t len = (size_t)(host - in_url) + strcspn(host, "/?#");
+	if (host[0] == '\0' || host[0] == '/' || len >= in_bytes)
+	{
+		return false;
+	}
+	memcpy(out_origin, in_url, len);
+	out_origin[len] = '\0';
+	return true;
+}
+
+
+static void
+remember_host(char const *in_url)
+{
+	char host[sizeof l_mmi.hosts[0].name];
+	if (!origin_from_url(in_url, host, sizeof host))
+	{
+		return;
+	}
+
+	mtx_lock(&l_mmi.hosts_mtx);
+	// refresh the entry of the host, if there is one.
+	// otherwise replace the entry which expires first.
+	struct known_host *slot = &l_mmi.hosts[0];
+	for (size_t i = 0; i < MAX_KNOWN_HOSTS; ++i)
+	{
+		struct known_host *h = &l_mmi.hosts[i];
+		if (0 == strcmp(h->name, host))
+		{
+			slot = h;
+			break;
+		}
+		if (h->expires < slot->expires)
+		{
+			slot = h;
+		}
+	}
+	memcpy(slot->name, host, sizeof host);
+	slot->expires = time(NULL) + HOSTS_TTL;
+	l_mmi.hosts_dirty = true;
+	mtx_unlock(&l_mmi.hosts_mtx);
+}
+
+
+// loads hosts remembered by previous sessions, skipping expired ones.
+// one host per line: "<scheme>://<name>[:<port>] <expiry in unix-time>"
+static void
+read_hosts(void)
+{
+	FILE *f = fsu_fopen(get_hostspath(), "rb");
+	if (!f)
+	{
+		return;
+	}
+
+	time_t const now = time(NULL);
+	size_t n = 0;
+	char name[sizeof l_mmi.hosts[0].name];
+	long long expires = 0;
+	while (n < MAX_KNOWN_HOSTS &&
+	       2 == fscanf(f, "%255s %lld", name, &expires))
+	{
+		if ((time_t)expires > now)
+		{
+			memcpy(l_mmi.hosts[n].name, name, sizeof name);
+			l_mmi.hosts[n].expires = (time_t)expires;
+			++n;
+		}
+	}
+	fclose(f);
+	LOG("%zu remembered hosts loaded", n);
+}
+
+
+static void
+write_hosts(void)
+{
+	if (!l_mmi.hosts_dirty)
+	{
+		return;
+	}
+
+	FILE *f = fsu_fopen(get_hostspath(), "wb");
+	if (!f)
+	{
+		LOGE("could not write %s", get_hostspath());
+		return;
+	}
+
+	for (size_t i = 0; i < MAX_KNOWN_HOSTS; ++i)
+	{
+		if (l_mmi.hosts[i].name[0])
+		{
+			fprintf(
+			  f,
+			  "%s %lld\n",
+			  l_mmi.hosts[i].name,
+			  (long long)l_mmi.hosts[i].expires);
+		}
+	}
+	fclose(f);
+	l_mmi.hosts_dirty = false;
+}
+
+
+// populate_*() walk the members of an object once and look up each key in
+// a schema, which maps it to the field of the struct being populated.
+// the lookup goes through a perfect hash of the keys, see prepare_schema().
+enum field_type
+{
+	FIELD_UINT64,
+	FIELD_STRING,
+	FIELD_MODSTATUS,
+	FIELD_EVENTTYPE,
+	// its members are extracted by the field's own schema
+	FIELD_OBJECT,
+};
+
+
+struct field
+{
+	char const *key;
+	size_t key_len;
+	// in the struct being populated
+	size_t offset;
+	// FIELD_OBJECT only, its offsets are relative to *offset*
+	struct schema *object;
+	enum field_type type;
+	char _padding[4];
+};
+
+
+struct schema
+{
+	struct field const *fields;
+	size_t nfields;
+	// of the *more* pointer, which is set to the object, or NO_MORE
+	size_t more;
+	uint32_t seed;
+	// index + 1 into *fields*, 0 if unused
+	uint8_t slots[SCHEMA_SLOTS];
+	char _padding[4];
+};
+
+
+#define NO_MORE SIZE_MAX
+
+#define FIELD(STRUCT, MEMBER, KEY, TYPE)                  \
+	{                                                     \
+		.key = KEY, .key_len = sizeof KEY - 1,            \
+		.offset = offsetof(STRUCT, MEMBER), .type = TYPE, \
+	}
+
+#define OBJECT(STRUCT, MEMBER, KEY, SCHEMA)                   \
+	{                                                         \
+		.key = KEY, .key_len = sizeof KEY - 1,                \
+		.offset = offsetof(STRUCT, MEMBER), .object = SCHEMA, \
+		.type = FIELD_OBJECT,                                 \
+	}
+
+// members of the nested object populate the same struct
+#define FLATTEN(KEY, SCHEMA)                                \
+	{                                                       \
+		.key = KEY, .key_len = sizeof KEY - 1, .offset = 0, \
+		.object = SCHEMA, .type = FIELD_OBJECT,             \
+	}
+
+#define SCHEMA(FIELDS, MORE)                                         \
+	{                                                                \
+		.fields = FIELDS, .nfields = sizeof FIELDS / sizeof *FIELDS, \
+		.more = MORE,                                                \
+	}
+
+
+static struct field const l_game_fields[] = {
+	FIELD(struct minimod_game, id, "id", FIELD_UINT64),
+	FIELD(struct minimod_game, name, "name", FIELD_STRING),
+};
+static struct schema l_game_schema =
+  SCHEMA(l_game_fields, offsetof(struct minimod_game, more));
+
+
+static struct field const l_user_fields[] = {
+	FIELD(struct minimod_user, id, "id", FIELD_UINT64),
+	FIELD(struct minimod_user, username, "username", FIELD_STRING),
+};
+static struct schema l_user_schema =
+  SCHEMA(l_user_fields, offsetof(struct minimod_user, more));
+
+
+static struct field const l_stats_fields[] = {
+	FIELD(struct minimod_stats, mod_id, "mod_id", FIELD_UINT64),
+	FIELD(struct minimod_stats, ndownloads, "downloads_total", FIELD_UINT64),
+	FIELD(
+	  struct minimod_stats,
+	  nsubscribers,
+	  "subscribers_total",
+	  FIELD_UINT64),
+	FIELD(
+	  struct minimod_stats,
+	  nratings_positive,
+	  "ratings_positive",
+	  FIELD_UINT64),
+	FIELD(
+	  struct minimod_stats,
+	  nratings_negative,
+	  "ratings_negative",
+	  FIELD_UINT64),
+};
+static struct schema l_stats_schema =
+  SCHEMA(l_stats_fields, offsetof(struct minimod_stats, more));
+
+
+static struct field const l_filehash_fields[] = {
+	FIELD(struct minimod_modfile, md5, "md5", FIELD_STRING),
+};
+static struct schema l_filehash_schema = SCHEMA(l_filehash_fields, NO_MORE);
+
+
+static struct field const l_download_fields[] = {
+	FIELD(struct minimod_modfile, url, "binary_url", FIELD_STRING),
+};
+static struct schema l_download_schema = SCHEMA(l_download_fields, NO_MORE);
+
+
+static struct field const l_modfile_fields[] = {
+	FIELD(struct minimod_modfile, id, "id", FIELD_UINT64),
+	FIELD(struct minimod_modfile, mod_id, "mod_id", FIELD_UINT64),
+	FIELD(struct minimod_modfile, date_added, "date_added", FIELD_UINT64),
+	FIELD(struct minimod_modfile, filesize, "filesize", FIELD_UINT64),
+	FLATTEN("filehash", &l_filehash_schema),
+	FLATTEN("download", &l_download_schema),
+};
+static struct schema l_modfile_schema =
+  SCHEMA(l_modfile_fields, offsetof(struct minimod_modfile, more));
+
+
+// the modfile of a mod, only its id is kept
+static struct field const l_mod_modfile_fields[] = {
+	FIELD(struct minimod_mod, modfile_id, "id", FIELD_UINT64),
+};
+static struct schema l_mod_modfile_schema =
+  SCHEMA(l_mod_modfile_fields, NO_MORE);
+
+
+static struct field const l_mod_fields[] = {
+	FIELD(struct minimod_mod, id, "id", FIELD_UINT64),
+	FIELD(struct minimod_mod, game_id, "game_id", FIELD_UINT64),
+	FIELD(struct minimod_mod, date_updated, "date_updated", FIELD_UINT64),
+	FIELD(struct minimod_mod, name, "name", FIELD_STRING),
+	FIELD(struct minimod_mod, summary, "summary", FIELD_STRING),
+	FIELD(struct minimod_mod, status, "status", FIELD_MODSTATUS),
+	FLATTEN("modfile", &l_mod_modfile_schema),
+	OBJECT(struct minimod_mod, submitted_by, "submitted_by", &l_user_schema),
+	OBJECT(struct minimod_mod, stats, "stats", &l_stats_schema),
+};
+static struct schema l_mod_schema =
+  SCHEMA(l_mod_fields, offsetof(struct minimod_mod, more));
+
+
+// game_id is only part of user-events
+static struct field const l_event_fields[] = {
+	FIELD(struct minimod_event, id, "id", FIELD_UINT64),
+	FIELD(struct minimod_event, game_id, "game_id", FIELD_UINT64),
+	FIELD(struct minimod_event, mod_id, "mod_id", FIELD_UINT64),
+	FIELD(struct minimod_event, user_id, "user_id", FIELD_UINT64),
+	FIELD(struct minimod_event, date_added, "date_added", FIELD_UINT64),
+	FIELD(struct minimod_event, type, "event_type", FIELD_EVENTTYPE),
+};
+static struct schema l_event_schema =
+  SCHEMA(l_event_fields, offsetof(struct minimod_event, more));
+
+
+static struct schema *const l_schemas[] = {
+	&l_game_schema,
+	&l_user_schema,
+	&l_stats_schema,
+	&l_filehash_schema,
+	&l_download_schema,
+	&l_modfile_schema,
+	&l_mod_modfile_schema,
+	&l_mod_schema,
+	&l_event_schema,
+};
+
+
+static uint32_t
+hash_key(char const *in_key, size_t in_len, uint32_t in_seed)
+{
+	// only samples the length and a few characters, most keys of an object
+	// are of no interest and this way are dismissed quickly
+	uint32_t sample = (uint32_t)in_len;
+	if (in_len > 0)
+	{
+		sample |= (uint32_t)(uint8_t)in_key[0] << 8 |
+		  (uint32_t)(uint8_t)in_key[in_len / 2] << 16 |
+		  (uint32_t)(uint8_t)in_key[in_len - 1] << 24;
+	}
+	return (sample * in_seed) >> (32 - SCHEMA_SLOT_BITS);
+}
+
+
+// searches for a seed that puts every key of the schema into a slot
+// of its own
+static void
+prepare_schema(struct schema *schema)
+{
+	ASSERT(schema->nfields < SCHEMA_SLOTS);
+
+	for (uint32_t seed = 0x9e3779b1u; seed < 0x9e3779b1u + (1u << 24);
+		 seed += 2)
+	{
+		memset(schema->slots, 0, sizeof schema->slots);
+		size_t i = 0;
+		for (; i < schema->nfields; ++i)
+		{
+			struct field const *field = &schema->fields[i];
+			uint32_t const slot = hash_key(field->key, field->key_len, seed);
+			if (schema->slots[slot])
+			{
+				break;
+			}
+			schema->slots[slot] = (uint8_t)(i + 1);
+		}
+		if (i == schema->nfields)
+		{
+			schema->seed = seed;
+			return;
+		}
+	}
+
+	// two keys share the sampled characters
+	ASSERT(false);
+}
+
+
+static void
+prepare_schemas(void)
+{
+	for (size_t i = 0; i < sizeof l_schemas / sizeof *l_schemas; ++i)
+	{
+		if (l_schemas[i]->seed == 0)
+		{
+			prepare_schema(l_schemas[i]);
+		}
+	}
+}
+
+
+static struct field const *
+find_field(struct schema const *schema, char const *in_key, size_t in_len)
+{
+	uint8_t const slot = schema->slots[hash_key(in_key, in_len, schema->seed)];
+	if (slot == 0)
+	{
+		return NULL;
+	}
+	struct field const *field = &schema->fields[slot - 1];
+	if (field->key_len != in_len || 0 != memcmp(field->key, in_key, in_len))
+	{
+		return NULL;
+	}
+	return field;
+}
+
+
+static enum minimod_eventtype
+parse_eventtype(char const *in_type, size_t in_len)
+{
+	// perfect hash of the known types, from their 9th character and
+	// their length
+	static struct
+	{
+		char const *name;
+		size_t len;
+		enum minimod_eventtype type;
+		char _padding[4];
+	} const types[16] = {
+#define EVENTTYPE(SLOT, NAME, TYPE) \
+	[SLOT] = { .name = NAME, .len = sizeof NAME - 1, .type = TYPE }
+		EVENTTYPE(3, "USER_TEAM_JOIN", MINIMOD_EVENTTYPE_TEAM_JOIN),
+		EVENTTYPE(5, "USER_UNSUBSCRIBE", MINIMOD_EVENTTYPE_UNSUBSCRIBE),
+		EVENTTYPE(7, "MOD_EDITED", MINIMOD_EVENTTYPE_MOD_EDITED),
+		EVENTTYPE(8, "USER_TEAM_LEAVE", MINIMOD_EVENTTYPE_TEAM_LEAVE),
+		EVENTTYPE(9, "USER_SUBSCRIBE", MINIMOD_EVENTTYPE_SUBSCRIBE),
+		EVENTTYPE(11, "MOD_DELETED", MINIMOD_EVENTTYPE_MOD_DELETED),
+		EVENTTYPE(12, "MOD_UNAVAILABLE", MINIMOD_EVENTTYPE_MOD_UNAVAILABLE),
+		EVENTTYPE(13, "MOD_AVAILABLE", MINIMOD_EVENTTYPE_MOD_AVAILABLE),
+		EVENTTYPE(14, "MODFILE_CHANGED", MINIMOD_EVENTTYPE_MODFILE_CHANGED),
+#undef EVENTTYPE
+	};
+
+	if (in_len < 9)
+	{
+		return MINIMOD_EVENTTYPE_UNKNOWN;
+	}
+	size_t const slot = ((uint8_t)in_type[8] + in_len * 5) & 15;
+	if (
+	  types[slot].len != in_len ||
+	  0 != memcmp(types[slot].name, in_type, in_len))
+	{
+		return MINIMOD_EVENTTYPE_UNKNOWN;
+	}
+	return types[slot].type;
+}
+
+
+static void *
+field_ptr(void *in_struct, size_t in_offset)
+{
+	return (char *)in_struct + in_offset;
+}
+
+
+// sets everything the schema maps to, for keys missing from the object
+static void
+clear_schema(struct schema const *schema, void *out)
+{
+	if (schema->more != NO_MORE)
+	{
+		*(void const **)field_ptr(out, schema->more) = NULL;
+	}
+	for (size_t i = 0; i < schema->nfields; ++i)
+	{
+		struct field const *field = &schema->fields[i];
+		void *dst = field_ptr(out, field->offset);
+		switch (field->type)
+		{
+		case FIELD_UINT64:
+			*(uint64_t *)dst = 0;
+			break;
+		case FIELD_STRING:
+			*(char const **)dst = "";
+			break;
+		case FIELD_MODSTATUS:
+			*(enum minimod_modstatus *)dst = MINIMOD_MODSTATUS_NOT_ACCEPTED;
+			break;
+		case FIELD_EVENTTYPE:
+			*(enum minimod_eventtype *)dst = MINIMOD_EVENTTYPE_UNKNOWN;
+			break;
+		case FIELD_OBJECT:
+			clear_schema(field->object, dst);
+			break;
+		}
+	}
+}
+
+
+static void
+extract(struct schema const *schema, void *out, QAJ4C_Value const *node)
+{
+	if (schema->more != NO_MORE)
+	{
+		*(void const **)field_ptr(out, schema->more) = node;
+	}
+
+	size_t const nmembers = QAJ4C_object_size(node);
+	for (size_t i = 0; i < nmembers; ++i)
+	{
+		QAJ4C_Member const *member = QAJ4C_object_get_member(node, i);
+		QAJ4C_Value const *key = QAJ4C_member_get_key(member);
+		struct field const *field = find_field(
+		  schema,
+		  QAJ4C_get_string(key),
+		  QAJ4C_get_string_length(key));
+		if (!field)
+		{
+			continue;
+		}
+
+		QAJ4C_Value const *value = QAJ4C_member_get_value(member);
+		void *dst = field_ptr(out, field->offset);
+		switch (field->type)
+		{
+		case FIELD_UINT64:
+			if (QAJ4C_is_uint64(value))
+			{
+				*(uint64_t *)dst = QAJ4C_get_uint64(value);
+			}
+			break;
+		case FIELD_STRING:
+			if (QAJ4C_is_string(value))
+			{
+				*(char const **)dst = QAJ4C_get_string(value);
+			}
+			break;
+		case FIELD_MODSTATUS:
+			if (QAJ4C_is_int(value))
+			{
+				*(enum minimod_modstatus *)dst =
+				  (enum minimod_modstatus)QAJ4C_get_int(value);
+			}
+			break;
+		case FIELD_EVENTTYPE:
+			if (QAJ4C_is_string(value))
+			{
+				*(enum minimod_eventtype *)dst = parse_eventtype(
+				  QAJ4C_get_string(value),
+				  QAJ4C_get_string_length(value));
+			}
+			break;
+		case FIELD_OBJECT:
+			if (QAJ4C_is_object(value))
+			{
+				extract(field->object, dst, value);
+			}
+			break;
+		}
+	}
+}
+
+
+static void
+populate(struct schema const *schema, void *out, QAJ4C_Value const *node)
+{
+	ASSERT(out);
+	ASSERT(QAJ4C_is_object(node));
+	ASSERT(schema->seed != 0);
+
+	clear_schema(schema, out);
+	extract(schema, out, node);
+}
+
+
+static void
+populate_game(struct minimod_game *game, QAJ4C_Value const *node)
+{
+	populate(&l_game_schema, game, node);
+}
+
+
+static void
+populate_user(struct minimod_user *user, QAJ4C_Value const *node)
+{
+	populate(&l_user_schema, user, node);
+}
+
+
+static void
+populate_modfile(struct minimod_modfile *modfile, QAJ4C_Value const *node)
+{
+	populate(&l_modfile_schema, modfile, node);
+}
+
+
+static void
+populate_mod(struct minimod_mod *mod, QAJ4C_Value const *node)
+{
+	populate(&l_mod_schema, mod, node);
+}
+
+
+static void
+populate_event(struct minimod_event *event, QAJ4C_Value const *node)
+{
+	populate(&l_event_schema, event, node);
+}
+
+
+static void
+populate_rating(struct minimod_rating *rating, QAJ4C_Value const *node)
+{
+	rating->game_id = QAJ4C_get_uint64(QAJ4C_object_get(node, "game_id"));
+	rating->mod_id = QAJ4C_get_uint64(QAJ4C_object_get(node, "mod_id"));
+	rating->date = QAJ4C_get_uint64(QAJ4C_object_get(node, "date_added"));
+	rating->rating = QAJ4C_get_int(QAJ4C_object_get(node, "rating"));
+}
+
+
+static void
+populate_pagination(struct minimod_pagination *pagi, QAJ4C_Value const *node)
+{
+	pagi->offset = QAJ4C_get_uint64(QAJ4C_object_get(node, "result_offset"));
+	pagi->limit = QAJ4C_get_uint64(QAJ4C_object_get(node, "result_limit"));
+	pagi->total = QAJ4C_get_uint64(QAJ4C_object_get(node, "result_total"));
+}
+
+
+static void
+handle_generic_errors(
+  int error,
+  struct netw_header const *header,
+  bool is_token_auth)
+{
+	if (error == 429) // too many requests
+	{
+		char const *retry_after =
+		  transport_get_header(header, "X-RateLimit-RetryAfter");
+		long retry_after_l = strtol(retry_after, NULL, 10);
+		LOG("X-RateLimit-RetryAfter: %li seconds", retry_after_l);
+		l_mmi.rate_limited_until = sys_seconds() + retry_after_l;
+	}
+	if (error == 401)
+	{
+		if (is_token_auth)
+		{
+			LOG("Received HTTP Status 401 -> OAUTH2 Token Invalid");
+			minimod_deauthenticate();
+		}
+		else
+		{
+			LOG("Received HTTP Status 401 -> API Key Invalid");
+			l_mmi.is_apikey_invalid = true;
+		}
+	}
+}
+
+
+// gzip member header flags, RFC 1952
+enum gzip_flag
+{
+	GZIP_FLAG_HCRC = 2,
+	GZIP_FLAG_EXTRA = 4,
+	GZIP_FLAG_NAME = 8,
+	GZIP_FLAG_COMMENT = 16,
+};
+
+
+static uint32_t
+read_le32(uint8_t const *in)
+{
+	return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) |
+	  ((uint32_t)in[3] << 24);
+}
+
+
+static bool
+is_gzip(uint8_t const *in, size_t in_len)
+{
+	return in_len >= 2 && in[0] == 0x1f && in[1] == 0x8b;
+}
+
+
+static bool
+is_zlib(uint8_t const *in, size_t in_len)
+{
+	// compression method 8 (deflate), window <= 32K and header checksum.
+	// JSON always starts with whitespace, '{' or '[', none of which pass.
+	return in_len >= 2 && (in[0] & 0x0f) == 8 && (in[0] >> 4) <= 7 &&
+	  ((in[0] << 8) | in[1]) % 31 == 0;
+}
+
+
+static void *
+inflate_to_heap(
+  uint8_t const *in,
+  size_t in_len,
+  size_t *out_len,
+  int in_flags);
+
+
+static void *
+gunzip(uint8_t const *in, size_t in_len, size_t *out_len)
+{
+	// 10 bytes header, 8 bytes trailer
+	if (in_len < 18 || in[2] != 8 /* deflate */)
+	{
+		return NULL;
+	}
+
+	uint8_t const flags = in[3];
+	size_t pos = 10;
+	if (flags & GZIP_FLAG_EXTRA)
+	{
+		pos += 2 + (size_t)(in[pos] | (in[pos + 1] << 8));
+	}
+	if (flags & GZIP_FLAG_NAME)
+	{
+		while (pos < in_len && in[pos++])
+		{
+		}
+	}
+	if (flags & GZIP_FLAG_COMMENT)
+	{
+		while (pos < in_len && in[pos++])
+		{
+		}
+	}
+	if (flags & GZIP_FLAG_HCRC)
+	{
+		pos += 2;
+	}
+	if (pos + 8 > in_len)
+	{
+		return NULL;
+	}
+
+	// the trailer contains the size of the uncompressed data,
+	// so the output can be decompressed in one go without reallocations.
+	uint8_t const *trailer = in + in_len - 8;
+	uint32_t const crc = read_le32(trailer);
+	size_t const size = read_le32(trailer + 4);
+	// deflate cannot compress better than ~1:1032
+	if (size > (in_len - pos) * 1032)
+	{
+		return NULL;
+	}
+
+	// the size is up to the server, thusly it is only trusted as far as
+	// JSON compresses. beyond that the output grows as it is inflated.
+	uint8_t const *body = in + pos;
+	size_t const body_len = in_len - 8 - pos;
+	uint8_t *out;
+	size_t n;
+	if (size <= body_len * GZIP_MAX_RATIO)
+	{
+		out = mem_alloc(size + 1);
+		if (!out)
+		{
+			return NULL;
+		}
+		n = tinfl_decompress_mem_to_mem(out, size, body, body_len, 0);
+	}
+	else
+	{
+		out = inflate_to_heap(body, body_len, &n, 0);
+	}
+	if (!out || n != size || mz_crc32(MZ_CRC32_INIT, out, n) != crc)
+	{
+		mem_free(out);
+		return NULL;
+	}
+
+	*out_len = n;
+	return out;
+}
+
+
+// like tinfl_decompress_mem_to_heap(), but allocates through mem_*()
+static void *
+inflate_to_heap(
+  uint8_t const *in,
+  size_t in_len,
+  size_t *out_len,
+  int in_flags)
+{
+	tinfl_decompressor decompressor;
+	tinfl_init(&decompressor);
+	uint8_t *out = NULL;
+	size_t capacity = 0;
+	size_t pos = 0;
+	*out_len = 0;
+	for (;;)
+	{
+		size_t nin = in_len - pos;
+		size_t nout = capacity - *out_len;
+		tinfl_status const status = tinfl_decompress(
+		  &decompressor,
+		  in + pos,
+		  &nin,
+		  out,
+		  out ? out + *out_len : NULL,
+		  &nout,
+		  in_flags | TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+		if (status < 0 || status == TINFL_STATUS_NEEDS_MORE_INPUT)
+		{
+			break;
+		}
+		pos += nin;
+		*out_len += nout;
+		if (status == TINFL_STATUS_DONE)
+		{
+			return out;
+		}
+
+		capacity = capacity < 128 ? 128 : capacity * 2;
+		uint8_t *grown = mem_realloc(out, capacity);
+		if (!grown)
+		{
+			break;
+		}
+		out = grown;
+	}
+
+	mem_free(out);
+	*out_len = 0;
+	return NULL;
+}
+
+
+// API requests are sent with "Accept-Encoding: gzip, deflate".
+// If the body is compressed *out_data is set to the decoded body, which
+// has to be mem_free()d. Otherwise it is set to NULL.
+//
+// The encoding is detected by looking at the data, since some platforms
+// (macOS) decode transparently, but keep the Content-Encoding header.
+//
+// Returns:
+//	false if the body is compressed, but could not be decoded.
+static bool
+decode_body(
+  void const *in_data,
+  size_t in_len,
+  struct netw_header const *header,
+  void **out_data,
+  size_t *out_len)
+{
+	uint8_t const *in = in_data;
+	*out_data = NULL;
+
+	if (is_gzip(in, in_len))
+	{
+		*out_data = gunzip(in, in_len, out_len);
+	}
+	else if (is_zlib(in, in_len))
+	{
+		*out_data =
+		  inflate_to_heap(in, in_len, out_len, TINFL_FLAG_PARSE_ZLIB_HEADER);
+	}
+	else
+	{
+		// raw deflate streams cannot be told apart from uncompressed data,
+		// thusly they are only decoded if the server says so.
+		char const *encoding =
+		  header ? transport_get_header(header, "Content-Encoding") : NULL;
+		if (!encoding || 0 != strcmp(encoding, "deflate") || in_len == 0 ||
+		  in[0] == '{' || in[0] == '[')
+		{
+			return true;
+		}
+		*out_data = inflate_to_heap(in, in_len, out_len, 0);
+	}
+
+	return *out_data;
+}
+
+
+static void
+on_api_response(
+  void *in_udata,
+  void const *in_data,
+  size_t in_len,
+  int error,
+  struct netw_header const *header)
+{
+	struct task *task = in_udata;
+	uint64_t const received =
+	  stats_record(task->endpoint, MINIMOD_PHASE_NETWORK, task->issued);
+	stats_count_response(task->endpoint, error, in_len);
+
+	void *decoded = NULL;
+	size_t ndecoded = 0;
+	bool const ok = decode_body(in_data, in_len, header, &decoded, &ndecoded);
+	if (decoded)
+	{
+		stats_record(task->endpoint, MINIMOD_PHASE_DECODE, received);
+	}
+
+	if (!ok)
+	{
+		LOGE("could not decode response (%zu bytes)", in_len);
+		// handle it like a broken response from the server
+		task->handler(task, NULL, 0, 500, header);
+	}
+	else if (decoded)
+	{
+		LOG("decoded response: %zu -> %zu bytes", in_len, ndecoded);
+		task->handler(task, decoded, ndecoded, error, header);
+		mem_free(decoded);
+	}
+	else
+	{
+		task->handler(task, in_data, in_len, error, header);
+	}
+}
+
+
+// transport_request() for the mod.io API: the response is decoded before it
+// is passed on to in_handler.
+static bool
+api_request(
+  enum minimod_endpoint in_endpoint,
+  enum netw_verb in_verb,
+  char const *in_uri,
+  char const *const in_headers[],
+  void const *in_body,
+  size_t in_nbody,
+  response_handler in_handler,
+  struct task *in_task)
+{
+	in_task->handler = in_handler;
+	in_task->endpoint = in_endpoint;
+	in_task->issued = sys_nanoseconds();
+	trace_instant("request", endpoint_names[in_endpoint], 0);
+	return transport_request(
+	  in_verb,
+	  in_uri,
+	  in_headers,
+	  in_body,
+	  in_nbody,
+	  on_api_response,
+	  in_task);
+}
+
+
+// MINIMOD_JSONTREE_ENABLE builds the tree from the structural characters
+// instead, see jsontree.h
+static size_t
+json_buffer_size(void const *in_data, size_t in_len)
+{
+#ifdef MINIMOD_JSONTREE_ENABLE
+	return jsontree_buffer_size(in_data, in_len);
+#else
+	return QAJ4C_calculate_max_buffer_size_n(in_data, in_len);
+#endif
 }
 
 
-static void
-populate_stats(struct minimod_stats *stats, QAJ4C_Value const *node)
+static QAJ4C_Value const *
+parse_into(
+  void const *in_data,
+  size_t in_len,
+  void *out_buffer,
+  size_t in_size)
 {
-	ASSERT(stats);
-	ASSERT(QAJ4C_is_object(node));
-
-	stats->mod_id = QAJ4C_get_uint64(QAJ4C_object_get(node, "mod_id"));
-	stats->ndownloads =
-	  QAJ4C_get_uint64(QAJ4C_object_get(node, "downloads_total"));
-	stats->nsubscribers =
-	  QAJ4C_get_uint64(QAJ4C_object_get(node, "subscribers_total"));
-	stats->nratings_positive =
-	  QAJ4C_get_uint64(QAJ4C_object_get(node, "ratings_positive"));
-	stats->nratings_negative =
-	  QAJ4C_get_uint64(QAJ4C_object_get(node, "ratings_negative"));
-
-	stats->more = node;
+#ifdef MINIMOD_JSONTREE_ENABLE
+	return jsontree_parse(in_data, in_len, out_buffer, in_size);
+#else
+	QAJ4C_Value const *document = NULL;
+	QAJ4C_parse_opt(in_data, in_len, 0, out_buffer, in_size, &document);
+	return document;
+#endif
 }
 
 
-static void
-populate_modfile(struct minimod_modfile *modfile, QAJ4C_Value const *node)
+static QAJ4C_Value const *
+parse_json(void const *in_data, size_t in_len)
 {
-	ASSERT(modfile);
-	ASSERT(QAJ4C_is_object(node));
+	size_t nbuffer = json_buffer_size(in_data, in_len);
+	void *buffer = arena_alloc(nbuffer);
+	return parse_into(in_data, in_len, buffer, nbuffer);
+}
 
-	modfile->id = QAJ4C_get_uint64(QAJ4C_object_get(node, "id"));
-	modfile->mod_id = QAJ4C_get_uint64(QAJ4C_object_get(node, "mod_id"));
-	modfile->date_added =
-	  QAJ4C_get_uint64(QAJ4C_object_get(node, "date_added"));
-	modfile->filesize = QAJ4C_get_uint64(QAJ4C_object_get(node, "filesize"));
 
-	QAJ4C_Value const *filehash = QAJ4C_object_get(node, "filehash");
-	modfile->md5 = QAJ4C_get_string(QAJ4C_object_get(filehash, "md5"));
+// like parse_json(), but into a document of its own, which is kept alive
+// by the caller's reference and minimod_retain()
+static QAJ4C_Value const *
+parse_document(void const *in_data, size_t in_len, struct document **out_doc)
+{
+	size_t nbuffer = json_buffer_size(in_data, in_len);
+	struct document *doc = open_document(nbuffer);
+	ASSERT(doc);
+	*out_doc = doc;
+	return parse_into(in_data, in_len, doc + 1, nbuffer);
+}
 
-	QAJ4C_Value const *download = QAJ4C_object_get(node, "download");
-	modfile->url = QAJ4C_get_string(QAJ4C_object_get(download, "binary_url"));
 
-	modfile->more = node;
+// the returned document is valid until *out_doc* is released.
+static QAJ4C_Value const *
+parse_response(
+  struct task const *in_task,
+  void const *in_data,
+  size_t in_len,
+  struct document **out_doc)
+{
+	uint64_t const start = sys_nanoseconds();
+	QAJ4C_Value const *document = parse_document(in_data, in_len, out_doc);
+	stats_record(in_task->endpoint, MINIMOD_PHASE_PARSE, start);
+	return document;
 }
 
 
-static void
-populate_mod(struct minimod_mod *mod, QAJ4C_Value const *node)
+// finds the bounds of JSON values without parsing them, so that the items
+// of list responses can be parsed one by one. only the structural
+// characters are visited, see jsonindex.h.
+struct scan
 {
-	ASSERT(mod);
-	ASSERT(QAJ4C_is_object(node));
+	struct jsonindex index;
+	// the structural character moved past last
+	size_t pos;
+};
 
-	mod->id = QAJ4C_get_uint64(QAJ4C_object_get(node, "id"));
-	mod->game_id = QAJ4C_get_uint64(QAJ4C_object_get(node, "game_id"));
-	mod->date_updated =
-	  QAJ4C_get_uint64(QAJ4C_object_get(node, "date_updated"));
-	mod->name = QAJ4C_get_string(QAJ4C_object_get(node, "name"));
-	mod->summary = QAJ4C_get_string(QAJ4C_object_get(node, "summary"));
-	mod->status = (enum minimod_modstatus)(
-	  QAJ4C_get_int(QAJ4C_object_get(node, "status")));
-	mod->more = node;
 
-	// modfile
-	QAJ4C_Value const *modfile = QAJ4C_object_get(node, "modfile");
-	ASSERT(QAJ4C_is_object(modfile));
-	QAJ4C_Value const *modfile_id = QAJ4C_object_get(modfile, "id");
-	if (modfile_id)
+static bool
+scan_char(struct scan *scan, char in_c)
+{
+	size_t const pos = jsonindex_peek(&scan->index);
+	if (pos >= scan->index.len || scan->index.text[pos] != in_c)
 	{
-		QAJ4C_is_uint64(modfile_id);
-		mod->modfile_id = QAJ4C_get_uint64(modfile_id);
+		return false;
 	}
+	scan->pos = jsonindex_next(&scan->index);
+	return true;
+}
 
-	// submitted_by
-	QAJ4C_Value const *submitted_by = QAJ4C_object_get(node, "submitted_by");
-	ASSERT(QAJ4C_is_object(submitted_by));
-	populate_user(&mod->submitted_by, submitted_by);
 
-	// stats
-	QAJ4C_Value const *stats = QAJ4C_object_get(node, "stats");
-	ASSERT(QAJ4C_is_object(stats));
-	populate_stats(&mod->stats, stats);
+// moves up to the ',', '}' or ']' following the value, which starts after
+// pos. pos is set to that character, without moving past it.
+static bool
+scan_value(struct scan *scan)
+{
+	size_t depth = 0;
+	for (;;)
+	{
+		size_t const pos = jsonindex_peek(&scan->index);
+		if (pos >= scan->index.len)
+		{
+			scan->pos = pos;
+			return false;
+		}
+		char const c = scan->index.text[pos];
+		if (depth == 0 && (c == ',' || c == '}' || c == ']'))
+		{
+			scan->pos = pos;
+			return true;
+		}
+		jsonindex_next(&scan->index);
+		if (c == '{' || c == '[')
+		{
+			++depth;
+		}
+		else if (c == '}' || c == ']')
+		{
+			--depth;
+		}
+	}
 }
 
 
-static void
-populate_event(struct minimod_event *event, QAJ4C_Value const *node)
+// moves past the '[' of the document's "data" array
+static bool
+scan_to_data(struct scan *scan)
 {
-	ASSERT(event);
-	ASSERT(QAJ4C_is_object(node));
+	if (!scan_char(scan, '{'))
+	{
+		return false;
+	}
+	do
+	{
+		size_t const key = jsonindex_peek(&scan->index);
+		if (!scan_char(scan, '"') || !scan_char(scan, '"'))
+		{
+			return false;
+		}
+		size_t const nkey = scan->pos + 1 - key;
+		bool const is_data = nkey == sizeof "\"data\"" - 1 &&
+		  0 == memcmp(scan->index.text + key, "\"data\"", nkey);
+		if (!scan_char(scan, ':'))
+		{
+			return false;
+		}
+		if (is_data)
+		{
+			return scan_char(scan, '[');
+		}
+		if (!scan_value(scan))
+		{
+			return false;
+		}
+	} while (scan_char(scan, ','));
+	return false;
+}
 
-	event->id = QAJ4C_get_uint64(QAJ4C_object_get(node, "id"));
 
-	// game_id is only part of user-events
-	QAJ4C_Value const *game_id = QAJ4C_object_get(node, "game_id");
-	if (game_id)
+// returns false at the end of the array, with pos at its ']'
+static bool
+scan_item(struct scan *scan, char const **out_item, size_t *out_len)
+{
+	char const *text = scan->index.text;
+	if (scan->pos >= scan->index.len || text[scan->pos] == ']')
 	{
-		event->game_id = QAJ4C_get_uint64(game_id);
+		return false;
 	}
-	else
+	size_t start = scan->pos + 1;
+	if (!scan_value(scan) || text[scan->pos] == '}')
 	{
-		event->game_id = 0;
+		return false;
 	}
-	event->mod_id = QAJ4C_get_uint64(QAJ4C_object_get(node, "mod_id"));
-	event->user_id = QAJ4C_get_uint64(QAJ4C_object_get(node, "user_id"));
-	event->date_added = QAJ4C_get_uint64(QAJ4C_object_get(node, "date_added"));
-
-	// uses string length in comparisons first to save on strcmp()s
-	event->type = MINIMOD_EVENTTYPE_UNKNOWN;
-	QAJ4C_Value const *event_type = QAJ4C_object_get(node, "event_type");
-	size_t et_len = QAJ4C_get_string_length(event_type);
-	char const *et = QAJ4C_get_string(event_type);
-	if (et_len == 15 && 0 == strcmp(et, "MODFILE_CHANGED"))
+	size_t end = scan->pos;
+	while (start < end && isspace((uint8_t)text[start]))
 	{
-		event->type = MINIMOD_EVENTTYPE_MODFILE_CHANGED;
+		++start;
 	}
-	else if (et_len == 14 && 0 == strcmp(et, "USER_SUBSCRIBE"))
+	while (end > start && isspace((uint8_t)text[end - 1]))
 	{
-		event->type = MINIMOD_EVENTTYPE_SUBSCRIBE;
+		--end;
 	}
-	else if (et_len == 16 && 0 == strcmp(et, "USER_UNSUBSCRIBE"))
+	if (start == end)
 	{
-		event->type = MINIMOD_EVENTTYPE_UNSUBSCRIBE;
+		return false;
 	}
-	else if (et_len == 13 && 0 == strcmp(et, "MOD_AVAILABLE"))
+	*out_item = text + start;
+	*out_len = end - start;
+	scan_char(scan, ',');
+	return true;
+}
+
+
+// passes populated items on to the task's callback
+typedef void (*batch_callback)(
+  struct task const *task,
+  size_t nitems,
+  void const *items,
+  struct minimod_pagination const *pagi);
+
+
+// delivers the items of a list response in batches of l_batch_size.
+// the items are parsed one by one into documents of their own, so the
+// first batch does not wait for the whole response to be parsed.
+// the pagination is taken from the document without its items, once all
+// of them are delivered.
+//
+// Returns:
+//	false if batches are off for the task, or if the response has no
+//	"data" array. nothing is delivered then.
+static bool
+deliver_batches(
+  struct task const *task,
+  void const *in_data,
+  size_t in_len,
+  struct schema const *schema,
+  size_t in_item_size,
+  batch_callback in_callback)
+{
+	size_t const batch_size = __atomic_load_n(&l_batch_size, __ATOMIC_RELAXED);
+	if (batch_size == 0 || (task->flags & TASK_FLAG_NO_BATCHES))
 	{
-		event->type = MINIMOD_EVENTTYPE_MOD_AVAILABLE;
+		return false;
 	}
-	else if (et_len == 15 && 0 == strcmp(et, "MOD_UNAVAILABLE"))
+
+	struct scan scan = { .pos = 0 };
+	jsonindex_init(&scan.index, in_data, in_len);
+	if (!scan_to_data(&scan))
 	{
-		event->type = MINIMOD_EVENTTYPE_MOD_UNAVAILABLE;
+		return false;
 	}
-	else if (et_len == 10 && 0 == strcmp(et, "MOD_EDITED"))
+	size_t const data_start = scan.pos + 1;
+	struct arena_mark const mark = arena_mark();
+	char *items = arena_calloc(batch_size, in_item_size);
+	struct document **docs = arena_calloc(batch_size, sizeof *docs);
+	ASSERT(items && docs);
+
+	size_t nitems = 0;
+	uint64_t populate_start = sys_nanoseconds();
+	char const *item;
+	size_t nitem;
+	while (scan_item(&scan, &item, &nitem))
 	{
-		event->type = MINIMOD_EVENTTYPE_MOD_EDITED;
+		QAJ4C_Value const *node = parse_document(item, nitem, &docs[nitems]);
+		if (!QAJ4C_is_object(node))
+		{
+			LOGE("skipping malformed item (%zu bytes)", nitem);
+			release_document(docs[nitems]);
+			continue;
+		}
+		populate(schema, items + nitems * in_item_size, node);
+
+		if (++nitems == batch_size)
+		{
+			uint64_t const populated = stats_record(
+			  task->endpoint,
+			  MINIMOD_PHASE_POPULATE,
+			  populate_start);
+			in_callback(task, nitems, items, NULL);
+			stats_record(task->endpoint, MINIMOD_PHASE_CALLBACK, populated);
+
+			for (size_t i = 0; i < nitems; ++i)
+			{
+				release_document(docs[i]);
+			}
+			nitems = 0;
+			populate_start = sys_nanoseconds();
+		}
 	}
-	else if (et_len == 11 && 0 == strcmp(et, "MOD_DELETED"))
+
+	// the document without its items, "data" becomes an empty array
+	struct minimod_pagination pagi = { 0 };
+	if (scan.pos < in_len && ((char const *)in_data)[scan.pos] == ']')
 	{
-		event->type = MINIMOD_EVENTTYPE_MOD_DELETED;
+		size_t const ntail = in_len - scan.pos;
+		char *rest = arena_alloc(data_start + ntail);
+		ASSERT(rest);
+		memcpy(rest, in_data, data_start);
+		memcpy(rest + data_start, (char const *)in_data + scan.pos, ntail);
+		QAJ4C_Value const *document = parse_json(rest, data_start + ntail);
+		if (QAJ4C_is_object(document))
+		{
+			populate_pagination(&pagi, document);
+		}
 	}
-	else if (et_len == 14 && 0 == strcmp(et, "USER_TEAM_JOIN"))
+	else
 	{
-		event->type = MINIMOD_EVENTTYPE_TEAM_JOIN;
+		LOGE("list response ends within its items");
 	}
-	else if (et_len == 15 && 0 == strcmp(et, "USER_TEAM_LEAVE"))
+	uint64_t const populated =
+	  stats_record(task->endpoint, MINIMOD_PHASE_POPULATE, populate_start);
+	in_callback(task, nitems, items, &pagi);
+	stats_record(task->endpoint, MINIMOD_PHASE_CALLBACK, populated);
+
+	for (size_t i = 0; i < nitems; ++i)
 	{
-		event->type = MINIMOD_EVENTTYPE_MOD_DELETED;
+		release_document(docs[i]);
 	}
-
-	event->more = node;
+	arena_release(mark);
+	return true;
 }
 
 
 static void
-populate_rating(struct minimod_rating *rating, QAJ4C_Value const *node)
+deliver_games(
+  struct task const *task,
+  size_t nitems,
+  void const *items,
+  struct minimod_pagination const *pagi)
 {
-	rating->game_id = QAJ4C_get_uint64(QAJ4C_object_get(node, "game_id"));
-	rating->mod_id = QAJ4C_get_uint64(QAJ4C_object_get(node, "mod_id"));
-	rating->date = QAJ4C_get_uint64(QAJ4C_object_get(node, "date_added"));
-	rating->rating = QAJ4C_get_int(QAJ4C_object_get(node, "rating"));
+	task->callback.fptr
+	  .get_games(task->callback.userdata, nitems, items, pagi);
 }
 
 
 static void
-populate_pagination(struct minimod_pagination *pagi, QAJ4C_Value const *node)
+deliver_mod_columns(
+  struct task const *task,
+  size_t nmods,
+  struct minimod_mod const *mods,
+  struct minimod_pagination const *pagi)
 {
-	pagi->offset = QAJ4C_get_uint64(QAJ4C_object_get(node, "result_offset"));
-	pagi->limit = QAJ4C_get_uint64(QAJ4C_object_get(node, "result_limit"));
-	pagi->total = QAJ4C_get_uint64(QAJ4C_object_get(node, "result_total"));
+	struct arena_mark const mark = arena_mark();
+	uint64_t *id = arena_alloc(nmods * sizeof *id);
+	uint64_t *game_id = arena_alloc(nmods * sizeof *game_id);
+	uint64_t *modfile_id = arena_alloc(nmods * sizeof *modfile_id);
+	uint64_t *date_updated = arena_alloc(nmods * sizeof *date_updated);
+	uint64_t *ndownloads = arena_alloc(nmods * sizeof *ndownloads);
+	uint64_t *nsubscribers = arena_alloc(nmods * sizeof *nsubscribers);
+	uint64_t *npositive = arena_alloc(nmods * sizeof *npositive);
+	uint64_t *nnegative = arena_alloc(nmods * sizeof *nnegative);
+	enum minimod_modstatus *status = arena_alloc(nmods * sizeof *status);
+	char const **name = arena_alloc(nmods * sizeof *name);
+	char const **summary = arena_alloc(nmods * sizeof *summary);
+	void const **more = arena_alloc(nmods * sizeof *more);
+	ASSERT(id && game_id && modfile_id && date_updated && ndownloads);
+	ASSERT(nsubscribers && npositive && nnegative && status && name);
+	ASSERT(summary && more);
+
+	for (size_t i = 0; i < nmods; ++i)
+	{
+		id[i] = mods[i].id;
+		game_id[i] = mods[i].game_id;
+		modfile_id[i] = mods[i].modfile_id;
+		date_updated[i] = mods[i].date_updated;
+		ndownloads[i] = mods[i].stats.ndownloads;
+		nsubscribers[i] = mods[i].stats.nsubscribers;
+		npositive[i] = mods[i].stats.nratings_positive;
+		nnegative[i] = mods[i].stats.nratings_negative;
+		status[i] = mods[i].status;
+		name[i] = mods[i].name;
+		summary[i] = mods[i].summary;
+		more[i] = mods[i].more;
+	}
+
+	struct minimod_mod_columns const columns = {
+		.count = nmods,
+		.id = id,
+		.game_id = game_id,
+		.modfile_id = modfile_id,
+		.date_updated = date_updated,
+		.ndownloads = ndownloads,
+		.nsubscribers = nsubscribers,
+		.nratings_positive = npositive,
+		.nratings_negative = nnegative,
+		.status = status,
+		.name = name,
+		.summary = summary,
+		.more = more,
+	};
+	task->callback.fptr
+	  .get_mods_columns(task->callback.userdata, &columns, pagi);
+	arena_release(mark);
 }
 
 
 static void
-handle_generic_errors(
-  int error,
-  struct netw_header const *header,
-  bool is_token_auth)
+deliver_mods(
+  struct task const *task,
+  size_t nitems,
+  void const *items,
+  struct minimod_pagination const *pagi)
 {
-	if (error == 429) // too many requests
-	{
-		char const *retry_after =
-		  netw_get_header(header, "X-RateLimit-RetryAfter");
-		long retry_after_l = strtol(retry_after, NULL, 10);
-		LOG("X-RateLimit-RetryAfter: %li seconds", retry_after_l);
-		l_mmi.rate_limited_until = sys_seconds() + retry_after_l;
-	}
-	if (error == 401)
+	if (task->flags & TASK_FLAG_COLUMNS)
 	{
-		if (is_token_auth)
-		{
-			LOG("Received HTTP Status 401 -> OAUTH2 Token Invalid");
-			minimod_deauthenticate();
-		}
-		else
-		{
-			LOG("Received HTTP Status 401 -> API Key Invalid");
-			l_mmi.is_apikey_invalid = true;
-		}
+		deliver_mod_columns(task, nitems, items, pagi);
+		return;
 	}
+	task->callback.fptr.get_mods(task->callback.userdata, nitems, items, pagi);
+}
+
+
+static void
+deliver_modfiles(
+  struct task const *task,
+  size_t nitems,
+  void const *items,
+  struct minimod_pagination const *pagi)
+{
+	task->callback.fptr
+	  .get_modfiles(task->callback.userdata, nitems, items, pagi);
+}
+
+
+static void
+deliver_events(
+  struct task const *task,
+  size_t nitems,
+  void const *items,
+  struct minimod_pagination const *pagi)
+{
+	task->callback.fptr
+	  .get_events(task->callback.userdata, nitems, items, pagi);
 }
 
 
@@ -467,10 +2889,22 @@ handle_get_games(
 		return;
 	}
 
-	size_t nbuffer = QAJ4C_calculate_max_buffer_size_n(in_data, in_len);
-	void *buffer = malloc(nbuffer);
-	QAJ4C_Value const *document = NULL;
-	QAJ4C_parse_opt(in_data, in_len, 0, buffer, nbuffer, &document);
+	if (deliver_batches(
+	      task,
+	      in_data,
+	      in_len,
+	      &l_game_schema,
+	      sizeof(struct minimod_game),
+	      deliver_games))
+	{
+		free_task(task);
+		return;
+	}
+
+	struct arena_mark const mark = arena_mark();
+	struct document *doc;
+	QAJ4C_Value const *document =
+	  parse_response(task, in_data, in_len, &doc);
 	ASSERT(QAJ4C_is_object(document));
 
 	QAJ4C_Value const *data = QAJ4C_object_get(document, "data");
@@ -478,8 +2912,9 @@ handle_get_games(
 	{
 		ASSERT(QAJ4C_is_array(data));
 
+		uint64_t const populate_start = sys_nanoseconds();
 		size_t ngames = QAJ4C_array_size(data);
-		struct minimod_game *games = calloc(sizeof *games, ngames);
+		struct minimod_game *games = arena_calloc(ngames, sizeof *games);
 
 		for (size_t i = 0; i < QAJ4C_array_size(data); ++i)
 		{
@@ -488,15 +2923,19 @@ handle_get_games(
 
 		struct minimod_pagination pagi;
 		populate_pagination(&pagi, document);
+		uint64_t const populated = stats_record(
+		  task->endpoint,
+		  MINIMOD_PHASE_POPULATE,
+		  populate_start);
 
 		task->callback.fptr
 		  .get_games(task->callback.userdata, ngames, games, &pagi);
-
-		free(games);
+		stats_record(task->endpoint, MINIMOD_PHASE_CALLBACK, populated);
 	}
 
 	free_task(task);
-	free(buffer);
+	release_document(doc);
+	arena_release(mark);
 }
 
 
@@ -512,16 +2951,28 @@ handle_get_mods(
 	handle_generic_errors(error, header, task->flags & TASK_FLAG_AUTH_TOKEN);
 	if (error != 200)
 	{
-		task->callback.fptr.get_mods(task->callback.userdata, 0, NULL, NULL);
+		deliver_mods(task, 0, NULL, NULL);
+		free_task(task);
+		return;
+	}
+
+	if (deliver_batches(
+	      task,
+	      in_data,
+	      in_len,
+	      &l_mod_schema,
+	      sizeof(struct minimod_mod),
+	      deliver_mods))
+	{
 		free_task(task);
 		return;
 	}
 
 	// parse data
-	QAJ4C_Value const *document = NULL;
-	size_t nbuffer = QAJ4C_calculate_max_buffer_size_n(in_data, in_len);
-	void *buffer = malloc(nbuffer);
-	QAJ4C_parse_opt(in_data, in_len, 0, buffer, nbuffer, &document);
+	struct arena_mark const mark = arena_mark();
+	struct document *doc;
+	QAJ4C_Value const *document =
+	  parse_response(task, in_data, in_len, &doc);
 	ASSERT(QAJ4C_is_object(document));
 
 	// single item or array of items?
@@ -530,8 +2981,9 @@ handle_get_mods(
 	{
 		ASSERT(QAJ4C_is_array(data));
 
+		uint64_t const populate_start = sys_nanoseconds();
 		size_t nmods = QAJ4C_array_size(data);
-		struct minimod_mod *mods = calloc(sizeof *mods, nmods);
+		struct minimod_mod *mods = arena_calloc(nmods, sizeof *mods);
 
 		for (size_t i = 0; i < QAJ4C_array_size(data); ++i)
 		{
@@ -540,20 +2992,29 @@ handle_get_mods(
 
 		struct minimod_pagination pagi;
 		populate_pagination(&pagi, document);
+		uint64_t const populated = stats_record(
+		  task->endpoint,
+		  MINIMOD_PHASE_POPULATE,
+		  populate_start);
 
-		task->callback.fptr
-		  .get_mods(task->callback.userdata, nmods, mods, &pagi);
-
-		free(mods);
+		deliver_mods(task, nmods, mods, &pagi);
+		stats_record(task->endpoint, MINIMOD_PHASE_CALLBACK, populated);
 	}
 	else
 	{
+		uint64_t const populate_start = sys_nanoseconds();
 		struct minimod_mod mod = { 0 };
 		populate_mod(&mod, document);
-		task->callback.fptr.get_mods(task->callback.userdata, 1, &mod, NULL);
+		uint64_t const populated = stats_record(
+		  task->endpoint,
+		  MINIMOD_PHASE_POPULATE,
+		  populate_start);
+		deliver_mods(task, 1, &mod, NULL);
+		stats_record(task->endpoint, MINIMOD_PHASE_CALLBACK, populated);
 	}
 	free_task(task);
-	free(buffer);
+	release_document(doc);
+	arena_release(mark);
 }
 
 
@@ -574,10 +3035,10 @@ handle_get_users(
 		return;
 	}
 
-	size_t nbuffer = QAJ4C_calculate_max_buffer_size_n(in_data, in_len);
-	void *buffer = malloc(nbuffer);
-	QAJ4C_Value const *document = NULL;
-	QAJ4C_parse_opt(in_data, in_len, 0, buffer, nbuffer, &document);
+	struct arena_mark const mark = arena_mark();
+	struct document *doc;
+	QAJ4C_Value const *document =
+	  parse_response(task, in_data, in_len, &doc);
 	ASSERT(QAJ4C_is_object(document));
 
 	// check for 'data' to see if it is a 'single' or 'multi' data object
@@ -586,8 +3047,9 @@ handle_get_users(
 	{
 		ASSERT(QAJ4C_is_array(data));
 
+		uint64_t const populate_start = sys_nanoseconds();
 		size_t nusers = QAJ4C_array_size(data);
-		struct minimod_user *users = calloc(sizeof *users, nusers);
+		struct minimod_user *users = arena_calloc(nusers, sizeof *users);
 
 		for (size_t i = 0; i < QAJ4C_array_size(data); ++i)
 		{
@@ -596,21 +3058,31 @@ handle_get_users(
 
 		struct minimod_pagination pagi;
 		populate_pagination(&pagi, document);
+		uint64_t const populated = stats_record(
+		  task->endpoint,
+		  MINIMOD_PHASE_POPULATE,
+		  populate_start);
 
 		task->callback.fptr
 		  .get_users(task->callback.userdata, nusers, users, &pagi);
-
-		free(users);
+		stats_record(task->endpoint, MINIMOD_PHASE_CALLBACK, populated);
 	}
 	// single user
 	else
 	{
+		uint64_t const populate_start = sys_nanoseconds();
 		struct minimod_user user;
 		populate_user(&user, document);
+		uint64_t const populated = stats_record(
+		  task->endpoint,
+		  MINIMOD_PHASE_POPULATE,
+		  populate_start);
 		task->callback.fptr.get_users(task->callback.userdata, 1, &user, NULL);
+		stats_record(task->endpoint, MINIMOD_PHASE_CALLBACK, populated);
 	}
 	free_task(task);
-	free(buffer);
+	release_document(doc);
+	arena_release(mark);
 }
 
 
@@ -632,11 +3104,23 @@ handle_get_modfiles(
 		return;
 	}
 
+	if (deliver_batches(
+	      task,
+	      in_data,
+	      in_len,
+	      &l_modfile_schema,
+	      sizeof(struct minimod_modfile),
+	      deliver_modfiles))
+	{
+		free_task(task);
+		return;
+	}
+
 	// parse data
-	QAJ4C_Value const *document = NULL;
-	size_t nbuffer = QAJ4C_calculate_max_buffer_size_n(in_data, in_len);
-	void *buffer = malloc(nbuffer);
-	QAJ4C_parse_opt(in_data, in_len, 0, buffer, nbuffer, &document);
+	struct arena_mark const mark = arena_mark();
+	struct document *doc;
+	QAJ4C_Value const *document =
+	  parse_response(task, in_data, in_len, &doc);
 	ASSERT(QAJ4C_is_object(document));
 
 	// single item or array of items?
@@ -645,8 +3129,10 @@ handle_get_modfiles(
 	{
 		ASSERT(QAJ4C_is_array(data));
 
+		uint64_t const populate_start = sys_nanoseconds();
 		size_t nmodfiles = QAJ4C_array_size(data);
-		struct minimod_modfile *modfiles = calloc(sizeof *modfiles, nmodfiles);
+		struct minimod_modfile *modfiles =
+		  arena_calloc(nmodfiles, sizeof *modfiles);
 
 		for (size_t i = 0; i < QAJ4C_array_size(data); ++i)
 		{
@@ -655,21 +3141,31 @@ handle_get_modfiles(
 
 		struct minimod_pagination pagi;
 		populate_pagination(&pagi, document);
+		uint64_t const populated = stats_record(
+		  task->endpoint,
+		  MINIMOD_PHASE_POPULATE,
+		  populate_start);
 
 		task->callback.fptr
 		  .get_modfiles(task->callback.userdata, nmodfiles, modfiles, &pagi);
-
-		free(modfiles);
+		stats_record(task->endpoint, MINIMOD_PHASE_CALLBACK, populated);
 	}
 	else
 	{
+		uint64_t const populate_start = sys_nanoseconds();
 		struct minimod_modfile modfile;
 		populate_modfile(&modfile, document);
+		uint64_t const populated = stats_record(
+		  task->endpoint,
+		  MINIMOD_PHASE_POPULATE,
+		  populate_start);
 		task->callback.fptr
 		  .get_modfiles(task->callback.userdata, 1, &modfile, NULL);
+		stats_record(task->endpoint, MINIMOD_PHASE_CALLBACK, populated);
 	}
 	free_task(task);
-	free(buffer);
+	release_document(doc);
+	arena_release(mark);
 }
 
 
@@ -690,18 +3186,31 @@ handle_get_events(
 		return;
 	}
 
+	if (deliver_batches(
+	      task,
+	      in_data,
+	      in_len,
+	      &l_event_schema,
+	      sizeof(struct minimod_event),
+	      deliver_events))
+	{
+		free_task(task);
+		return;
+	}
+
 	// parse data
-	QAJ4C_Value const *document = NULL;
-	size_t nbuffer = QAJ4C_calculate_max_buffer_size_n(in_data, in_len);
-	void *buffer = malloc(nbuffer);
-	QAJ4C_parse_opt(in_data, in_len, 0, buffer, nbuffer, &document);
+	struct arena_mark const mark = arena_mark();
+	struct document *doc;
+	QAJ4C_Value const *document =
+	  parse_response(task, in_data, in_len, &doc);
 	ASSERT(QAJ4C_is_object(document));
 
 	QAJ4C_Value const *data = QAJ4C_object_get(document, "data");
 	ASSERT(QAJ4C_is_array(data));
 
+	uint64_t const populate_start = sys_nanoseconds();
 	size_t nevents = QAJ4C_array_size(data);
-	struct minimod_event *events = calloc(sizeof *events, nevents);
+	struct minimod_event *events = arena_calloc(nevents, sizeof *events);
 
 	for (size_t i = 0; i < nevents; ++i)
 	{
@@ -710,14 +3219,18 @@ handle_get_events(
 
 	struct minimod_pagination pagi;
 	populate_pagination(&pagi, document);
+	uint64_t const populated = stats_record(
+	  task->endpoint,
+	  MINIMOD_PHASE_POPULATE,
+	  populate_start);
 
 	task->callback.fptr
 	  .get_events(task->callback.userdata, nevents, events, &pagi);
-
-	free(events);
+	stats_record(task->endpoint, MINIMOD_PHASE_CALLBACK, populated);
 
 	free_task(task);
-	free(buffer);
+	release_document(doc);
+	arena_release(mark);
 }
 
 
@@ -740,18 +3253,19 @@ handle_get_dependencies(
 	}
 
 	// parse data
-	QAJ4C_Value const *document = NULL;
-	size_t nbuffer = QAJ4C_calculate_max_buffer_size_n(in_data, in_len);
-	void *buffer = malloc(nbuffer);
-	QAJ4C_parse_opt(in_data, in_len, 0, buffer, nbuffer, &document);
+	struct arena_mark const mark = arena_mark();
+	struct document *doc;
+	QAJ4C_Value const *document =
+	  parse_response(task, in_data, in_len, &doc);
 	ASSERT(QAJ4C_is_object(document));
 
 	// single item or array of items?
 	QAJ4C_Value const *data = QAJ4C_object_get(document, "data");
 	ASSERT(QAJ4C_is_array(data));
 
+	uint64_t const populate_start = sys_nanoseconds();
 	size_t ndeps = QAJ4C_array_size(data);
-	uint64_t *deps = calloc(sizeof *deps, ndeps);
+	uint64_t *deps = arena_calloc(ndeps, sizeof *deps);
 
 	for (size_t i = 0; i < QAJ4C_array_size(data); ++i)
 	{
@@ -760,14 +3274,18 @@ handle_get_dependencies(
 
 	struct minimod_pagination pagi;
 	populate_pagination(&pagi, document);
+	uint64_t const populated = stats_record(
+	  task->endpoint,
+	  MINIMOD_PHASE_POPULATE,
+	  populate_start);
 
 	task->callback.fptr
 	  .get_dependencies(task->callback.userdata, ndeps, deps, &pagi);
-
-	free(deps);
+	stats_record(task->endpoint, MINIMOD_PHASE_CALLBACK, populated);
 
 	free_task(task);
-	free(buffer);
+	release_document(doc);
+	arena_release(mark);
 }
 
 
@@ -804,10 +3322,10 @@ handle_token_exchange(
 	}
 
 	// parse data
-	size_t nbuffer = QAJ4C_calculate_max_buffer_size_n(in_data, in_len);
-	void *buffer = malloc(nbuffer);
-	QAJ4C_Value const *document = NULL;
-	QAJ4C_parse_opt(in_data, in_len, 0, buffer, nbuffer, &document);
+	struct arena_mark const mark = arena_mark();
+	struct document *doc;
+	QAJ4C_Value const *document =
+	  parse_response(task, in_data, in_len, &doc);
 	ASSERT(QAJ4C_is_object(document));
 
 	QAJ4C_Value const *token = QAJ4C_object_get(document, "access_token");
@@ -825,6 +3343,8 @@ handle_token_exchange(
 	task->callback.fptr.access_token(task->callback.userdata, tok, tok_bytes);
 
 	free_task(task);
+	release_document(doc);
+	arena_release(mark);
 }
 
 
@@ -871,17 +3391,18 @@ handle_get_ratings(
 		return;
 	}
 
-	size_t nbuffer = QAJ4C_calculate_max_buffer_size_n(in_data, in_len);
-	void *buffer = malloc(nbuffer);
-	QAJ4C_Value const *document = NULL;
-	QAJ4C_parse_opt(in_data, in_len, 0, buffer, nbuffer, &document);
+	struct arena_mark const mark = arena_mark();
+	struct document *doc;
+	QAJ4C_Value const *document =
+	  parse_response(task, in_data, in_len, &doc);
 	ASSERT(QAJ4C_is_object(document));
 
 	QAJ4C_Value const *data = QAJ4C_object_get(document, "data");
 	ASSERT(QAJ4C_is_array(data));
 
+	uint64_t const populate_start = sys_nanoseconds();
 	size_t nratings = QAJ4C_array_size(data);
-	struct minimod_rating *ratings = calloc(sizeof *ratings, nratings);
+	struct minimod_rating *ratings = arena_calloc(nratings, sizeof *ratings);
 
 	for (size_t i = 0; i < QAJ4C_array_size(data); ++i)
 	{
@@ -890,13 +3411,17 @@ handle_get_ratings(
 
 	struct minimod_pagination pagi;
 	populate_pagination(&pagi, document);
+	uint64_t const populated = stats_record(
+	  task->endpoint,
+	  MINIMOD_PHASE_POPULATE,
+	  populate_start);
 
 	task->callback.fptr
 	  .get_ratings(task->callback.userdata, nratings, ratings, &pagi);
+	stats_record(task->endpoint, MINIMOD_PHASE_CALLBACK, populated);
 
-	free(ratings);
-
-	free(buffer);
+	release_document(doc);
+	arena_release(mark);
 	free_task(task);
 }
 
@@ -992,65 +3517,307 @@ minimod_init(
 		}
 	}
 
+	log_start();
+	arena_start();
+	jsonindex_start();
+	prepare_schemas();
+
 	l_mmi.env = (in_flags & MINIMOD_INITFLAG_TESTENV);
+	l_mmi.endpoint =
+	  l_custom_endpoint ? l_custom_endpoint : endpoints[l_mmi.env];
 
 	// TODO validate path
-	l_mmi.root_path = strdup(in_root_path ? in_root_path : DEFAULT_ROOT);
+	l_mmi.root_path = mem_strdup(in_root_path ? in_root_path : DEFAULT_ROOT);
 	// make sure the path does not end with '/'
 	size_t len = strlen(l_mmi.root_path);
 	ASSERT(len > 0);
 	if (l_mmi.root_path[len - 1] == '/')
 	{
-		l_mmi.root_path[len - 1] = '\0';
+		l_mmi.root_path[len - 1] = '\0';
+	}
+
+	// attempt to initialize netw
+	if (!netw_init())
+	{
+		mem_free(l_mmi.root_path);
+		l_mmi = (struct mmi){ 0 };
+		arena_stop();
+		log_stop();
+		return MINIMOD_ERR_NET;
+	}
+	transport_start();
+
+	l_mmi.api_key = in_api_key ? mem_strdup(in_api_key) : NULL;
+
+	l_mmi.unzip = (in_flags & MINIMOD_INITFLAG_UNZIP);
+
+	mtx_init(&l_mmi.install_requests_mtx, mtx_plain);
+	mtx_init(&l_mmi.hosts_mtx, mtx_plain);
+	mtx_init(&l_mmi.free_tasks_mtx, mtx_plain);
+	mtx_init(&l_mmi.documents_mtx, mtx_plain);
+	mtx_init(&l_mmi.installed_mtx, mtx_plain);
+	mtx_init(&l_mmi.manifest_mtx, mtx_plain);
+	mtx_init(&l_mmi.open_mods_mtx, mtx_plain);
+
+	// deletes what uninstalling moved to the trash, left from before too
+	char *trash_path;
+	mem_asprintf(&trash_path, "%s/.trash", l_mmi.root_path);
+	trash_start(trash_path);
+	mem_free(trash_path);
+
+	load_installed();
+	read_token();
+	read_hosts();
+
+	if (in_flags & MINIMOD_INITFLAG_PREWARM)
+	{
+		minimod_prewarm(MINIMOD_PREWARM_API);
+	}
+
+	return MINIMOD_ERR_OK;
+}
+
+
+void
+minimod_deinit()
+{
+	watch_stop();
+	transport_stop();
+	trash_stop();
+	netw_deinit();
+
+	write_hosts();
+
+	mem_free(l_mmi.root_path);
+	mem_free(l_mmi.cache_tokenpath);
+	mem_free(l_mmi.cache_hostspath);
+	mem_free(l_mmi.api_key);
+	mem_free(l_mmi.token);
+	mem_free(l_mmi.token_bearer);
+
+	while (l_mmi.free_tasks)
+	{
+		struct task *next = l_mmi.free_tasks->next_free;
+		mem_free(l_mmi.free_tasks);
+		l_mmi.free_tasks = next;
+	}
+
+	if (l_mmi.ndocuments > 0)
+	{
+		LOGE("responses still retained, see minimod_release()");
+	}
+	for (size_t i = 0; i < l_mmi.ndocuments; ++i)
+	{
+		mem_free(l_mmi.documents[i]);
+	}
+	mem_free(l_mmi.documents);
+	free_documents(l_mmi.free_documents);
+	if (l_mmi.open_mods)
+	{
+		LOGE("mods still open, see minimod_mod_close()");
+	}
+	while (l_mmi.open_mods)
+	{
+		struct minimod_modfs *next = l_mmi.open_mods->next;
+		zipfs_close(l_mmi.open_mods->zip);
+		mem_free(l_mmi.open_mods);
+		l_mmi.open_mods = next;
+	}
+	modindex_free(&l_mmi.installed);
+	mem_free(l_mmi.installed_names);
+	mem_free(l_mmi.dir_mtimes);
+	mem_free(l_mmi.cache_manifestpath);
+
+	mtx_destroy(&l_mmi.install_requests_mtx);
+	mtx_destroy(&l_mmi.hosts_mtx);
+	mtx_destroy(&l_mmi.free_tasks_mtx);
+	mtx_destroy(&l_mmi.documents_mtx);
+	mtx_destroy(&l_mmi.installed_mtx);
+	mtx_destroy(&l_mmi.manifest_mtx);
+	mtx_destroy(&l_mmi.open_mods_mtx);
+
+	l_mmi = (struct mmi){ 0 };
+
+	arena_stop();
+
+	log_stop();
+}
+
+
+int64_t
+minimod_is_ratelimited(void)
+{
+	return l_mmi.rate_limited_until - sys_seconds();
+}
+
+
+void
+minimod_set_debugtesting(int error_rate, int min_delay, int max_delay)
+{
+	transport_set_debugtesting(error_rate, min_delay, max_delay);
+}
+
+
+void
+minimod_set_endpoint(char const *in_url)
+{
+	ASSERT(!l_mmi.root_path);
+	mem_free(l_custom_endpoint);
+	l_custom_endpoint = in_url ? mem_strdup(in_url) : NULL;
+	if (l_custom_endpoint)
+	{
+		// make sure the URL does not end with '/'
+		size_t len = strlen(l_custom_endpoint);
+		if (len > 0 && l_custom_endpoint[len - 1] == '/')
+		{
+			l_custom_endpoint[len - 1] = '\0';
+		}
+	}
+}
+
+
+bool
+minimod_set_allocator(
+  minimod_alloc_callback in_alloc,
+  minimod_realloc_callback in_realloc,
+  minimod_free_callback in_free,
+  void *in_userdata)
+{
+	if (l_mmi.root_path)
+	{
+		LOGE("allocator cannot be changed while minimod is initialized");
+		return false;
 	}
-
-	// attempt to initialize netw
-	if (!netw_init())
+	if (!in_alloc != !in_realloc || !in_alloc != !in_free)
 	{
-		return MINIMOD_ERR_NET;
+		LOGE("allocator needs all or none of alloc, realloc and free");
+		return false;
 	}
+	mem_set_allocator(in_alloc, in_realloc, in_free, in_userdata);
+	return true;
+}
 
-	l_mmi.api_key = in_api_key ? strdup(in_api_key) : NULL;
 
-	l_mmi.unzip = (in_flags & MINIMOD_INITFLAG_UNZIP);
+bool
+minimod_set_transport(
+  enum minimod_transport in_transport,
+  char const *in_path)
+{
+	ASSERT(!l_mmi.root_path);
+	ASSERT(in_path || in_transport == MINIMOD_TRANSPORT_NETWORK);
+	return transport_configure(in_transport, in_path);
+}
 
-	mtx_init(&l_mmi.install_requests_mtx, mtx_plain);
 
-	read_token();
+void
+minimod_set_log(
+  enum minimod_loglevel in_level,
+  minimod_log_callback in_callback,
+  void *in_userdata)
+{
+	log_configure(in_level, in_callback, in_userdata);
+}
 
-	return MINIMOD_ERR_OK;
+
+void
+minimod_get_stats(
+  enum minimod_endpoint in_endpoint,
+  struct minimod_endpoint_stats *out_stats)
+{
+	ASSERT(in_endpoint < MINIMOD_ENDPOINT_COUNT);
+	ASSERT(out_stats);
+
+	// the struct consists of counters only, which are copied one by one
+	// since they may be updated concurrently.
+	uint64_t const *src = (uint64_t const *)&l_stats[in_endpoint];
+	uint64_t *dst = (uint64_t *)out_stats;
+	for (size_t i = 0; i < sizeof *out_stats / sizeof *dst; ++i)
+	{
+		dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+	}
 }
 
 
 void
-minimod_deinit()
+minimod_set_tracing(bool in_enable)
 {
-	netw_deinit();
+	trace_enable(in_enable);
+}
 
-	free(l_mmi.root_path);
-	free(l_mmi.cache_tokenpath);
-	free(l_mmi.api_key);
-	free(l_mmi.token);
-	free(l_mmi.token_bearer);
 
-	mtx_destroy(&l_mmi.install_requests_mtx);
+bool
+minimod_write_trace(char const *in_path)
+{
+	ASSERT(in_path);
+	return trace_write(in_path);
+}
 
-	l_mmi = (struct mmi){ 0 };
+
+void
+minimod_set_batch_size(size_t in_items)
+{
+	__atomic_store_n(&l_batch_size, in_items, __ATOMIC_RELAXED);
 }
 
 
-int64_t
-minimod_is_ratelimited(void)
+static void
+on_prewarmed(
+  void *UNUSED(in_udata),
+  void const *UNUSED(in_data),
+  size_t UNUSED(in_len),
+  int UNUSED(error),
+  struct netw_header const *UNUSED(header))
 {
-	return l_mmi.rate_limited_until - sys_seconds();
+	// the response itself is of no interest, only the connection is
+	LOG("prewarmed connection (%i)", error);
 }
 
 
 void
-minimod_set_debugtesting(int error_rate, int min_delay, int max_delay)
+minimod_prewarm(unsigned int in_flags)
 {
-	netw_set_error_rate(error_rate);
-	netw_set_delay(min_delay, max_delay);
+	// there are no connections to warm up
+	if (transport_is_replaying())
+	{
+		return;
+	}
+
+	char api_host[sizeof l_mmi.hosts[0].name] = { 0 };
+	origin_from_url(l_mmi.endpoint, api_host, sizeof api_host);
+
+	// requests go to the bare host, so they neither count towards
+	// the rate-limit nor require an API key.
+	if ((in_flags & MINIMOD_PREWARM_API) && api_host[0])
+	{
+		char *path;
+		mem_asprintf(&path, "%s/", api_host);
+		netw_request(NETW_VERB_GET, path, NULL, NULL, 0, on_prewarmed, NULL);
+		mem_free(path);
+	}
+
+	if (in_flags & MINIMOD_PREWARM_DOWNLOAD)
+	{
+		mtx_lock(&l_mmi.hosts_mtx);
+		for (size_t i = 0; i < MAX_KNOWN_HOSTS; ++i)
+		{
+			char const *host = l_mmi.hosts[i].name;
+			if (host[0] && 0 != strcmp(host, api_host))
+			{
+				char *path;
+				mem_asprintf(&path, "%s/", host);
+				netw_request(
+				  NETW_VERB_GET,
+				  path,
+				  NULL,
+				  NULL,
+				  0,
+				  on_prewarmed,
+				  NULL);
+				mem_free(path);
+			}
+		}
+		mtx_unlock(&l_mmi.hosts_mtx);
+	}
 }
 
 
@@ -1061,15 +3828,16 @@ minimod_get_games(
   void *in_udata)
 {
 	char *path;
-	asprintf(
+	mem_asprintf(
 	  &path,
 	  "%s/games?api_key=%s&%s",
-	  endpoints[l_mmi.env],
+	  l_mmi.endpoint,
 	  l_mmi.api_key,
 	  in_filter ? in_filter : "");
 	char const *const headers[] = {
 		// clang-format off
 		"Accept", "application/json",
+		"Accept-Encoding", "gzip, deflate",
 		NULL
 		// clang-format on
 	};
@@ -1077,7 +3845,8 @@ minimod_get_games(
 	struct task *task = alloc_task();
 	task->callback.fptr.get_games = in_callback;
 	task->callback.userdata = in_udata;
-	if (!netw_request(
+	if (!api_request(
+	      MINIMOD_ENDPOINT_GAMES,
 	      NETW_VERB_GET,
 	      path,
 	      headers,
@@ -1089,15 +3858,17 @@ minimod_get_games(
 		free_task(task);
 	}
 
-	free(path);
+	mem_free(path);
 }
 
 
-void
-minimod_get_mods(
+// minimod_get_mods() with *in_flags* of <task_flag>
+static void
+get_mods(
   char const *in_filter,
   uint64_t in_game_id,
   uint64_t in_mod_id,
+  uint32_t in_flags,
   minimod_get_mods_callback in_callback,
   void *in_userdata)
 {
@@ -1105,10 +3876,10 @@ minimod_get_mods(
 	char *path;
 	if (in_mod_id)
 	{
-		asprintf(
+		mem_asprintf(
 		  &path,
 		  "%s/games/%" PRIu64 "/mods/%" PRIu64 "?api_key=%s&%s",
-		  endpoints[l_mmi.env],
+		  l_mmi.endpoint,
 		  in_game_id,
 		  in_mod_id,
 		  l_mmi.api_key,
@@ -1116,10 +3887,10 @@ minimod_get_mods(
 	}
 	else
 	{
-		asprintf(
+		mem_asprintf(
 		  &path,
 		  "%s/games/%" PRIu64 "/mods?api_key=%s&%s",
-		  endpoints[l_mmi.env],
+		  l_mmi.endpoint,
 		  in_game_id,
 		  l_mmi.api_key,
 		  in_filter ? in_filter : "");
@@ -1128,6 +3899,7 @@ minimod_get_mods(
 	char const *const headers[] = {
 		// clang-format off
 		"Accept", "application/json",
+		"Accept-Encoding", "gzip, deflate",
 		NULL
 		// clang-format on
 	};
@@ -1135,7 +3907,9 @@ minimod_get_mods(
 	struct task *task = alloc_task();
 	task->callback.fptr.get_mods = in_callback;
 	task->callback.userdata = in_userdata;
-	if (!netw_request(
+	task->flags = in_flags;
+	if (!api_request(
+	      MINIMOD_ENDPOINT_MODS,
 	      NETW_VERB_GET,
 	      path,
 	      headers,
@@ -1147,7 +3921,65 @@ minimod_get_mods(
 		free_task(task);
 	}
 
-	free(path);
+	mem_free(path);
+}
+
+
+void
+minimod_get_mods(
+  char const *in_filter,
+  uint64_t in_game_id,
+  uint64_t in_mod_id,
+  minimod_get_mods_callback in_callback,
+  void *in_userdata)
+{
+	get_mods(in_filter, in_game_id, in_mod_id, 0, in_callback, in_userdata);
+}
+
+
+void
+minimod_get_mods_columns(
+  char const *in_filter,
+  uint64_t in_game_id,
+  minimod_get_mods_columns_callback in_callback,
+  void *in_userdata)
+{
+	ASSERT(in_game_id > 0);
+	char *path;
+	mem_asprintf(
+	  &path,
+	  "%s/games/%" PRIu64 "/mods?api_key=%s&%s",
+	  l_mmi.endpoint,
+	  in_game_id,
+	  l_mmi.api_key,
+	  in_filter ? in_filter : "");
+
+	char const *const headers[] = {
+		// clang-format off
+		"Accept", "application/json",
+		"Accept-Encoding", "gzip, deflate",
+		NULL
+		// clang-format on
+	};
+
+	struct task *task = alloc_task();
+	task->callback.fptr.get_mods_columns = in_callback;
+	task->callback.userdata = in_userdata;
+	task->flags = TASK_FLAG_COLUMNS;
+	if (!api_request(
+	      MINIMOD_ENDPOINT_MODS,
+	      NETW_VERB_GET,
+	      path,
+	      headers,
+	      NULL,
+	      0,
+	      handle_get_mods,
+	      task))
+	{
+		free_task(task);
+	}
+
+	mem_free(path);
 }
 
 
@@ -1158,11 +3990,12 @@ minimod_email_request(
   void *in_udata)
 {
 	char *path;
-	asprintf(&path, "%s/oauth/emailrequest", endpoints[l_mmi.env]);
+	mem_asprintf(&path, "%s/oauth/emailrequest", l_mmi.endpoint);
 
 	char const *const headers[] = {
 		// clang-format off
 		"Accept", "application/json",
+		"Accept-Encoding", "gzip, deflate",
 		"Content-Type", "application/x-www-form-urlencoded",
 		NULL
 		// clang-format on
@@ -1171,14 +4004,16 @@ minimod_email_request(
 	char *payload;
 	char *email = netw_percent_encode(in_email, strlen(in_email), NULL);
 	int nbytes =
-	  asprintf(&payload, "api_key=%s&email=%s", l_mmi.api_key, email);
+	  mem_asprintf(&payload, "api_key=%s&email=%s", l_mmi.api_key, email);
+	// allocated by netw
 	free(email);
 	LOG("payload: %s (%i)", payload, nbytes);
 
 	struct task *task = alloc_task();
 	task->callback.fptr.email_request = in_callback;
 	task->callback.userdata = in_udata;
-	if (!netw_request(
+	if (!api_request(
+	      MINIMOD_ENDPOINT_AUTH,
 	      NETW_VERB_POST,
 	      path,
 	      headers,
@@ -1190,8 +4025,8 @@ minimod_email_request(
 		free_task(task);
 	}
 
-	free(payload);
-	free(path);
+	mem_free(payload);
+	mem_free(path);
 }
 
 
@@ -1202,18 +4037,19 @@ minimod_email_exchange(
   void *in_udata)
 {
 	char *path;
-	asprintf(&path, "%s/oauth/emailexchange", endpoints[l_mmi.env]);
+	mem_asprintf(&path, "%s/oauth/emailexchange", l_mmi.endpoint);
 
 	char const *const headers[] = {
 		// clang-format off
 		"Accept", "application/json",
+		"Accept-Encoding", "gzip, deflate",
 		"Content-Type", "application/x-www-form-urlencoded",
 		NULL
 		// clang-format on
 	};
 
 	char *payload;
-	int nbytes = asprintf(
+	int nbytes = mem_asprintf(
 	  &payload,
 	  "api_key=%s&security_code=%s",
 	  l_mmi.api_key,
@@ -1223,7 +4059,8 @@ minimod_email_exchange(
 	struct task *task = alloc_task();
 	task->callback.fptr.access_token = in_callback;
 	task->callback.userdata = in_udata;
-	if (!netw_request(
+	if (!api_request(
+	      MINIMOD_ENDPOINT_AUTH,
 	      NETW_VERB_POST,
 	      path,
 	      headers,
@@ -1235,8 +4072,8 @@ minimod_email_exchange(
 		free_task(task);
 	}
 
-	free(payload);
-	free(path);
+	mem_free(payload);
+	mem_free(path);
 }
 
 
@@ -1248,11 +4085,12 @@ minimod_steam_auth(
   void *in_udata)
 {
 	char *path;
-	asprintf(&path, "%s/external/steamauth", endpoints[l_mmi.env]);
+	mem_asprintf(&path, "%s/external/steamauth", l_mmi.endpoint);
 
 	char const *const headers[] = {
 		// clang-format off
 		"Accept", "application/json",
+		"Accept-Encoding", "gzip, deflate",
 		"Content-Type", "application/x-www-form-urlencoded",
 		NULL
 		// clang-format on
@@ -1264,14 +4102,16 @@ minimod_steam_auth(
 	char *ticket = netw_percent_encode(b64, b64_len, NULL);
 	char *payload;
 	int nbytes =
-	  asprintf(&payload, "api_key=%s&appdata=%s", l_mmi.api_key, ticket);
+	  mem_asprintf(&payload, "api_key=%s&appdata=%s", l_mmi.api_key, ticket);
 	LOG("payload: %s (%i)", payload, nbytes);
+	// allocated by netw
 	free(ticket);
 
 	struct task *task = alloc_task();
 	task->callback.fptr.access_token = in_callback;
 	task->callback.userdata = in_udata;
-	if (!netw_request(
+	if (!api_request(
+	      MINIMOD_ENDPOINT_AUTH,
 	      NETW_VERB_POST,
 	      path,
 	      headers,
@@ -1283,8 +4123,8 @@ minimod_steam_auth(
 		free_task(task);
 	}
 
-	free(payload);
-	free(path);
+	mem_free(payload);
+	mem_free(path);
 }
 
 
@@ -1297,11 +4137,12 @@ minimod_get_me(minimod_get_users_callback in_callback, void *in_udata)
 	}
 
 	char *path;
-	asprintf(&path, "%s/me", endpoints[l_mmi.env]);
+	mem_asprintf(&path, "%s/me", l_mmi.endpoint);
 
 	char const *const headers[] = {
 		// clang-format off
 		"Accept", "application/json",
+		"Accept-Encoding", "gzip, deflate",
 		"Authorization", l_mmi.token_bearer,
 		NULL
 		// clang-format on
@@ -1311,7 +4152,8 @@ minimod_get_me(minimod_get_users_callback in_callback, void *in_udata)
 	task->flags |= TASK_FLAG_AUTH_TOKEN;
 	task->callback.fptr.get_users = in_callback;
 	task->callback.userdata = in_udata;
-	if (!netw_request(
+	if (!api_request(
+	      MINIMOD_ENDPOINT_ME,
 	      NETW_VERB_GET,
 	      path,
 	      headers,
@@ -1323,7 +4165,7 @@ minimod_get_me(minimod_get_users_callback in_callback, void *in_udata)
 		free_task(task);
 	}
 
-	free(path);
+	mem_free(path);
 
 	return true;
 }
@@ -1345,18 +4187,21 @@ minimod_get_user_events(
 	char *game_filter = NULL;
 	if (in_game_id)
 	{
-		asprintf(&game_filter, "&game_id=%" PRIu64, in_game_id);
+		mem_asprintf(&game_filter, "&game_id=%" PRIu64, in_game_id);
 	}
 	char *cutoff_filter = NULL;
 	if (in_date_cutoff)
 	{
-		asprintf(&cutoff_filter, "&date_added-gt=%" PRIu64, in_date_cutoff);
+		mem_asprintf(
+		  &cutoff_filter,
+		  "&date_added-gt=%" PRIu64,
+		  in_date_cutoff);
 	}
 	char *path;
-	asprintf(
+	mem_asprintf(
 	  &path,
 	  "%s/me/events?%s%s%s",
-	  endpoints[l_mmi.env],
+	  l_mmi.endpoint,
 	  in_filter ? in_filter : "",
 	  game_filter ? game_filter : "",
 	  cutoff_filter ? cutoff_filter : "");
@@ -1364,6 +4209,7 @@ minimod_get_user_events(
 	char const *const headers[] = {
 		// clang-format off
 		"Accept", "application/json",
+		"Accept-Encoding", "gzip, deflate",
 		"Authorization", l_mmi.token_bearer,
 		NULL
 		// clang-format on
@@ -1374,7 +4220,8 @@ minimod_get_user_events(
 	task->flags |= TASK_FLAG_AUTH_TOKEN;
 	task->callback.fptr.get_events = in_callback;
 	task->callback.userdata = in_userdata;
-	if (!netw_request(
+	if (!api_request(
+	      MINIMOD_ENDPOINT_EVENTS,
 	      NETW_VERB_GET,
 	      path,
 	      headers,
@@ -1386,7 +4233,7 @@ minimod_get_user_events(
 		free_task(task);
 	}
 
-	free(path);
+	mem_free(path);
 
 	return true;
 }
@@ -1403,21 +4250,30 @@ minimod_get_dependencies(
 	ASSERT(in_mod_id > 0);
 
 	char *path;
-	asprintf(
+	mem_asprintf(
 	  &path,
 	  "%s/games/%" PRIu64 "/mods/%" PRIu64 "/dependencies?api_key=%s",
-	  endpoints[l_mmi.env],
+	  l_mmi.endpoint,
 	  in_game_id,
 	  in_mod_id,
 	  l_mmi.api_key);
 
+	char const *const headers[] = {
+		// clang-format off
+		"Accept", "application/json",
+		"Accept-Encoding", "gzip, deflate",
+		NULL
+		// clang-format on
+	};
+
 	struct task *task = alloc_task();
 	task->callback.fptr.get_dependencies = in_callback;
 	task->callback.userdata = in_userdata;
-	if (!netw_request(
+	if (!api_request(
+	      MINIMOD_ENDPOINT_DEPENDENCIES,
 	      NETW_VERB_GET,
 	      path,
-	      NULL,
+	      headers,
 	      NULL,
 	      0,
 	      handle_get_dependencies,
@@ -1426,7 +4282,7 @@ minimod_get_dependencies(
 		free_task(task);
 	}
 
-	free(path);
+	mem_free(path);
 }
 
 
@@ -1442,20 +4298,22 @@ minimod_deauthenticate(void)
 {
 	fsu_rmfile(get_tokenpath());
 
-	free(l_mmi.token);
-	free(l_mmi.token_bearer);
+	mem_free(l_mmi.token);
+	mem_free(l_mmi.token_bearer);
 
 	l_mmi.token = NULL;
 	l_mmi.token_bearer = NULL;
 }
 
 
-void
-minimod_get_modfiles(
+// minimod_get_modfiles() with *in_flags* of <task_flag>
+static void
+get_modfiles(
   char const *in_filter,
   uint64_t in_game_id,
   uint64_t in_mod_id,
   uint64_t in_modfile_id,
+  uint32_t in_flags,
   minimod_get_modfiles_callback in_callback,
   void *in_userdata)
 {
@@ -1464,11 +4322,11 @@ minimod_get_modfiles(
 	char *path;
 	if (in_modfile_id)
 	{
-		asprintf(
+		mem_asprintf(
 		  &path,
 		  "%s/games/%" PRIu64 "/mods/%" PRIu64 "/files/%" PRIu64
 		  "?api_key=%s&%s",
-		  endpoints[l_mmi.env],
+		  l_mmi.endpoint,
 		  in_game_id,
 		  in_mod_id,
 		  in_modfile_id,
@@ -1477,10 +4335,10 @@ minimod_get_modfiles(
 	}
 	else
 	{
-		asprintf(
+		mem_asprintf(
 		  &path,
 		  "%s/games/%" PRIu64 "/mods/%" PRIu64 "/files?api_key=%s&%s",
-		  endpoints[l_mmi.env],
+		  l_mmi.endpoint,
 		  in_game_id,
 		  in_mod_id,
 		  l_mmi.api_key,
@@ -1491,6 +4349,7 @@ minimod_get_modfiles(
 	char const *const headers[] = {
 		// clang-format off
 		"Accept", "application/json",
+		"Accept-Encoding", "gzip, deflate",
 		NULL
 		// clang-format on
 	};
@@ -1498,7 +4357,9 @@ minimod_get_modfiles(
 	struct task *task = alloc_task();
 	task->callback.fptr.get_modfiles = in_callback;
 	task->callback.userdata = in_userdata;
-	if (!netw_request(
+	task->flags = in_flags;
+	if (!api_request(
+	      MINIMOD_ENDPOINT_MODFILES,
 	      NETW_VERB_GET,
 	      path,
 	      headers,
@@ -1510,7 +4371,27 @@ minimod_get_modfiles(
 		free_task(task);
 	}
 
-	free(path);
+	mem_free(path);
+}
+
+
+void
+minimod_get_modfiles(
+  char const *in_filter,
+  uint64_t in_game_id,
+  uint64_t in_mod_id,
+  uint64_t in_modfile_id,
+  minimod_get_modfiles_callback in_callback,
+  void *in_userdata)
+{
+	get_modfiles(
+	  in_filter,
+	  in_game_id,
+	  in_mod_id,
+	  in_modfile_id,
+	  0,
+	  in_callback,
+	  in_userdata);
 }
 
 
@@ -1528,16 +4409,16 @@ minimod_get_mod_events(
 	char *cutoff = NULL;
 	if (in_date_cutoff)
 	{
-		asprintf(&cutoff, "&date_added-gt=%" PRIu64, in_date_cutoff);
+		mem_asprintf(&cutoff, "&date_added-gt=%" PRIu64, in_date_cutoff);
 	}
 	char *path;
 	if (in_mod_id)
 	{
-		asprintf(
+		mem_asprintf(
 		  &path,
 		  "%s/games/%" PRIu64 "/mods/%" PRIu64 "/events/"
 		  "?api_key=%s&%s%s",
-		  endpoints[l_mmi.env],
+		  l_mmi.endpoint,
 		  in_game_id,
 		  in_mod_id,
 		  l_mmi.api_key,
@@ -1546,20 +4427,21 @@ minimod_get_mod_events(
 	}
 	else
 	{
-		asprintf(
+		mem_asprintf(
 		  &path,
 		  "%s/games/%" PRIu64 "/mods/events?api_key=%s&%s%s",
-		  endpoints[l_mmi.env],
+		  l_mmi.endpoint,
 		  in_game_id,
 		  l_mmi.api_key,
 		  in_filter ? in_filter : "",
 		  cutoff ? cutoff : "");
 	}
-	free(cutoff);
+	mem_free(cutoff);
 
 	char const *const headers[] = {
 		// clang-format off
 		"Accept", "application/json",
+		"Accept-Encoding", "gzip, deflate",
 		NULL
 		// clang-format on
 	};
@@ -1568,7 +4450,8 @@ minimod_get_mod_events(
 	struct task *task = alloc_task();
 	task->callback.fptr.get_events = in_callback;
 	task->callback.userdata = in_userdata;
-	if (!netw_request(
+	if (!api_request(
+	      MINIMOD_ENDPOINT_EVENTS,
 	      NETW_VERB_GET,
 	      path,
 	      headers,
@@ -1580,10 +4463,108 @@ minimod_get_mod_events(
 		free_task(task);
 	}
 
-	free(path);
+	mem_free(path);
+}
+
+
+// miniz's allocation hooks
+static void *
+zip_realloc(
+  void *UNUSED(opaque),
+  void *in_ptr,
+  size_t in_items,
+  size_t in_size)
+{
+	if (in_size > 0 && in_items > SIZE_MAX / in_size)
+	{
+		return NULL;
+	}
+	return mem_realloc(in_ptr, in_items * in_size);
+}
+
+
+static void *
+zip_alloc(void *in_opaque, size_t in_items, size_t in_size)
+{
+	return zip_realloc(in_opaque, NULL, in_items, in_size);
+}
+
+
+static void
+zip_free(void *UNUSED(opaque), void *in_ptr)
+{
+	mem_free(in_ptr);
+}
+
+
+// extracts the staged zip into the staged directory of the mod
+static bool
+extract_zip(struct install_request *req, fsu_dir in_game_dir)
+{
+	long s = ftell(req->file);
+	ASSERT(s >= 0);
+	int seek_err = fseek(req->file, 0, SEEK_SET);
+	if (seek_err != 0)
+	{
+		LOGE("Seek failed %i", errno);
+	}
+	// unzip it
+	mz_zip_archive zip = {
+		.m_pAlloc = zip_alloc,
+		.m_pFree = zip_free,
+		.m_pRealloc = zip_realloc,
+	};
+	if (!mz_zip_reader_init_cfile(&zip, req->file, (mz_uint64)s, 0))
+	{
+		LOGE("zip error: %i", zip.m_last_error);
+		return false;
+	}
+	mz_uint nfiles = mz_zip_reader_get_num_files(&zip);
+	LOG("#files in zip: %u", nfiles);
+	// the files are opened relative to the mod's directory, left over
+	// from an earlier attempt it might contain anything
+	char name[MOD_NAME_SIZE];
+	mod_file_name(name, req->mod_id, "", true);
+	discard(in_game_dir, name);
+	fsu_dir const dir = fsu_opendirat(in_game_dir, name, true);
+	if (dir == FSU_NODIR)
+	{
+		LOGE("could not create %s", name);
+	}
+	for (mz_uint i = 0; i < nfiles && dir != FSU_NODIR; ++i)
+	{
+		mz_zip_archive_file_stat stat;
+		mz_zip_reader_file_stat(&zip, i, &stat);
+		if (!stat.m_is_directory)
+		{
+			LOG("  + extracting %s", stat.m_filename);
+			uint64_t const start = sys_nanoseconds();
+			FILE *f = fsu_fopenat(dir, stat.m_filename, "wb");
+			if (!f)
+			{
+				LOGE("could not extract %s", stat.m_filename);
+				continue;
+			}
+			mz_zip_reader_extract_to_cfile(&zip, i, f, 0);
+
+			fclose(f);
+			trace_complete(
+			  "extract file",
+			  "download",
+			  start,
+			  sys_nanoseconds(),
+			  req->mod_id);
+		}
+	}
+	fsu_closedir(dir);
+	mz_zip_reader_end(&zip);
+	return dir != FSU_NODIR;
 }
 
 
+// the mod's files are written under the names of mod_file_name()'s staged
+// files and published once complete, so that the old ones can be read
+// until then
 static void
 on_install_download(
   void *in_udata,
@@ -1592,66 +4573,97 @@ on_install_download(
   struct netw_header const *UNUSED(in_header))
 {
 	struct install_request *req = in_udata;
+	uint64_t const received = stats_record(
+	  MINIMOD_ENDPOINT_DOWNLOAD,
+	  MINIMOD_PHASE_NETWORK,
+	  req->issued);
+	long const nbytes = in_file ? ftell(in_file) : 0;
+	stats_count_response(
+	  MINIMOD_ENDPOINT_DOWNLOAD,
+	  error,
+	  nbytes > 0 ? (size_t)nbytes : 0);
+
+	fsu_dir const dir = open_game_dir(req->game_id, false);
+	char name[MOD_NAME_SIZE];
+	bool is_published = false;
+	uint32_t set = INSTALLED_JSON;
+	uint32_t clear = 0;
+
 	// Downloads are not authenticated, thusly there is no need to handle
 	// rate-limiting or authorization errors.
 	if (error != 200)
 	{
 		LOGE("mod NOT downloaded %i", error);
-		req->callback(req->userdata, false, req->game_id, req->mod_id);
-		free_install_request(req);
-		return;
 	}
-
-	LOG("mod downloaded");
-
+	else if (dir == FSU_NODIR)
+	{
+		LOGE("mods/%" PRIu64 " is gone", req->game_id);
+	}
 	// extract zip?
-	if (l_mmi.unzip)
+	else if (l_mmi.unzip)
 	{
-		long s = ftell(in_file);
-		ASSERT(s >= 0);
-		int seek_err = fseek(in_file, 0, SEEK_SET);
-		if (seek_err != 0)
-		{
-			LOGE("Seek failed %i", errno);
-		}
-		// unzip it
-		mz_zip_archive zip = { 0 };
-		if (!mz_zip_reader_init_cfile(&zip, in_file, (mz_uint64)s, 0))
+		LOG("mod downloaded");
+		is_published =
+		  extract_zip(req, dir) && publish(dir, req->mod_id, "");
+		if (is_published)
 		{
-			LOGE("zip error: %i", zip.m_last_error);
+			// replaced by the directory
+			mod_file_name(name, req->mod_id, ".zip", false);
+			discard(dir, name);
+			set |= INSTALLED_DIR;
+			clear |= INSTALLED_ZIP;
+			stats_record(
+			  MINIMOD_ENDPOINT_DOWNLOAD,
+			  MINIMOD_PHASE_EXTRACT,
+			  received);
 		}
-		mz_uint nfiles = mz_zip_reader_get_num_files(&zip);
-		LOG("#files in zip: %u", nfiles);
-		for (mz_uint i = 0; i < nfiles; ++i)
+	}
+	else
+	{
+		LOG("mod downloaded");
+		// complete before it is published, and closed, as Windows does
+		// not rename a file which is open
+		fclose(req->file);
+		req->file = NULL;
+		is_published = publish(dir, req->mod_id, ".zip");
+		set |= INSTALLED_ZIP;
+	}
+	if (req->file)
+	{
+		fclose(req->file);
+	}
+
+	// the json last, since the mod counts as installed once it exists
+	is_published = is_published && publish(dir, req->mod_id, ".json");
+	if (is_published)
+	{
+		struct installed_info const info = {
+			.modfile_id = req->modfile_id,
+			.date_updated = req->date_updated,
+			.filesize = req->filesize,
+			.name = req->name,
+		};
+		update_installed(req->game_id, req->mod_id, set, clear, &info);
+		save_installed();
+	}
+
+	// whatever was not published
+	fsu_rmfile(req->zip_path);
+	if (dir != FSU_NODIR)
+	{
+		mod_file_name(name, req->mod_id, ".json", true);
+		fsu_rmfileat(dir, name);
+		mod_file_name(name, req->mod_id, "", true);
+		if (fsu_ptypeat(dir, name) != FSU_PATHTYPE_NONE)
 		{
-			mz_zip_archive_file_stat stat;
-			mz_zip_reader_file_stat(&zip, i, &stat);
-			if (!stat.m_is_directory)
-			{
-				char *path;
-				asprintf(
-				  &path,
-				  "%s/mods/%" PRIu64 "/%" PRIu64 "/%s",
-				  l_mmi.root_path,
-				  req->game_id,
-				  req->mod_id,
-				  stat.m_filename);
-				LOG("  + extracting %s", path);
-				FILE *f = fsu_fopen(path, "wb");
-				mz_zip_reader_extract_to_cfile(&zip, i, f, 0);
-				free(path);
-
-				fclose(f);
-			}
+			discard(dir, name);
 		}
-		mz_zip_reader_end(&zip);
-		fsu_rmfile(req->zip_path);
+		fsu_closedir(dir);
 	}
 
 	// callback
-	req->callback(req->userdata, true, req->game_id, req->mod_id);
+	req->callback(req->userdata, is_published, req->game_id, req->mod_id);
 
-	fclose(in_file);
 	free_install_request(req);
 }
 
@@ -1674,25 +4686,34 @@ on_install_get_mod(
 	ASSERT(in_nmods <= 1);
 	struct install_request *req = in_userdata;
 
-	if (in_nmods > 0)
+	fsu_dir const dir =
+	  in_nmods > 0 ? open_game_dir(req->game_id, true) : FSU_NODIR;
+	if (dir != FSU_NODIR)
 	{
-		// write json file
-		char *jpath;
-		asprintf(
-		  &jpath,
-		  "%s/mods/%" PRIu64 "/%" PRIu64 ".json",
-		  l_mmi.root_path,
-		  req->game_id,
-		  req->mod_id);
+		// write json file, published along with the modfile
+		char name[MOD_NAME_SIZE];
+		mod_file_name(name, req->mod_id, ".json", true);
 
-		FILE *jout = fsu_fopen(jpath, "wb");
-		QAJ4C_print_buffer_callback(
-		  in_mods[0].more,
-		  json_print_callback,
-		  jout);
-		fclose(jout);
+		uint64_t const start = sys_nanoseconds();
+		FILE *jout = fsu_fopenat(dir, name, "wb");
+		if (jout)
+		{
+			QAJ4C_print_buffer_callback(
+			  in_mods[0].more,
+			  json_print_callback,
+			  jout);
+			fclose(jout);
+		}
+		req->date_updated = in_mods[0].date_updated;
+		req->name = in_mods[0].name ? mem_strdup(in_mods[0].name) : NULL;
+		trace_complete(
+		  "write json",
+		  "install",
+		  start,
+		  sys_nanoseconds(),
+		  req->mod_id);
 
-		free(jpath);
+		fsu_closedir(dir);
 	}
 
 	req->waiting = 0;
@@ -1709,19 +4730,25 @@ on_install_get_modfile(
 	ASSERT(nmodfiles == 1);
 	struct install_request *req = in_userdata;
 
-	// write actual file
-	asprintf(
+	// write actual file, staged until it is complete
+	mem_asprintf(
 	  &req->zip_path,
-	  "%s/mods/%" PRIu64 "/%" PRIu64 ".zip",
+	  "%s/mods/%" PRIu64 "/.%" PRIu64 ".zip",
 	  l_mmi.root_path,
 	  req->game_id,
 	  req->mod_id);
 	FILE *fout = fsu_fopen(req->zip_path, "w+b");
 	ASSERT(fout);
+	req->modfile_id = modfiles[0].id;
+	req->filesize = modfiles[0].filesize;
 
 	req->file = fout;
 
-	netw_download_to(
+	remember_host(modfiles[0].url);
+
+	req->issued = sys_nanoseconds();
+	trace_instant("request", "download", req->mod_id);
+	transport_download_to(
 	  NETW_VERB_GET,
 	  modfiles[0].url,
 	  NULL,
@@ -1751,163 +4778,132 @@ minimod_install(
 	req->mod_id = in_mod_id;
 	req->game_id = in_game_id;
 	req->waiting = 1;
+	trace_instant("install", "install", in_mod_id);
 
+	// the callbacks expect the whole response at once
 	LOG("install: get_mods");
-	minimod_get_mods(NULL, in_game_id, in_mod_id, on_install_get_mod, req);
-	while (req->waiting)
-	{
-		sys_sleep(1);
-	}
-
-	LOG("install: get_modfiles");
-	minimod_get_modfiles(
-	  "_sort=-date_added&_limit=1",
+	get_mods(
+	  NULL,
 	  in_game_id,
 	  in_mod_id,
-	  in_modfile_id,
-	  on_install_get_modfile,
+	  TASK_FLAG_NO_BATCHES,
+	  on_install_get_mod,
 	  req);
-}
-
-
-bool
-minimod_uninstall(uint64_t in_game_id, uint64_t in_mod_id)
-{
-	// check if a json file exists. if it does not, then there is no mod either
-	char *path;
-	asprintf(
-	  &path,
-	  "%s/mods/%" PRIu64 "/%" PRIu64 ".json",
-	  l_mmi.root_path,
-	  in_game_id,
-	  in_mod_id);
-	if (fsu_ptype(path) != FSU_PATHTYPE_FILE)
-	{
-		free(path);
-		return false;
-	}
-	fsu_rmfile(path);
-	free(path);
-
-	// check if the mod was stored as zip
-	asprintf(
-	  &path,
-	  "%s/mods/%" PRIu64 "/%" PRIu64 ".zip",
-	  l_mmi.root_path,
-	  in_game_id,
-	  in_mod_id);
-	if (fsu_ptype(path) == FSU_PATHTYPE_FILE)
-	{
-		fsu_rmfile(path);
-	}
-	free(path);
-
-	// finally and probably redundantly check for dir
-	asprintf(
-	  &path,
-	  "%s/mods/%" PRIu64 "/%" PRIu64,
-	  l_mmi.root_path,
-	  in_game_id,
-	  in_mod_id);
-	if (fsu_ptype(path) == FSU_PATHTYPE_DIR)
-	{
-		fsu_rmdir_recursive(path);
-	}
-	free(path);
-
-	return true;
-}
-
-
-struct enum_data
-{
-	minimod_enum_installed_mods_callback callback;
-	void *userdata;
-	uint64_t game_id;
-};
-
-
-static bool
-is_str_numeric(char const *str, size_t len)
-{
-	for (size_t i = 0; i < len; ++i)
+	while (req->waiting)
 	{
-		if (!isdigit(str[i]))
-		{
-			return false;
-		}
+		sys_sleep(1);
 	}
-	return true;
-}
 
-
-static bool
-str_ends_with_json(char const *str, size_t len)
-{
-	return (len > 5) && (strcmp(str + len - 5, ".json") == 0);
+	LOG("install: get_modfiles");
+	get_modfiles(
+	  "_sort=-date_added&_limit=1",
+	  in_game_id,
+	  in_mod_id,
+	  in_modfile_id,
+	  TASK_FLAG_NO_BATCHES,
+	  on_install_get_modfile,
+	  req);
 }
 
 
-static void
-game_enumerator(
-  char const *root,
-  char const *name,
-  bool is_dir,
-  void *in_userdata)
+bool
+minimod_uninstall(uint64_t in_game_id, uint64_t in_mod_id)
 {
-	struct enum_data *edata = in_userdata;
-
-	if (is_dir)
+	mtx_lock(&l_mmi.installed_mtx);
+	struct modindex_entry const *entry =
+	  modindex_get(&l_mmi.installed, in_game_id, in_mod_id);
+	uint32_t const flags = entry ? entry->flags : 0;
+	if (flags & INSTALLED_JSON)
 	{
-		return;
+		modindex_remove(&l_mmi.installed, in_game_id, in_mod_id);
+		l_mmi.installed_dirty = true;
+	}
+	minimod_installed_changed_callback const callback =
+	  l_mmi.installed_callback;
+	void *const userdata = l_mmi.installed_userdata;
+	mtx_unlock(&l_mmi.installed_mtx);
+	// without a json file there is no mod either
+	if (!(flags & INSTALLED_JSON))
+	{
+		return false;
+	}
+	if (callback)
+	{
+		callback(userdata, in_game_id, in_mod_id, false);
 	}
 
-	size_t l = strlen(name);
-	if (str_ends_with_json(name, l) && is_str_numeric(name, l - 5))
+	fsu_dir const dir = open_game_dir(in_game_id, false);
+	if (dir != FSU_NODIR)
 	{
-		LOG("found mod: %s %s", root, name);
-		uint64_t mod_id = strtoul(name, NULL, 10);
-		LOG("mod_id: %" PRIu64, mod_id);
-		char *path = NULL;
-		asprintf(&path, "%s%" PRIu64 ".zip", root, mod_id);
-		if (fsu_ptype(path) == FSU_PATHTYPE_FILE)
+		char name[MOD_NAME_SIZE];
+		mod_file_name(name, in_mod_id, ".json", false);
+		discard(dir, name);
+		if (flags & INSTALLED_ZIP)
 		{
-			edata->callback(edata->userdata, edata->game_id, mod_id, path);
+			mod_file_name(name, in_mod_id, ".zip", false);
+			discard(dir, name);
 		}
-		else
+		if (flags & INSTALLED_DIR)
 		{
-			free(path);
-			asprintf(&path, "%s%" PRIu64 "/", root, mod_id);
-			edata->callback(edata->userdata, edata->game_id, mod_id, path);
+			mod_file_name(name, in_mod_id, "", false);
+			discard(dir, name);
 		}
-		free(path);
+		fsu_closedir(dir);
 	}
+
+	save_installed();
+	return true;
 }
 
 
-static void
-root_enumerator(
-  char const *root,
-  char const *name,
-  bool is_dir,
-  void *in_userdata)
+// copies the installed mods of *in_game_id*, or of all games if 0, into
+// the arena, so that callbacks may install and uninstall mods
+static struct minimod_installed_mod *
+snapshot_installed(uint64_t in_game_id, size_t *out_nmods)
 {
-	struct enum_data *edata = in_userdata;
-
-	if (is_dir)
+	size_t const npath = strlen(l_mmi.root_path) + 64;
+	mtx_lock(&l_mmi.installed_mtx);
+	struct modindex const *index = &l_mmi.installed;
+	struct minimod_installed_mod *mods =
+	  arena_alloc(index->count * sizeof *mods);
+	ASSERT(mods || index->count == 0);
+	size_t nmods = 0;
+	for (size_t i = 0; i < index->capacity; ++i)
 	{
-		LOG("found dir: %s - %s", root, name);
-		size_t l = strlen(name);
-		bool is_game_id = is_str_numeric(name, l);
-		if (is_game_id)
+		struct modindex_entry const *entry = &index->entries[i];
+		if (!(entry->flags & INSTALLED_JSON) ||
+		  (in_game_id && entry->game_id != in_game_id))
 		{
-			edata->game_id = strtoull(name, NULL, 10);
-			char *path;
-			asprintf(&path, "%s%s/", root, name);
-			fsu_enum_dir(path, game_enumerator, edata);
-			free(path);
+			continue;
 		}
+		char const *name =
+		  entry->name ? l_mmi.installed_names + entry->name : "";
+		size_t const nname = strlen(name) + 1;
+		char *strings = arena_alloc(nname + npath);
+		ASSERT(strings);
+		memcpy(strings, name, nname);
+		// the zip, or the directory it was extracted to
+		snprintf(
+		  strings + nname,
+		  npath,
+		  "%s/mods/%" PRIu64 "/%" PRIu64 "%s",
+		  l_mmi.root_path,
+		  entry->game_id,
+		  entry->mod_id,
+		  (entry->flags & INSTALLED_ZIP) ? ".zip" : "/");
+		mods[nmods++] = (struct minimod_installed_mod){
+			.game_id = entry->game_id,
+			.mod_id = entry->mod_id,
+			.modfile_id = entry->modfile_id,
+			.date_updated = entry->date_updated,
+			.filesize = entry->filesize,
+			.name = strings,
+			.path = strings + nname,
+		};
 	}
+	mtx_unlock(&l_mmi.installed_mtx);
+	*out_nmods = nmods;
+	return mods;
 }
 
 
@@ -1917,25 +4913,65 @@ minimod_enum_installed_mods(
   minimod_enum_installed_mods_callback in_callback,
   void *in_userdata)
 {
-	struct enum_data edata;
-	edata.callback = in_callback;
-	edata.userdata = in_userdata;
-	edata.game_id = in_game_id;
+	struct arena_mark const mark = arena_mark();
+	size_t nmods;
+	struct minimod_installed_mod const *mods =
+	  snapshot_installed(in_game_id, &nmods);
+	for (size_t i = 0; i < nmods; ++i)
+	{
+		in_callback(
+		  in_userdata,
+		  mods[i].game_id,
+		  mods[i].mod_id,
+		  mods[i].path);
+	}
+	arena_release(mark);
+}
 
-	char *path;
-	if (in_game_id)
+
+void
+minimod_get_installed_mods(
+  uint64_t in_game_id,
+  minimod_get_installed_mods_callback in_callback,
+  void *in_userdata)
+{
+	struct arena_mark const mark = arena_mark();
+	size_t nmods;
+	struct minimod_installed_mod const *mods =
+	  snapshot_installed(in_game_id, &nmods);
+	in_callback(in_userdata, nmods, mods);
+	arena_release(mark);
+}
+
+
+bool
+minimod_watch_installed(
+  minimod_installed_changed_callback in_callback,
+  void *in_userdata)
+{
+	watch_stop();
+	mtx_lock(&l_mmi.installed_mtx);
+	l_mmi.installed_callback = in_callback;
+	l_mmi.installed_userdata = in_userdata;
+	mtx_unlock(&l_mmi.installed_mtx);
+	if (!in_callback)
 	{
-		asprintf(&path, "%s/mods/%" PRIu64 "/", l_mmi.root_path, in_game_id);
-		LOG("path-wid: %s", path);
-		fsu_enum_dir(path, game_enumerator, &edata);
+		return true;
 	}
-	else
+
+	char *path;
+	mem_asprintf(&path, "%s/mods/", l_mmi.root_path);
+	fsu_mkdir(path);
+	bool const is_watching = watch_start(path, on_watch, NULL);
+	mem_free(path);
+	if (!is_watching)
 	{
-		asprintf(&path, "%s/mods/", l_mmi.root_path);
-		LOG("path-noid: %s", path);
-		fsu_enum_dir(path, root_enumerator, &edata);
+		mtx_lock(&l_mmi.installed_mtx);
+		l_mmi.installed_callback = NULL;
+		l_mmi.installed_userdata = NULL;
+		mtx_unlock(&l_mmi.installed_mtx);
 	}
-	free(path);
+	return is_watching;
 }
 
 
@@ -1964,8 +5000,13 @@ minimod_get_installed_mod(
   minimod_get_mods_callback in_callback,
   void *in_userdata)
 {
+	if (!minimod_is_installed(in_game_id, in_mod_id))
+	{
+		return false;
+	}
+
 	char *path;
-	asprintf(
+	mem_asprintf(
 	  &path,
 	  "%s/mods/%" PRIu64 "/%" PRIu64 ".json",
 	  l_mmi.root_path,
@@ -1975,41 +5016,52 @@ minimod_get_installed_mod(
 	int64_t fsize_raw = fsu_fsize(path);
 	FILE *jfile = fsu_fopen(path, "rb");
 
-	free(path);
-
 	if (!jfile)
 	{
+		mem_free(path);
 		return false;
 	}
 
 	// load file data into memory
+	bool is_mod = false;
 	if (fsize_raw > 0)
 	{
+		struct arena_mark const mark = arena_mark();
 		size_t fsize = (size_t)fsize_raw;
-		char *filebuffer = malloc(fsize);
-		fread(filebuffer, fsize, 1, jfile);
+		char *filebuffer = arena_alloc(fsize);
+		bool const is_read = fread(filebuffer, fsize, 1, jfile) == 1;
 
 		// load data into QAJ4C
-		size_t nbuffer = QAJ4C_calculate_max_buffer_size_n(filebuffer, fsize);
-		void *buffer = malloc(nbuffer);
-		QAJ4C_Value const *document = NULL;
-		QAJ4C_parse_opt(filebuffer, fsize, 0, buffer, nbuffer, &document);
-		ASSERT(QAJ4C_is_object(document));
-
-		// call callback with data
-		struct minimod_mod mod = { 0 };
-		populate_mod(&mod, document);
-		in_callback(in_userdata, 1, &mod, NULL);
+		struct document *doc;
+		QAJ4C_Value const *document = is_read
+		  ? parse_document(filebuffer, fsize, &doc)
+		  : NULL;
+		// the file may have been written by anyone, or cut short
+		is_mod = QAJ4C_is_object(document);
+		if (is_mod)
+		{
+			// call callback with data
+			struct minimod_mod mod = { 0 };
+			populate_mod(&mod, document);
+			in_callback(in_userdata, 1, &mod, NULL);
+		}
+		else
+		{
+			LOGE("%s is no mod", path);
+		}
 
-		free(buffer);
-		free(filebuffer);
+		if (is_read)
+		{
+			release_document(doc);
+		}
+		arena_release(mark);
 	}
-	else
+	if (!is_mod)
 	{
 		in_callback(in_userdata, 0, NULL, NULL);
 	}
 	fclose(jfile);
-
+	mem_free(path);
 
 	return true;
 }
@@ -2018,17 +5070,199 @@ minimod_get_installed_mod(
 bool
 minimod_is_installed(uint64_t in_game_id, uint64_t in_mod_id)
 {
-	// check if a json file exists. if it does not, then there is no mod either
+	mtx_lock(&l_mmi.installed_mtx);
+	struct modindex_entry const *entry =
+	  modindex_get(&l_mmi.installed, in_game_id, in_mod_id);
+	bool const is_installed = entry && (entry->flags & INSTALLED_JSON);
+	mtx_unlock(&l_mmi.installed_mtx);
+	return is_installed;
+}
+
+
+uint64_t
+minimod_get_installed_modfile_id(uint64_t in_game_id, uint64_t in_mod_id)
+{
+	mtx_lock(&l_mmi.installed_mtx);
+	struct modindex_entry const *entry =
+	  modindex_get(&l_mmi.installed, in_game_id, in_mod_id);
+	uint64_t const modfile_id =
+	  entry && (entry->flags & INSTALLED_JSON) ? entry->modfile_id : 0;
+	mtx_unlock(&l_mmi.installed_mtx);
+	return modfile_id;
+}
+
+
+// the open mod, with a reference added, or NULL if it is not open
+static struct minimod_modfs *
+find_open_mod(uint64_t in_game_id, uint64_t in_mod_id, uint64_t in_modfile_id)
+{
+	struct minimod_modfs *mod = l_mmi.open_mods;
+	while (mod &&
+	  (mod->game_id != in_game_id || mod->mod_id != in_mod_id ||
+	    mod->modfile_id != in_modfile_id))
+	{
+		mod = mod->next;
+	}
+	if (mod)
+	{
+		++mod->refs;
+	}
+	return mod;
+}
+
+
+struct minimod_modfs *
+minimod_mod_open(uint64_t in_game_id, uint64_t in_mod_id)
+{
+	mtx_lock(&l_mmi.installed_mtx);
+	struct modindex_entry const *entry =
+	  modindex_get(&l_mmi.installed, in_game_id, in_mod_id);
+	uint32_t const flags = entry ? entry->flags : 0;
+	uint64_t const modfile_id = entry ? entry->modfile_id : 0;
+	mtx_unlock(&l_mmi.installed_mtx);
+	if ((flags & (INSTALLED_JSON | INSTALLED_ZIP)) !=
+	  (INSTALLED_JSON | INSTALLED_ZIP))
+	{
+		return NULL;
+	}
+
+	mtx_lock(&l_mmi.open_mods_mtx);
+	struct minimod_modfs *mod =
+	  find_open_mod(in_game_id, in_mod_id, modfile_id);
+	mtx_unlock(&l_mmi.open_mods_mtx);
+	if (mod)
+	{
+		return mod;
+	}
+
+	// reads the zip's directory without holding the lock
 	char *path;
-	asprintf(
+	mem_asprintf(
 	  &path,
-	  "%s/mods/%" PRIu64 "/%" PRIu64 ".json",
+	  "%s/mods/%" PRIu64 "/%" PRIu64 ".zip",
 	  l_mmi.root_path,
 	  in_game_id,
 	  in_mod_id);
-	bool is_installed = (fsu_ptype(path) == FSU_PATHTYPE_FILE);
-	free(path);
-	return is_installed;
+	struct zipfs *zip = zipfs_open(path);
+	mem_free(path);
+	if (!zip)
+	{
+		return NULL;
+	}
+
+	mtx_lock(&l_mmi.open_mods_mtx);
+	// unless another thread opened it meanwhile
+	mod = find_open_mod(in_game_id, in_mod_id, modfile_id);
+	if (!mod && (mod = mem_calloc(1, sizeof *mod)))
+	{
+		*mod = (struct minimod_modfs){
+			.zip = zip,
+			.next = l_mmi.open_mods,
+			.game_id = in_game_id,
+			.mod_id = in_mod_id,
+			.modfile_id = modfile_id,
+			.refs = 1,
+		};
+		l_mmi.open_mods = mod;
+		zip = NULL;
+	}
+	mtx_unlock(&l_mmi.open_mods_mtx);
+	zipfs_close(zip);
+	return mod;
+}
+
+
+void
+minimod_mod_close(struct minimod_modfs *in_mod)
+{
+	if (!in_mod)
+	{
+		return;
+	}
+	mtx_lock(&l_mmi.open_mods_mtx);
+	bool const is_unused = --in_mod->refs == 0;
+	if (is_unused)
+	{
+		struct minimod_modfs **link = &l_mmi.open_mods;
+		while (*link != in_mod)
+		{
+			link = &(*link)->next;
+		}
+		*link = in_mod->next;
+	}
+	mtx_unlock(&l_mmi.open_mods_mtx);
+	if (is_unused)
+	{
+		zipfs_close(in_mod->zip);
+		mem_free(in_mod);
+	}
+}
+
+
+struct minimod_modfs_file *
+minimod_mod_file_open(struct minimod_modfs *in_mod, char const *in_path)
+{
+	struct zipfs_file *file = zipfs_file_open(in_mod->zip, in_path);
+	struct minimod_modfs_file *modfs_file =
+	  file ? mem_alloc(sizeof *modfs_file) : NULL;
+	if (!modfs_file)
+	{
+		zipfs_file_close(file);
+		return NULL;
+	}
+	modfs_file->file = file;
+	return modfs_file;
+}
+
+
+void
+minimod_mod_file_close(struct minimod_modfs_file *in_file)
+{
+	if (in_file)
+	{
+		zipfs_file_close(in_file->file);
+		mem_free(in_file);
+	}
+}
+
+
+size_t
+minimod_mod_file_read(
+  struct minimod_modfs_file *in_file,
+  void *out_data,
+  size_t in_bytes)
+{
+	return zipfs_file_read(in_file->file, out_data, in_bytes);
+}
+
+
+bool
+minimod_mod_file_seek(
+  struct minimod_modfs_file *in_file,
+  uint64_t in_position)
+{
+	return zipfs_file_seek(in_file->file, in_position);
+}
+
+
+uint64_t
+minimod_mod_file_tell(struct minimod_modfs_file const *in_file)
+{
+	return zipfs_file_tell(in_file->file);
+}
+
+
+uint64_t
+minimod_mod_file_size(struct minimod_modfs_file const *in_file)
+{
+	return zipfs_file_size(in_file->file);
+}
+
+
+void const *
+minimod_mod_file_data(struct minimod_modfs_file const *in_file)
+{
+	return zipfs_file_data(in_file->file);
 }
 
 
@@ -2068,16 +5302,17 @@ minimod_rate(
 	}
 
 	char *path = NULL;
-	asprintf(
+	mem_asprintf(
 	  &path,
 	  "%s/games/%" PRIu64 "/mods/%" PRIu64 "/ratings",
-	  endpoints[l_mmi.env],
+	  l_mmi.endpoint,
 	  in_game_id,
 	  in_mod_id);
 
 	char const *const headers[] = {
 		// clang-format off
 		"Accept", "application/json",
+		"Accept-Encoding", "gzip, deflate",
 		"Content-Type", "application/x-www-form-urlencoded",
 		"Authorization", l_mmi.token_bearer,
 		NULL
@@ -2090,7 +5325,8 @@ minimod_rate(
 	task->flags |= TASK_FLAG_AUTH_TOKEN;
 	task->callback.userdata = in_userdata;
 	task->callback.fptr.rate = in_callback;
-	if (!netw_request(
+	if (!api_request(
+	      MINIMOD_ENDPOINT_RATINGS,
 	      NETW_VERB_POST,
 	      path,
 	      headers,
@@ -2102,7 +5338,7 @@ minimod_rate(
 		free_task(task);
 	}
 
-	free(path);
+	mem_free(path);
 	return true;
 }
 
@@ -2119,15 +5355,16 @@ minimod_get_ratings(
 	}
 
 	char *path = NULL;
-	asprintf(
+	mem_asprintf(
 	  &path,
 	  "%s/me/ratings?%s",
-	  endpoints[l_mmi.env],
+	  l_mmi.endpoint,
 	  in_filter ? in_filter : "");
 
 	char const *const headers[] = {
 		// clang-format off
 		"Accept", "application/json",
+		"Accept-Encoding", "gzip, deflate",
 		"Authorization", l_mmi.token_bearer,
 		NULL
 		// clang-format on
@@ -2137,7 +5374,8 @@ minimod_get_ratings(
 	task->flags |= TASK_FLAG_AUTH_TOKEN;
 	task->callback.userdata = in_udata;
 	task->callback.fptr.get_ratings = in_callback;
-	if (!netw_request(
+	if (!api_request(
+	      MINIMOD_ENDPOINT_RATINGS,
 	      NETW_VERB_GET,
 	      path,
 	      headers,
@@ -2149,7 +5387,7 @@ minimod_get_ratings(
 		free_task(task);
 	}
 
-	free(path);
+	mem_free(path);
 	return true;
 }
 
@@ -2166,15 +5404,16 @@ minimod_get_subscriptions(
 	}
 
 	char *path = NULL;
-	asprintf(
+	mem_asprintf(
 	  &path,
 	  "%s/me/subscribed?%s",
-	  endpoints[l_mmi.env],
+	  l_mmi.endpoint,
 	  in_filter ? in_filter : "");
 
 	char const *const headers[] = {
 		// clang-format off
 		"Accept", "application/json",
+		"Accept-Encoding", "gzip, deflate",
 		"Authorization", l_mmi.token_bearer,
 		NULL
 		// clang-format on
@@ -2184,7 +5423,8 @@ minimod_get_subscriptions(
 	task->flags |= TASK_FLAG_AUTH_TOKEN;
 	task->callback.userdata = in_udata;
 	task->callback.fptr.get_mods = in_callback;
-	if (!netw_request(
+	if (!api_request(
+	      MINIMOD_ENDPOINT_SUBSCRIPTIONS,
 	      NETW_VERB_GET,
 	      path,
 	      headers,
@@ -2196,7 +5436,7 @@ minimod_get_subscriptions(
 		free_task(task);
 	}
 
-	free(path);
+	mem_free(path);
 	return true;
 }
 
@@ -2216,16 +5456,17 @@ minimod_subscribe(
 	}
 
 	char *path = NULL;
-	asprintf(
+	mem_asprintf(
 	  &path,
 	  "%s/games/%" PRIu64 "/mods/%" PRIu64 "/subscribe",
-	  endpoints[l_mmi.env],
+	  l_mmi.endpoint,
 	  in_game_id,
 	  in_mod_id);
 
 	char const *const headers[] = {
 		// clang-format off
 		"Accept", "application/json",
+		"Accept-Encoding", "gzip, deflate",
 		"Authorization", l_mmi.token_bearer,
 		"Content-Type", "application/x-www-form-urlencoded",
 		NULL
@@ -2239,7 +5480,8 @@ minimod_subscribe(
 	task->meta64 = in_mod_id;
 	task->meta32 = 1;
 
-	if (!netw_request(
+	if (!api_request(
+	      MINIMOD_ENDPOINT_SUBSCRIPTIONS,
 	      NETW_VERB_POST,
 	      path,
 	      headers,
@@ -2251,7 +5493,7 @@ minimod_subscribe(
 		free_task(task);
 	}
 
-	free(path);
+	mem_free(path);
 
 	return true;
 }
@@ -2272,16 +5514,17 @@ minimod_unsubscribe(
 	}
 
 	char *path = NULL;
-	asprintf(
+	mem_asprintf(
 	  &path,
 	  "%s/games/%" PRIu64 "/mods/%" PRIu64 "/subscribe",
-	  endpoints[l_mmi.env],
+	  l_mmi.endpoint,
 	  in_game_id,
 	  in_mod_id);
 
 	char const *const headers[] = {
 		// clang-format off
 		"Accept", "application/json",
+		"Accept-Encoding", "gzip, deflate",
 		"Authorization", l_mmi.token_bearer,
 		"Content-Type", "application/x-www-form-urlencoded",
 		NULL
@@ -2295,7 +5538,8 @@ minimod_unsubscribe(
 	task->meta64 = in_mod_id;
 	task->meta32 = -1;
 
-	if (!netw_request(
+	if (!api_request(
+	      MINIMOD_ENDPOINT_SUBSCRIPTIONS,
 	      NETW_VERB_DELETE,
 	      path,
 	      headers,
@@ -2307,12 +5551,41 @@ minimod_unsubscribe(
 		free_task(task);
 	}
 
-	free(path);
+	mem_free(path);
 
 	return true;
 }
 
 
+bool
+minimod_retain(void const *in_more)
+{
+	mtx_lock(&l_mmi.documents_mtx);
+	struct document *doc = find_document(in_more);
+	if (doc)
+	{
+		++doc->refs;
+	}
+	mtx_unlock(&l_mmi.documents_mtx);
+	return doc;
+}
+
+
+void
+minimod_release(void const *in_more)
+{
+	mtx_lock(&l_mmi.documents_mtx);
+	struct document *doc = find_document(in_more);
+	mtx_unlock(&l_mmi.documents_mtx);
+	if (!doc)
+	{
+		LOGE("released pointer is not part of a retained response");
+		return;
+	}
+	release_document(doc);
+}
+
+
 char const *
 minimod_get_more_string(void const *more, char const *name)
 {
@@ -2347,3 +5620,190 @@ minimod_get_more_bool(void const *more, char const *name)
 	QAJ4C_Value const *obj = QAJ4C_object_get(more, name);
 	return QAJ4C_is_bool(obj) ? QAJ4C_get_bool(obj) : 0;
 }
+
+
+// a step of a compiled path, either a key or an array index
+struct path_step
+{
+	// NULL for an array index
+	char const *key;
+	size_t key_len;
+	size_t index;
+	// member the key was found at last time, updated by all threads
+	size_t hint;
+};
+
+
+struct minimod_path
+{
+	size_t nsteps;
+	struct path_step steps[];
+};
+
+
+struct minimod_path *
+minimod_path_compile(char const *in_path)
+{
+	ASSERT(in_path);
+
+	// upper bound, each step starts with a separator but the first
+	size_t const len = strlen(in_path);
+	size_t nsteps = 1;
+	for (size_t i = 0; i < len; ++i)
+	{
+		if (in_path[i] == '.' || in_path[i] == '[')
+		{
+			++nsteps;
+		}
+	}
+
+	struct minimod_path *path =
+	  mem_alloc(sizeof *path + nsteps * sizeof *path->steps + len + 1);
+	if (!path)
+	{
+		return NULL;
+	}
+	// the keys point into a copy of the path following the steps
+	char *keys = (char *)(path->steps + nsteps);
+	memcpy(keys, in_path, len + 1);
+
+	path->nsteps = 0;
+	char const *c = keys;
+	bool valid = true;
+	while (valid && (*c || path->nsteps == 0))
+	{
+		// only a step without separator can exceed the bound
+		if (path->nsteps == nsteps)
+		{
+			valid = false;
+			break;
+		}
+
+		struct path_step *step = &path->steps[path->nsteps++];
+		*step = (struct path_step){ 0 };
+		if (*c == '[')
+		{
+			char *end = NULL;
+			valid = isdigit((uint8_t)c[1]);
+			if (valid)
+			{
+				step->index = (size_t)strtoull(c + 1, &end, 10);
+				valid = *end == ']';
+				c = end + 1;
+			}
+		}
+		else
+		{
+			if (path->nsteps > 1)
+			{
+				valid = *c++ == '.';
+			}
+			step->key = c;
+			step->key_len = strcspn(c, ".[");
+			valid = valid && step->key_len > 0;
+			c += step->key_len;
+		}
+	}
+
+	if (!valid)
+	{
+		LOGE("invalid path '%s'", in_path);
+		mem_free(path);
+		return NULL;
+	}
+	return path;
+}
+
+
+void
+minimod_path_free(struct minimod_path *in_path)
+{
+	mem_free(in_path);
+}
+
+
+static QAJ4C_Value const *
+path_member(QAJ4C_Value const *in_object, struct path_step *step)
+{
+	// items of a list mostly have their members in the same order,
+	// thusly the search starts where the key was found last time
+	size_t const nmembers = QAJ4C_object_size(in_object);
+	size_t const hint = __atomic_load_n(&step->hint, __ATOMIC_RELAXED);
+	size_t i = hint < nmembers ? hint : 0;
+	for (size_t n = 0; n < nmembers; ++n, ++i)
+	{
+		if (i == nmembers)
+		{
+			i = 0;
+		}
+		QAJ4C_Member const *member = QAJ4C_object_get_member(in_object, i);
+		QAJ4C_Value const *key = QAJ4C_member_get_key(member);
+		if (QAJ4C_get_string_length(key) == step->key_len &&
+		  0 == memcmp(QAJ4C_get_string(key), step->key, step->key_len))
+		{
+			if (i != hint)
+			{
+				__atomic_store_n(&step->hint, i, __ATOMIC_RELAXED);
+			}
+			return QAJ4C_member_get_value(member);
+		}
+	}
+	return NULL;
+}
+
+
+static QAJ4C_Value const *
+path_lookup(void const *in_more, struct minimod_path *in_path)
+{
+	ASSERT(in_path);
+	QAJ4C_Value const *value = in_more;
+	for (size_t i = 0; value && i < in_path->nsteps; ++i)
+	{
+		// qajson4c asserts the type, a mismatch is no error to minimod
+		struct path_step *step = &in_path->steps[i];
+		if (step->key)
+		{
+			value = QAJ4C_is_object(value) ? path_member(value, step) : NULL;
+		}
+		else
+		{
+			value = QAJ4C_is_array(value) &&
+			    step->index < QAJ4C_array_size(value)
+			  ? QAJ4C_array_get(value, step->index)
+			  : NULL;
+		}
+	}
+	return value;
+}
+
+
+char const *
+minimod_path_get_string(void const *in_more, struct minimod_path *in_path)
+{
+	QAJ4C_Value const *value = path_lookup(in_more, in_path);
+	return QAJ4C_is_string(value) ? QAJ4C_get_string(value) : NULL;
+}
+
+
+int64_t
+minimod_path_get_int(void const *in_more, struct minimod_path *in_path)
+{
+	QAJ4C_Value const *value = path_lookup(in_more, in_path);
+	return QAJ4C_is_int64(value) ? QAJ4C_get_int64(value) : 0;
+}
+
+
+double
+minimod_path_get_float(void const *in_more, struct minimod_path *in_path)
+{
+	QAJ4C_Value const *value = path_lookup(in_more, in_path);
+	return QAJ4C_is_double(value) ? QAJ4C_get_double(value) : 0;
+}
+
+
+bool
+minimod_path_get_bool(void const *in_more, struct minimod_path *in_path)
+{
+	QAJ4C_Value const *value = path_lookup(in_more, in_path);
+	return QAJ4C_is_bool(value) ? QAJ4C_get_bool(value) : false;
+}
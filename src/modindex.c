@@ -0,0 +1,186 @@
+#include "modindex.h"
+
+#include "log.h"
+#include "util.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#pragma GCC diagnostic push
+#ifdef __clang__
+#pragma GCC diagnostic ignored "-Wgnu-zero-variadic-macro-arguments"
+#endif
+#pragma GCC diagnostic ignored "-Wunused-macros"
+
+#define LOG(FMT, ...) LOG_DEBUG("modindex", FMT, ##__VA_ARGS__)
+#define LOGE(FMT, ...) LOG_ERROR("modindex", FMT, ##__VA_ARGS__)
+
+#pragma GCC diagnostic pop
+
+// CONFIG
+// ------
+// entries of a table once the first one is added
+#define MODINDEX_MIN_CAPACITY 64
+// grows once more than 3/4 of the entries are used
+#define MODINDEX_MAX_LOAD(CAPACITY) ((CAPACITY) / 4 * 3)
+
+
+// the capacity is a power of 2
+static size_t
+home_slot(uint64_t in_game_id, uint64_t in_mod_id, size_t in_capacity)
+{
+	uint64_t h = (in_mod_id ^ (in_game_id << 32 | in_game_id >> 32)) *
+	  0x9e3779b97f4a7c15ull;
+	h ^= h >> 32;
+	return (size_t)h & (in_capacity - 1);
+}
+
+
+// the entry of the mod or the unused entry where it belongs
+static struct modindex_entry *
+probe(
+  struct modindex const *in_index,
+  uint64_t in_game_id,
+  uint64_t in_mod_id)
+{
+	size_t const mask = in_index->capacity - 1;
+	size_t i = home_slot(in_game_id, in_mod_id, in_index->capacity);
+	for (;;)
+	{
+		struct modindex_entry *entry = &in_index->entries[i];
+		if (entry->mod_id == 0 ||
+		  (entry->mod_id == in_mod_id && entry->game_id == in_game_id))
+		{
+			return entry;
+		}
+		i = (i + 1) & mask;
+	}
+}
+
+
+// the capacity has to be a power of 2
+static bool
+resize(struct modindex *io_index, size_t in_capacity)
+{
+	struct modindex_entry *entries = mem_calloc(in_capacity, sizeof *entries);
+	if (!entries)
+	{
+		LOGE("could not grow to %zu entries", in_capacity);
+		return false;
+	}
+
+	struct modindex old = *io_index;
+	io_index->entries = entries;
+	io_index->capacity = in_capacity;
+	for (size_t i = 0; i < old.capacity; ++i)
+	{
+		if (old.entries[i].mod_id)
+		{
+			*probe(io_index, old.entries[i].game_id, old.entries[i].mod_id) =
+			  old.entries[i];
+		}
+	}
+	mem_free(old.entries);
+	return true;
+}
+
+
+bool
+modindex_reserve(struct modindex *io_index, size_t in_count)
+{
+	if (in_count <= MODINDEX_MAX_LOAD(io_index->capacity))
+	{
+		return true;
+	}
+	size_t capacity = io_index->capacity
+	  ? io_index->capacity * 2
+	  : MODINDEX_MIN_CAPACITY;
+	while (in_count > MODINDEX_MAX_LOAD(capacity))
+	{
+		capacity *= 2;
+	}
+	return resize(io_index, capacity);
+}
+
+
+struct modindex_entry *
+modindex_get(
+  struct modindex const *in_index,
+  uint64_t in_game_id,
+  uint64_t in_mod_id)
+{
+	if (in_index->count == 0 || in_mod_id == 0)
+	{
+		return NULL;
+	}
+	struct modindex_entry *entry = probe(in_index, in_game_id, in_mod_id);
+	return entry->mod_id ? entry : NULL;
+}
+
+
+struct modindex_entry *
+modindex_put(
+  struct modindex *io_index,
+  uint64_t in_game_id,
+  uint64_t in_mod_id)
+{
+	struct modindex_entry *entry =
+	  modindex_get(io_index, in_game_id, in_mod_id);
+	if (entry)
+	{
+		return entry;
+	}
+	if (!modindex_reserve(io_index, io_index->count + 1))
+	{
+		return NULL;
+	}
+	entry = probe(io_index, in_game_id, in_mod_id);
+	*entry = (struct modindex_entry){
+		.game_id = in_game_id,
+		.mod_id = in_mod_id,
+	};
+	++io_index->count;
+	return entry;
+}
+
+
+void
+modindex_remove(
+  struct modindex *io_index,
+  uint64_t in_game_id,
+  uint64_t in_mod_id)
+{
+	struct modindex_entry *entry =
+	  modindex_get(io_index, in_game_id, in_mod_id);
+	if (!entry)
+	{
+		return;
+	}
+	--io_index->count;
+
+	// moves the following entries back into the gap, unless they already
+	// are at or before their home slot, so that no probe ends early
+	size_t const mask = io_index->capacity - 1;
+	size_t gap = (size_t)(entry - io_index->entries);
+	for (size_t i = (gap + 1) & mask; io_index->entries[i].mod_id;
+	     i = (i + 1) & mask)
+	{
+		struct modindex_entry const *next = &io_index->entries[i];
+		size_t const home =
+		  home_slot(next->game_id, next->mod_id, io_index->capacity);
+		if (((i - home) & mask) >= ((i - gap) & mask))
+		{
+			io_index->entries[gap] = *next;
+			gap = i;
+		}
+	}
+	io_index->entries[gap] = (struct modindex_entry){ 0 };
+}
+
+
+void
+modindex_free(struct modindex *io_index)
+{
+	mem_free(io_index->entries);
+	*io_index = (struct modindex){ 0 };
+}
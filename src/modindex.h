@@ -0,0 +1,127 @@
+// vi: filetype=c
+#pragma once
+#ifndef MINIMOD_MODINDEX_H_INCLUDED
+#define MINIMOD_MODINDEX_H_INCLUDED
+
+/* Title: modindex
+ *
+ * Topic: Introduction
+ *
+ * Hash table of mods, keyed by game and mod id, with open addressing and
+ * linear probing, thusly lookups usually touch a single cache line.
+ *
+ * The table is not synchronized, callers have to lock it themselves.
+ */
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Section: API */
+
+/* Struct: modindex_entry
+ *
+ * All members besides the key are free for the caller to use. The entry
+ * has no padding and only fixed-size members, so it can be written to
+ * files as it is.
+ *
+ * game_id - Game the mod belongs to.
+ * mod_id - 0 marks unused entries.
+ * modfile_id - Modfile installed.
+ * date_updated - Of the mod, when it was installed.
+ * filesize - Of the modfile.
+ * name - Offset of the mod's name in a string table.
+ * flags - State of the installation.
+ */
+struct modindex_entry
+{
+	uint64_t game_id;
+	uint64_t mod_id;
+	uint64_t modfile_id;
+	uint64_t date_updated;
+	uint64_t filesize;
+	uint32_t name;
+	uint32_t flags;
+};
+
+/* Struct: modindex
+ *
+ * Zero-initialized it is an empty table.
+ *
+ * entries - *capacity* entries, including the unused ones. Entries are
+ *	moved when other entries are added or removed.
+ */
+struct modindex
+{
+	struct modindex_entry *entries;
+	size_t capacity;
+	size_t count;
+};
+
+/* Function: modindex_reserve()
+ *
+ * Make room for *in_count* entries in total, so that adding them does
+ * not grow the table step by step.
+ *
+ * Returns:
+ *	false if the heap is exhausted.
+ */
+bool
+modindex_reserve(struct modindex *io_index, size_t in_count);
+
+/* Function: modindex_get()
+ *
+ * Returns:
+ *	The entry of the mod, or NULL if there is none.
+ */
+struct modindex_entry *
+modindex_get(
+  struct modindex const *in_index,
+  uint64_t in_game_id,
+  uint64_t in_mod_id);
+
+/* Function: modindex_put()
+ *
+ * Like <modindex_get()>, but adds an entry with all other members 0 if
+ * there is none yet.
+ *
+ * Parameters:
+ *	in_mod_id - Cannot be 0.
+ *
+ * Returns:
+ *	NULL if the heap is exhausted.
+ */
+struct modindex_entry *
+modindex_put(
+  struct modindex *io_index,
+  uint64_t in_game_id,
+  uint64_t in_mod_id);
+
+/* Function: modindex_remove()
+ *
+ * Remove the entry of the mod, if there is one.
+ */
+void
+modindex_remove(
+  struct modindex *io_index,
+  uint64_t in_game_id,
+  uint64_t in_mod_id);
+
+/* Function: modindex_free()
+ *
+ * Free all entries, leaving an empty table.
+ */
+void
+modindex_free(struct modindex *io_index);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,264 @@
+#include "trace.h"
+
+#include "log.h"
+#include "util.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#pragma GCC diagnostic push
+#ifdef __clang__
+#pragma GCC diagnostic ignored "-Wgnu-zero-variadic-macro-arguments"
+#endif
+#pragma GCC diagnostic ignored "-Wunused-macros"
+
+#define LOG(FMT, ...) LOG_DEBUG("trace", FMT, ##__VA_ARGS__)
+#define LOGE(FMT, ...) LOG_ERROR("trace", FMT, ##__VA_ARGS__)
+// bypasses the queue, since the process stops right after
+#define LOGA(FMT, ...) fprintf(stderr, "[trace] " FMT "\n", ##__VA_ARGS__)
+
+#pragma GCC diagnostic pop
+
+// CONFIG
+// ------
+// number of events kept per thread
+#define TRACE_CAPACITY 4096
+
+
+struct trace_event
+{
+	char const *name;
+	char const *category;
+	uint64_t start;
+	uint64_t duration;
+	uint64_t id;
+	uint32_t tid;
+	char phase;
+	char _padding[3];
+};
+
+
+// each thread records into its own buffer, so recording needs no locks.
+// buffers of threads which exited are reused by new threads.
+struct trace_buffer
+{
+	struct trace_buffer *next;
+	// number of events ever recorded. the ring's write index is
+	// nevents % TRACE_CAPACITY.
+	uint64_t nevents;
+	uint32_t tid;
+	bool in_use;
+	char _padding[3];
+	struct trace_event events[TRACE_CAPACITY];
+};
+
+
+struct trace
+{
+	// all buffers ever allocated
+	struct trace_buffer *buffers;
+	// timestamps are written relative to this
+	uint64_t epoch;
+	tss_t key;
+	uint32_t next_tid;
+	bool enabled;
+	bool has_key;
+	char _padding[6];
+};
+static struct trace l_trace;
+
+
+static void
+release_buffer(void *in_buffer)
+{
+	struct trace_buffer *buffer = in_buffer;
+	__atomic_store_n(&buffer->in_use, false, __ATOMIC_RELEASE);
+}
+
+
+static struct trace_buffer *
+get_buffer(void)
+{
+	struct trace_buffer *buffer = tss_get(l_trace.key);
+	if (buffer)
+	{
+		return buffer;
+	}
+
+	// take over the buffer of a thread that exited
+	buffer = __atomic_load_n(&l_trace.buffers, __ATOMIC_ACQUIRE);
+	while (buffer)
+	{
+		bool expected = false;
+		if (__atomic_compare_exchange_n(
+		      &buffer->in_use,
+		      &expected,
+		      true,
+		      false,
+		      __ATOMIC_ACQ_REL,
+		      __ATOMIC_RELAXED))
+		{
+			break;
+		}
+		buffer = buffer->next;
+	}
+
+	// or add a new one
+	if (!buffer)
+	{
+		buffer = mem_calloc(1, sizeof *buffer);
+		if (!buffer)
+		{
+			return NULL;
+		}
+		buffer->in_use = true;
+		buffer->next = __atomic_load_n(&l_trace.buffers, __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(
+		  &l_trace.buffers,
+		  &buffer->next,
+		  buffer,
+		  true,
+		  __ATOMIC_RELEASE,
+		  __ATOMIC_RELAXED))
+		{
+		}
+	}
+
+	buffer->tid = __atomic_add_fetch(&l_trace.next_tid, 1, __ATOMIC_RELAXED);
+	tss_set(l_trace.key, buffer);
+	return buffer;
+}
+
+
+static void
+record(
+  char in_phase,
+  char const *in_name,
+  char const *in_category,
+  uint64_t in_start,
+  uint64_t in_duration,
+  uint64_t in_id)
+{
+	if (!__atomic_load_n(&l_trace.enabled, __ATOMIC_RELAXED))
+	{
+		return;
+	}
+
+	struct trace_buffer *buffer = get_buffer();
+	if (!buffer)
+	{
+		return;
+	}
+
+	uint64_t const n = buffer->nevents;
+	struct trace_event *event = &buffer->events[n % TRACE_CAPACITY];
+	event->name = in_name;
+	event->category = in_category;
+	event->start = in_start;
+	event->duration = in_duration;
+	event->id = in_id;
+	event->tid = buffer->tid;
+	event->phase = in_phase;
+	__atomic_store_n(&buffer->nevents, n + 1, __ATOMIC_RELEASE);
+}
+
+
+void
+trace_enable(bool in_enable)
+{
+	if (in_enable && !l_trace.has_key)
+	{
+		if (tss_create(&l_trace.key, release_buffer) != thrd_success)
+		{
+			LOGE("could not create thread-specific storage");
+			return;
+		}
+		l_trace.has_key = true;
+		l_trace.epoch = sys_nanoseconds();
+	}
+	__atomic_store_n(&l_trace.enabled, in_enable, __ATOMIC_RELAXED);
+}
+
+
+void
+trace_complete(
+  char const *in_name,
+  char const *in_category,
+  uint64_t in_start,
+  uint64_t in_end,
+  uint64_t in_id)
+{
+	record('X', in_name, in_category, in_start, in_end - in_start, in_id);
+}
+
+
+void
+trace_instant(char const *in_name, char const *in_category, uint64_t in_id)
+{
+	record('i', in_name, in_category, sys_nanoseconds(), 0, in_id);
+}
+
+
+static void
+write_event(FILE *in_file, struct trace_event const *in_event)
+{
+	// timestamps are in microseconds
+	double const ts = (double)(int64_t)(in_event->start - l_trace.epoch) / 1e3;
+	fprintf(
+	  in_file,
+	  "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%u,"
+	  "\"ts\":%.3f",
+	  in_event->name,
+	  in_event->category,
+	  in_event->phase,
+	  in_event->tid,
+	  ts);
+	if (in_event->phase == 'X')
+	{
+		fprintf(in_file, ",\"dur\":%.3f", (double)in_event->duration / 1e3);
+	}
+	else
+	{
+		// instant events are scoped to their thread
+		fputs(",\"s\":\"t\"", in_file);
+	}
+	if (in_event->id)
+	{
+		fprintf(in_file, ",\"args\":{\"id\":%" PRIu64 "}", in_event->id);
+	}
+	fputc('}', in_file);
+}
+
+
+bool
+trace_write(char const *in_path)
+{
+	FILE *f = fsu_fopen(in_path, "wb");
+	if (!f)
+	{
+		LOGE("could not open %s", in_path);
+		return false;
+	}
+
+	fputs("{\"traceEvents\":[", f);
+	char const *separator = "\n";
+	struct trace_buffer const *buffer =
+	  __atomic_load_n(&l_trace.buffers, __ATOMIC_ACQUIRE);
+	for (; buffer; buffer = buffer->next)
+	{
+		uint64_t const n = __atomic_load_n(&buffer->nevents, __ATOMIC_ACQUIRE);
+		uint64_t const first = n > TRACE_CAPACITY ? n - TRACE_CAPACITY : 0;
+		for (uint64_t i = first; i < n; ++i)
+		{
+			fputs(separator, f);
+			write_event(f, &buffer->events[i % TRACE_CAPACITY]);
+			separator = ",\n";
+		}
+	}
+	fputs("\n],\"displayTimeUnit\":\"ms\"}\n", f);
+
+	bool const ok = !ferror(f);
+	fclose(f);
+	LOG("trace written to %s", in_path);
+	return ok;
+}
@@ -0,0 +1,83 @@
+// vi: filetype=c
+#pragma once
+#ifndef MINIMOD_TRACE_H_INCLUDED
+#define MINIMOD_TRACE_H_INCLUDED
+
+/* Title: trace
+ *
+ * Topic: Introduction
+ *
+ * Records timestamped events into per-thread ring buffers and writes
+ * them in Chrome's trace event format, to be viewed with chrome://tracing
+ * or https://ui.perfetto.dev
+ *
+ * Recording is disabled by default, in which case the trace-functions
+ * return right away.
+ */
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Section: API */
+
+/* Function: trace_enable()
+ *
+ * Start or stop recording events. Events recorded so far are kept.
+ *
+ * Attention:
+ *	Not thread-safe. Do not call it concurrently with itself.
+ */
+void
+trace_enable(bool in_enable);
+
+/* Function: trace_complete()
+ *
+ * Record an event which started at *in_start* and ended at *in_end*.
+ * Both are timestamps as returned by sys_nanoseconds().
+ *
+ * Parameters:
+ *	in_name - Name of the event. Only the pointer is stored, thusly it
+ *		has to be a string literal.
+ *	in_category - Like *in_name*, used to group events.
+ *	in_id - Shown in the event's arguments, unless it is 0.
+ */
+void
+trace_complete(
+  char const *in_name,
+  char const *in_category,
+  uint64_t in_start,
+  uint64_t in_end,
+  uint64_t in_id);
+
+/* Function: trace_instant()
+ *
+ * Record an event without duration, which happens right now.
+ * See <trace_complete()> for the parameters.
+ */
+void
+trace_instant(char const *in_name, char const *in_category, uint64_t in_id);
+
+/* Function: trace_write()
+ *
+ * Write all recorded events, up to the capacity of the ring buffers,
+ * to *in_path* as JSON.
+ *
+ * Events recorded while writing may or may not be included.
+ *
+ * Returns:
+ *	false if the file could not be written.
+ */
+bool
+trace_write(char const *in_path);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,898 @@
+#include "transport.h"
+
+#include "log.h"
+#include "util.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define UNUSED(X) __pragma(warning(suppress : 4100)) X
+#else
+#define UNUSED(X) __attribute__((unused)) X
+#endif
+
+#pragma GCC diagnostic push
+#ifdef __clang__
+#pragma GCC diagnostic ignored "-Wgnu-zero-variadic-macro-arguments"
+#endif
+#pragma GCC diagnostic ignored "-Wunused-macros"
+
+#define LOG(FMT, ...) LOG_DEBUG("transport", FMT, ##__VA_ARGS__)
+#define LOGE(FMT, ...) LOG_ERROR("transport", FMT, ##__VA_ARGS__)
+
+#pragma GCC diagnostic pop
+
+// CONFIG
+// ------
+// at most as many headers are recorded per response
+#define MAX_HEADERS 4
+
+// the only headers minimod looks at
+static char const *const recorded_headers[] = {
+	"Content-Encoding",
+	"X-RateLimit-RetryAfter",
+};
+
+// File format
+// -----------
+// All integers are in native byte order, thusly trace files are not
+// meant to be moved between architectures.
+//
+// magic: "mmtrace1"
+// records until EOF:
+//	u32 kind, u32 verb, u32 status, u32 nheaders, u64 elapsed_ns
+//	u32 nuri, uri
+//	nheaders times: u32 nname, name, u32 nvalue, value
+//	u64 nbody, body
+static char const magic[8] = "mmtrace1";
+
+
+enum record_kind
+{
+	RECORD_REQUEST,
+	RECORD_DOWNLOAD,
+};
+
+
+struct record
+{
+	char *uri;
+	// name, value, name, value, ...
+	char *headers[2 * MAX_HEADERS];
+	void *body;
+	uint64_t nbody;
+	uint64_t elapsed;
+	// how often it was replayed. the least replayed match is used next.
+	uint32_t nserved;
+	uint32_t kind;
+	uint32_t verb;
+	uint32_t status;
+	uint32_t nheaders;
+	char _padding[4];
+};
+
+
+// a response waiting to be replayed
+struct job
+{
+	struct job *next;
+	struct record const *record;
+	transport_response_callback response;
+	transport_download_callback download;
+	void *udata;
+	FILE *file;
+	uint64_t due;
+	int status;
+	char _padding[4];
+};
+
+
+// a request in flight while recording
+struct recording
+{
+	transport_response_callback response;
+	transport_download_callback download;
+	void *udata;
+	char *uri;
+	uint64_t start;
+	enum netw_verb verb;
+	char _padding[4];
+};
+
+
+struct transport
+{
+	enum minimod_transport mode;
+	int error_rate;
+	int min_delay;
+	int max_delay;
+	// RECORD
+	FILE *out;
+	// of *out*, which is closed by transport_stop() and appended to after
+	// the next transport_start()
+	char *path;
+	// REPLAY
+	struct record *records;
+	size_t nrecords;
+	// jobs sorted by due time
+	struct job *jobs;
+	thrd_t thread;
+	// guards out, records[].nserved, jobs and rand()
+	mtx_t mtx;
+	// signalled when a job is enqueued, or the thread shall stop
+	cnd_t wake;
+	bool has_mtx;
+	bool running;
+	char _padding[6];
+};
+static struct transport l_transport;
+
+
+static void
+free_records(void)
+{
+	for (size_t i = 0; i < l_transport.nrecords; ++i)
+	{
+		struct record *r = &l_transport.records[i];
+		mem_free(r->uri);
+		for (size_t h = 0; h < 2 * MAX_HEADERS; ++h)
+		{
+			mem_free(r->headers[h]);
+		}
+		mem_free(r->body);
+	}
+	mem_free(l_transport.records);
+	l_transport.records = NULL;
+	l_transport.nrecords = 0;
+}
+
+
+// copies *in_uri* without its api_key parameter. it does not belong into
+// files which are shared as test fixtures, and replaying has to work with
+// any key.
+static char *
+strip_api_key(char const *in_uri)
+{
+	char *uri = mem_strdup(in_uri);
+	// the '?' or '&' in front of each parameter
+	char *param = uri ? strchr(uri, '?') : NULL;
+	while (param)
+	{
+		char *end = param + 1 + strcspn(param + 1, "&#");
+		if (0 != strncmp(param + 1, "api_key=", 8))
+		{
+			param = *end == '&' ? end : NULL;
+		}
+		else if (*end == '&')
+		{
+			// the next parameter takes its place
+			memmove(param + 1, end + 1, strlen(end + 1) + 1);
+		}
+		else
+		{
+			// the last one goes along with its separator
+			memmove(param, end, strlen(end) + 1);
+			param = NULL;
+		}
+	}
+	return uri;
+}
+
+
+// returns a NUL-terminated buffer of *in_size* bytes
+static void *
+read_blob(FILE *in_file, uint64_t in_size)
+{
+	if (in_size > SIZE_MAX - 1)
+	{
+		return NULL;
+	}
+	char *blob = mem_alloc((size_t)in_size + 1);
+	if (blob && fread(blob, 1, (size_t)in_size, in_file) != in_size)
+	{
+		mem_free(blob);
+		return NULL;
+	}
+	if (blob)
+	{
+		blob[in_size] = '\0';
+	}
+	return blob;
+}
+
+
+static char *
+read_string(FILE *in_file)
+{
+	uint32_t len;
+	if (fread(&len, sizeof len, 1, in_file) != 1)
+	{
+		return NULL;
+	}
+	return read_blob(in_file, len);
+}
+
+
+static bool
+read_record(FILE *in_file, struct record *out_record)
+{
+	uint32_t fields[4];
+	if (fread(fields, sizeof fields, 1, in_file) != 1 ||
+	  fread(&out_record->elapsed, sizeof out_record->elapsed, 1, in_file) !=
+	    1)
+	{
+		return false;
+	}
+	out_record->kind = fields[0];
+	out_record->verb = fields[1];
+	out_record->status = fields[2];
+	out_record->nheaders = fields[3];
+	if (out_record->nheaders > MAX_HEADERS)
+	{
+		out_record->nheaders = 0;
+		return false;
+	}
+
+	out_record->uri = read_string(in_file);
+	if (!out_record->uri)
+	{
+		return false;
+	}
+	for (size_t h = 0; h < 2 * out_record->nheaders; ++h)
+	{
+		out_record->headers[h] = read_string(in_file);
+		if (!out_record->headers[h])
+		{
+			return false;
+		}
+	}
+
+	if (fread(&out_record->nbody, sizeof out_record->nbody, 1, in_file) != 1)
+	{
+		return false;
+	}
+	out_record->body = read_blob(in_file, out_record->nbody);
+	return out_record->body;
+}
+
+
+static bool
+read_records(char const *in_path)
+{
+	FILE *f = fsu_fopen(in_path, "rb");
+	if (!f)
+	{
+		LOGE("could not open %s", in_path);
+		return false;
+	}
+
+	char m[sizeof magic];
+	if (fread(m, sizeof m, 1, f) != 1 || 0 != memcmp(m, magic, sizeof m))
+	{
+		LOGE("%s is not a trace file", in_path);
+		fclose(f);
+		return false;
+	}
+
+	size_t capacity = 0;
+	for (;;)
+	{
+		if (l_transport.nrecords == capacity)
+		{
+			capacity = capacity ? capacity * 2 : 64;
+			struct record *records = mem_realloc(
+			  l_transport.records,
+			  capacity * sizeof *l_transport.records);
+			if (!records)
+			{
+				break;
+			}
+			l_transport.records = records;
+		}
+		struct record *r = &l_transport.records[l_transport.nrecords];
+		*r = (struct record){ 0 };
+		bool const complete = read_record(f, r);
+		// partially read records are freed along with the others
+		l_transport.nrecords += (r->uri != NULL);
+		if (!complete)
+		{
+			if (r->uri)
+			{
+				free_records();
+				LOGE("%s is truncated", in_path);
+				fclose(f);
+				return false;
+			}
+			break;
+		}
+	}
+
+	fclose(f);
+	LOG("%zu records read from %s", l_transport.nrecords, in_path);
+	return true;
+}
+
+
+static void
+write_string(char const *in_string, FILE *out_file)
+{
+	uint32_t const len = (uint32_t)strlen(in_string);
+	fwrite(&len, sizeof len, 1, out_file);
+	fwrite(in_string, len, 1, out_file);
+}
+
+
+static void
+write_record(
+  struct recording const *in_recording,
+  enum record_kind in_kind,
+  int in_status,
+  struct netw_header const *in_header,
+  void const *in_body,
+  uint64_t in_nbody)
+{
+	uint64_t const elapsed = sys_nanoseconds() - in_recording->start;
+
+	char const *headers[2 * MAX_HEADERS];
+	uint32_t nheaders = 0;
+	size_t const nrecorded =
+	  sizeof recorded_headers / sizeof *recorded_headers;
+	for (size_t i = 0; in_header && i < nrecorded && nheaders < MAX_HEADERS;
+	     ++i)
+	{
+		char const *value = netw_get_header(in_header, recorded_headers[i]);
+		if (value)
+		{
+			headers[2 * nheaders + 0] = recorded_headers[i];
+			headers[2 * nheaders + 1] = value;
+			++nheaders;
+		}
+	}
+
+	uint32_t const fields[4] = {
+		in_kind,
+		(uint32_t)in_recording->verb,
+		(uint32_t)in_status,
+		nheaders,
+	};
+
+	mtx_lock(&l_transport.mtx);
+	FILE *f = l_transport.out;
+	// responses arriving during minimod_deinit() are not recorded
+	if (!f)
+	{
+		mtx_unlock(&l_transport.mtx);
+		return;
+	}
+	fwrite(fields, sizeof fields, 1, f);
+	fwrite(&elapsed, sizeof elapsed, 1, f);
+	write_string(in_recording->uri, f);
+	for (size_t h = 0; h < 2 * nheaders; ++h)
+	{
+		write_string(headers[h], f);
+	}
+	fwrite(&in_nbody, sizeof in_nbody, 1, f);
+	if (in_nbody > 0)
+	{
+		fwrite(in_body, (size_t)in_nbody, 1, f);
+	}
+	fflush(f);
+	mtx_unlock(&l_transport.mtx);
+}
+
+
+static void
+on_recorded_response(
+  void *in_udata,
+  void const *in_data,
+  size_t in_len,
+  int error,
+  struct netw_header const *header)
+{
+	struct recording *rec = in_udata;
+	write_record(rec, RECORD_REQUEST, error, header, in_data, in_len);
+	rec->response(rec->udata, in_data, in_len, error, header);
+	mem_free(rec->uri);
+	mem_free(rec);
+}
+
+
+static void
+on_recorded_download(
+  void *in_udata,
+  FILE *in_file,
+  int error,
+  struct netw_header const *header)
+{
+	struct recording *rec = in_udata;
+
+	// the file is handed over with its position at the end
+	void *body = NULL;
+	long const size = in_file ? ftell(in_file) : 0;
+	if (size > 0 && 0 == fseek(in_file, 0, SEEK_SET))
+	{
+		body = read_blob(in_file, (uint64_t)size);
+		fseek(in_file, 0, SEEK_END);
+	}
+	write_record(
+	  rec,
+	  RECORD_DOWNLOAD,
+	  error,
+	  header,
+	  body,
+	  body ? (uint64_t)size : 0);
+	mem_free(body);
+
+	rec->download(rec->udata, in_file, error, header);
+	mem_free(rec->uri);
+	mem_free(rec);
+}
+
+
+// returns NULL if out of memory
+static struct recording *
+alloc_recording(enum netw_verb in_verb, char const *in_uri)
+{
+	struct recording *rec = mem_calloc(1, sizeof *rec);
+	char *uri = strip_api_key(in_uri);
+	if (!rec || !uri)
+	{
+		mem_free(rec);
+		mem_free(uri);
+		return NULL;
+	}
+	rec->verb = in_verb;
+	rec->uri = uri;
+	rec->start = sys_nanoseconds();
+	return rec;
+}
+
+
+static void
+deliver(struct job *in_job)
+{
+	// simulated errors come without body and headers
+	struct record const *r = in_job->record;
+	bool const has_body = r && in_job->status == (int)r->status;
+	struct netw_header const *header =
+	  has_body ? (struct netw_header const *)r : NULL;
+
+	if (in_job->response)
+	{
+		in_job->response(
+		  in_job->udata,
+		  has_body ? r->body : NULL,
+		  has_body ? (size_t)r->nbody : 0,
+		  in_job->status,
+		  header);
+	}
+	else
+	{
+		if (has_body && r->nbody > 0)
+		{
+			fwrite(r->body, (size_t)r->nbody, 1, in_job->file);
+		}
+		in_job->download(in_job->udata, in_job->file, in_job->status, header);
+	}
+	mem_free(in_job);
+}
+
+
+// the time cnd_timedwait() waits until, *in_ns* from now
+static struct timespec
+deadline(uint64_t in_ns)
+{
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	uint64_t const ns = (uint64_t)ts.tv_nsec + in_ns % 1000000000;
+	ts.tv_sec += (time_t)(in_ns / 1000000000 + ns / 1000000000);
+	ts.tv_nsec = (long)(ns % 1000000000);
+	return ts;
+}
+
+
+static int
+run(void *UNUSED(in_userdata))
+{
+	// *running* is checked with *mtx* held until the wait starts, so that
+	// transport_stop() cannot signal in between
+	mtx_lock(&l_transport.mtx);
+	while (__atomic_load_n(&l_transport.running, __ATOMIC_ACQUIRE))
+	{
+		struct job *job = l_transport.jobs;
+		uint64_t const now = sys_nanoseconds();
+		if (job && job->due <= now)
+		{
+			l_transport.jobs = job->next;
+			// the callback may well request again
+			mtx_unlock(&l_transport.mtx);
+			deliver(job);
+			mtx_lock(&l_transport.mtx);
+		}
+		else if (job)
+		{
+			struct timespec const due = deadline(job->due - now);
+			cnd_timedwait(&l_transport.wake, &l_transport.mtx, &due);
+		}
+		else
+		{
+			cnd_wait(&l_transport.wake, &l_transport.mtx);
+		}
+	}
+	mtx_unlock(&l_transport.mtx);
+	return 0;
+}
+
+
+static void
+enqueue_replay(
+  enum record_kind in_kind,
+  enum netw_verb in_verb,
+  char const *in_uri,
+  struct job *in_job)
+{
+	uint64_t delay = 0;
+	char *uri = strip_api_key(in_uri);
+
+	mtx_lock(&l_transport.mtx);
+
+	struct record *match = NULL;
+	for (size_t i = 0; uri && i < l_transport.nrecords; ++i)
+	{
+		struct record *r = &l_transport.records[i];
+		if (r->kind == in_kind && r->verb == (uint32_t)in_verb &&
+		  0 == strcmp(r->uri, uri) &&
+		  (!match || r->nserved < match->nserved))
+		{
+			match = r;
+		}
+	}
+
+	if (match)
+	{
+		match->nserved += 1;
+		in_job->record = match;
+		in_job->status = (int)match->status;
+		if (l_transport.mode == MINIMOD_TRANSPORT_REPLAY_TIMED)
+		{
+			delay += match->elapsed;
+		}
+	}
+	else
+	{
+		LOGE("no recorded response for %s", uri ? uri : in_uri);
+		in_job->status = 404;
+	}
+
+	// same behaviour as netw's debugtesting
+	if (l_transport.error_rate > 0 && rand() % 100 < l_transport.error_rate)
+	{
+		in_job->status = 500;
+	}
+	if (l_transport.max_delay > 0)
+	{
+		int const range = l_transport.max_delay - l_transport.min_delay + 1;
+		int const ms = l_transport.min_delay + rand() % range;
+		delay += (uint64_t)ms * 1000000;
+	}
+	in_job->due = sys_nanoseconds() + delay;
+
+	struct job **it = &l_transport.jobs;
+	while (*it && (*it)->due <= in_job->due)
+	{
+		it = &(*it)->next;
+	}
+	in_job->next = *it;
+	*it = in_job;
+	cnd_signal(&l_transport.wake);
+
+	mtx_unlock(&l_transport.mtx);
+	mem_free(uri);
+}
+
+
+bool
+transport_configure(enum minimod_transport in_transport, char const *in_path)
+{
+	if (l_transport.out)
+	{
+		fclose(l_transport.out);
+		l_transport.out = NULL;
+	}
+	mem_free(l_transport.path);
+	l_transport.path = NULL;
+	free_records();
+	if (!l_transport.has_mtx)
+	{
+		mtx_init(&l_transport.mtx, mtx_plain);
+		cnd_init(&l_transport.wake);
+		l_transport.has_mtx = true;
+	}
+	l_transport.mode = MINIMOD_TRANSPORT_NETWORK;
+
+	switch (in_transport)
+	{
+	case MINIMOD_TRANSPORT_NETWORK:
+		break;
+	case MINIMOD_TRANSPORT_RECORD:
+		l_transport.out = fsu_fopen(in_path, "wb");
+		if (!l_transport.out)
+		{
+			LOGE("could not open %s", in_path);
+			return false;
+		}
+		fwrite(magic, sizeof magic, 1, l_transport.out);
+		l_transport.path = mem_strdup(in_path);
+		break;
+	case MINIMOD_TRANSPORT_REPLAY:
+	case MINIMOD_TRANSPORT_REPLAY_TIMED:
+		if (!read_records(in_path))
+		{
+			return false;
+		}
+		break;
+	}
+
+	l_transport.mode = in_transport;
+	return true;
+}
+
+
+void
+transport_start(void)
+{
+	if (l_transport.mode == MINIMOD_TRANSPORT_RECORD && !l_transport.out)
+	{
+		l_transport.out = fsu_fopen(l_transport.path, "ab");
+		if (!l_transport.out)
+		{
+			LOGE("could not open %s", l_transport.path);
+		}
+	}
+	if (!transport_is_replaying() || l_transport.running)
+	{
+		return;
+	}
+	__atomic_store_n(&l_transport.running, true, __ATOMIC_RELEASE);
+	if (thrd_create(&l_transport.thread, run, NULL) != thrd_success)
+	{
+		LOGE("could not start replay thread");
+		__atomic_store_n(&l_transport.running, false, __ATOMIC_RELEASE);
+	}
+}
+
+
+void
+transport_stop(void)
+{
+	if (l_transport.running)
+	{
+		__atomic_store_n(&l_transport.running, false, __ATOMIC_RELEASE);
+		mtx_lock(&l_transport.mtx);
+		cnd_signal(&l_transport.wake);
+		mtx_unlock(&l_transport.mtx);
+		thrd_join(l_transport.thread, NULL);
+	}
+
+	// nobody is supposed to wait forever
+	while (l_transport.jobs)
+	{
+		struct job *job = l_transport.jobs;
+		l_transport.jobs = job->next;
+		deliver(job);
+	}
+
+	if (l_transport.out)
+	{
+		mtx_lock(&l_transport.mtx);
+		fclose(l_transport.out);
+		l_transport.out = NULL;
+		mtx_unlock(&l_transport.mtx);
+	}
+}
+
+
+bool
+transport_is_replaying(void)
+{
+	return l_transport.mode == MINIMOD_TRANSPORT_REPLAY ||
+	  l_transport.mode == MINIMOD_TRANSPORT_REPLAY_TIMED;
+}
+
+
+size_t
+transport_enum_replays(
+  transport_response_callback in_callback,
+  void *in_udata)
+{
+	size_t n = 0;
+	for (size_t i = 0; transport_is_replaying() && i < l_transport.nrecords;
+	     ++i)
+	{
+		struct record const *r = &l_transport.records[i];
+		if (r->kind == RECORD_REQUEST)
+		{
+			in_callback(
+			  in_udata,
+			  r->body,
+			  (size_t)r->nbody,
+			  (int)r->status,
+			  (struct netw_header const *)r);
+			++n;
+		}
+	}
+	return n;
+}
+
+
+void
+transport_set_debugtesting(
+  int in_error_rate,
+  int in_min_delay,
+  int in_max_delay)
+{
+	l_transport.error_rate = in_error_rate;
+	l_transport.min_delay = in_min_delay;
+	l_transport.max_delay = in_max_delay;
+	netw_set_error_rate(in_error_rate);
+	netw_set_delay(in_min_delay, in_max_delay);
+}
+
+
+bool
+transport_request(
+  enum netw_verb in_verb,
+  char const *in_uri,
+  char const *const in_headers[],
+  void const *in_body,
+  size_t in_nbody,
+  transport_response_callback in_callback,
+  void *in_udata)
+{
+	switch (l_transport.mode)
+	{
+	case MINIMOD_TRANSPORT_NETWORK:
+		break;
+	case MINIMOD_TRANSPORT_RECORD:
+	{
+		struct recording *rec = alloc_recording(in_verb, in_uri);
+		if (!rec)
+		{
+			return false;
+		}
+		rec->response = in_callback;
+		rec->udata = in_udata;
+		bool const ok = netw_request(
+		  in_verb,
+		  in_uri,
+		  in_headers,
+		  in_body,
+		  in_nbody,
+		  on_recorded_response,
+		  rec);
+		if (!ok)
+		{
+			mem_free(rec->uri);
+			mem_free(rec);
+		}
+		return ok;
+	}
+	case MINIMOD_TRANSPORT_REPLAY:
+	case MINIMOD_TRANSPORT_REPLAY_TIMED:
+	{
+		struct job *job = mem_calloc(1, sizeof *job);
+		if (!job)
+		{
+			return false;
+		}
+		job->response = in_callback;
+		job->udata = in_udata;
+		enqueue_replay(RECORD_REQUEST, in_verb, in_uri, job);
+		return true;
+	}
+	}
+
+	return netw_request(
+	  in_verb,
+	  in_uri,
+	  in_headers,
+	  in_body,
+	  in_nbody,
+	  in_callback,
+	  in_udata);
+}
+
+
+bool
+transport_download_to(
+  enum netw_verb in_verb,
+  char const *in_uri,
+  char const *const in_headers[],
+  void const *in_body,
+  size_t in_nbody,
+  FILE *in_file,
+  transport_download_callback in_callback,
+  void *in_udata)
+{
+	switch (l_transport.mode)
+	{
+	case MINIMOD_TRANSPORT_NETWORK:
+		break;
+	case MINIMOD_TRANSPORT_RECORD:
+	{
+		struct recording *rec = alloc_recording(in_verb, in_uri);
+		if (!rec)
+		{
+			return false;
+		}
+		rec->download = in_callback;
+		rec->udata = in_udata;
+		bool const ok = netw_download_to(
+		  in_verb,
+		  in_uri,
+		  in_headers,
+		  in_body,
+		  in_nbody,
+		  in_file,
+		  on_recorded_download,
+		  rec);
+		if (!ok)
+		{
+			mem_free(rec->uri);
+			mem_free(rec);
+		}
+		return ok;
+	}
+	case MINIMOD_TRANSPORT_REPLAY:
+	case MINIMOD_TRANSPORT_REPLAY_TIMED:
+	{
+		struct job *job = mem_calloc(1, sizeof *job);
+		if (!job)
+		{
+			return false;
+		}
+		job->download = in_callback;
+		job->udata = in_udata;
+		job->file = in_file;
+		enqueue_replay(RECORD_DOWNLOAD, in_verb, in_uri, job);
+		return true;
+	}
+	}
+
+	return netw_download_to(
+	  in_verb,
+	  in_uri,
+	  in_headers,
+	  in_body,
+	  in_nbody,
+	  in_file,
+	  in_callback,
+	  in_udata);
+}
+
+
+char const *
+transport_get_header(struct netw_header const *in_header, char const *in_name)
+{
+	if (!in_header)
+	{
+		return NULL;
+	}
+	if (!transport_is_replaying())
+	{
+		return netw_get_header(in_header, in_name);
+	}
+
+	// replayed responses pass their record as header
+	struct record const *r = (struct record const *)in_header;
+	for (size_t h = 0; h < r->nheaders; ++h)
+	{
+		if (0 == strcmp(r->headers[2 * h], in_name))
+		{
+			return r->headers[2 * h + 1];
+		}
+	}
+	return NULL;
+}
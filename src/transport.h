@@ -0,0 +1,147 @@
+// vi: filetype=c
+#pragma once
+#ifndef MINIMOD_TRANSPORT_H_INCLUDED
+#define MINIMOD_TRANSPORT_H_INCLUDED
+
+/* Title: transport
+ *
+ * Topic: Introduction
+ *
+ * Sits between minimod and netw, so that requests and their responses
+ * can be recorded into a file and served from such a file later on,
+ * without any network access.
+ *
+ * In replay mode the header-pointers passed to the callbacks do not
+ * point to netw's headers, thusly headers have to be read through
+ * <transport_get_header()>.
+ */
+
+#include "minimod/minimod.h"
+#include "netw/netw.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Section: API */
+
+/* Callback: transport_response_callback()
+ *
+ * Same signature as netw's request callback.
+ */
+typedef void (*transport_response_callback)(
+  void *udata,
+  void const *data,
+  size_t len,
+  int error,
+  struct netw_header const *header);
+
+/* Callback: transport_download_callback()
+ *
+ * Same signature as netw's download callback.
+ */
+typedef void (*transport_download_callback)(
+  void *udata,
+  FILE *file,
+  int error,
+  struct netw_header const *header);
+
+/* Function: transport_configure()
+ *
+ * Implementation of <minimod_set_transport()>.
+ */
+bool
+transport_configure(enum minimod_transport in_transport, char const *in_path);
+
+/* Function: transport_start()
+ *
+ * Start the thread serving replayed responses, if replaying. If recording,
+ * reopen the file closed by <transport_stop()> to append to it.
+ */
+void
+transport_start(void);
+
+/* Function: transport_stop()
+ *
+ * Deliver all pending replayed responses and stop the thread started by
+ * <transport_start()>. If recording, close the file. Responses arriving
+ * afterwards are not recorded.
+ */
+void
+transport_stop(void);
+
+/* Function: transport_is_replaying()
+ */
+bool
+transport_is_replaying(void);
+
+/* Function: transport_enum_replays()
+ *
+ * Pass each recorded response of the file being replayed to
+ * *in_callback*, in the order they were recorded and without delay, e.g.
+ * to check how they are parsed. Downloads are left out.
+ *
+ * Returns:
+ *	The number of responses passed.
+ */
+size_t
+transport_enum_replays(
+  transport_response_callback in_callback,
+  void *in_udata);
+
+/* Function: transport_set_debugtesting()
+ *
+ * See <minimod_set_debugtesting()>. Applies to netw as well as replay.
+ */
+void
+transport_set_debugtesting(
+  int in_error_rate,
+  int in_min_delay,
+  int in_max_delay);
+
+/* Function: transport_request()
+ *
+ * Like netw_request(). The request body is neither recorded nor used to
+ * look up the response when replaying, only *in_verb* and *in_uri*.
+ */
+bool
+transport_request(
+  enum netw_verb in_verb,
+  char const *in_uri,
+  char const *const in_headers[],
+  void const *in_body,
+  size_t in_nbody,
+  transport_response_callback in_callback,
+  void *in_udata);
+
+/* Function: transport_download_to()
+ *
+ * Like netw_download_to().
+ */
+bool
+transport_download_to(
+  enum netw_verb in_verb,
+  char const *in_uri,
+  char const *const in_headers[],
+  void const *in_body,
+  size_t in_nbody,
+  FILE *in_file,
+  transport_download_callback in_callback,
+  void *in_udata);
+
+/* Function: transport_get_header()
+ *
+ * Like netw_get_header(), but also works for replayed responses.
+ * Only a few headers are recorded, see *recorded_headers* in transport.c
+ *
+ * Returns:
+ *	NULL if *in_header* is NULL or the header is not present.
+ */
+char const *
+transport_get_header(struct netw_header const *in_header, char const *in_name);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
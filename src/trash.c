@@ -0,0 +1,219 @@
+#include "trash.h"
+
+#include "log.h"
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define UNUSED(X) __pragma(warning(suppress : 4100)) X
+#else
+#define UNUSED(X) __attribute__((unused)) X
+#endif
+
+#pragma GCC diagnostic push
+#ifdef __clang__
+#pragma GCC diagnostic ignored "-Wgnu-zero-variadic-macro-arguments"
+#endif
+#pragma GCC diagnostic ignored "-Wunused-macros"
+
+#define LOG(FMT, ...) LOG_DEBUG("trash", FMT, ##__VA_ARGS__)
+#define LOGE(FMT, ...) LOG_ERROR("trash", FMT, ##__VA_ARGS__)
+
+#pragma GCC diagnostic pop
+
+// CONFIG
+// ------
+// names tried when moving an entry to the trash, in case an entry left
+// from before has the same name
+#define TRASH_MAX_ATTEMPTS 8
+
+
+struct trash
+{
+	thrd_t thread;
+	// guards pending, and running and l_trash_dir against trash_stop(). it
+	// is held while an entry is moved, so that the directory is not closed
+	// then.
+	mtx_t mtx;
+	// signalled when entries were moved, or the thread shall stop
+	cnd_t wake;
+	// names the entries, unique within the lifetime of the process
+	uint64_t next_name;
+	// entries were moved to the trash since it was last emptied
+	bool pending;
+	bool running;
+	bool has_mtx;
+	char _padding[5];
+};
+static struct trash l_trash;
+// apart from l_trash, since its size differs between platforms
+static fsu_dir l_trash_dir = FSU_NODIR;
+
+
+static void
+delete_entry(fsu_dir in_dir, char const *in_name, bool in_is_dir);
+
+
+static void
+on_entry(
+  char const *UNUSED(root),
+  char const *name,
+  bool is_dir,
+  void *userdata)
+{
+	// skips the rest of the directory once stopped
+	if (__atomic_load_n(&l_trash.running, __ATOMIC_ACQUIRE))
+	{
+		delete_entry(*(fsu_dir *)userdata, name, is_dir);
+	}
+}
+
+
+// deletes a directory by its entries, instead of with
+// fsu_rmdirat_recursive(), so that it can stop within large directories
+static void
+delete_entry(fsu_dir in_dir, char const *in_name, bool in_is_dir)
+{
+	// without d_type an entry might be a directory nonetheless
+	if (!in_is_dir && fsu_rmfileat(in_dir, in_name))
+	{
+		return;
+	}
+	fsu_dir dir = fsu_opendirat(in_dir, in_name, false);
+	if (dir == FSU_NODIR)
+	{
+		return;
+	}
+	fsu_enum_dirat(dir, on_entry, &dir);
+	fsu_closedir(dir);
+	// deletes the dot-files, which are not enumerated
+	if (__atomic_load_n(&l_trash.running, __ATOMIC_ACQUIRE))
+	{
+		fsu_rmdirat_recursive(in_dir, in_name);
+	}
+}
+
+
+static int
+run(void *UNUSED(in_userdata))
+{
+	sys_thread_background();
+	// *pending* and *running* are checked with *mtx* held until the wait
+	// starts, so that no signal falls in between
+	mtx_lock(&l_trash.mtx);
+	while (__atomic_load_n(&l_trash.running, __ATOMIC_ACQUIRE))
+	{
+		if (l_trash.pending)
+		{
+			l_trash.pending = false;
+			// entries are moved in meanwhile
+			mtx_unlock(&l_trash.mtx);
+			fsu_enum_dirat(l_trash_dir, on_entry, &l_trash_dir);
+			mtx_lock(&l_trash.mtx);
+			continue;
+		}
+		cnd_wait(&l_trash.wake, &l_trash.mtx);
+	}
+	mtx_unlock(&l_trash.mtx);
+	return 0;
+}
+
+
+bool
+trash_start(char const *in_path)
+{
+	if (l_trash.running)
+	{
+		return false;
+	}
+	if (!l_trash.has_mtx)
+	{
+		mtx_init(&l_trash.mtx, mtx_plain);
+		cnd_init(&l_trash.wake);
+		l_trash.has_mtx = true;
+	}
+	l_trash_dir = fsu_opendir(in_path, true);
+	if (l_trash_dir == FSU_NODIR)
+	{
+		LOGE("could not open %s", in_path);
+		return false;
+	}
+	l_trash.next_name = sys_nanoseconds();
+	// whatever is left from before
+	l_trash.pending = true;
+
+	__atomic_store_n(&l_trash.running, true, __ATOMIC_RELEASE);
+	if (thrd_create(&l_trash.thread, run, NULL) != thrd_success)
+	{
+		LOGE("could not start emptying %s", in_path);
+		__atomic_store_n(&l_trash.running, false, __ATOMIC_RELEASE);
+		trash_stop();
+		return false;
+	}
+	return true;
+}
+
+
+void
+trash_stop(void)
+{
+	if (!l_trash.has_mtx)
+	{
+		return;
+	}
+	// waits for an entry being moved
+	mtx_lock(&l_trash.mtx);
+	bool const was_running =
+	  __atomic_exchange_n(&l_trash.running, false, __ATOMIC_ACQ_REL);
+	cnd_signal(&l_trash.wake);
+	mtx_unlock(&l_trash.mtx);
+	if (was_running)
+	{
+		thrd_join(l_trash.thread, NULL);
+	}
+	fsu_closedir(l_trash_dir);
+	l_trash_dir = FSU_NODIR;
+	l_trash.pending = false;
+}
+
+
+bool
+trash_moveat(fsu_dir in_dir, char const *in_name)
+{
+	if (!l_trash.has_mtx)
+	{
+		return false;
+	}
+	mtx_lock(&l_trash.mtx);
+	if (!__atomic_load_n(&l_trash.running, __ATOMIC_ACQUIRE))
+	{
+		mtx_unlock(&l_trash.mtx);
+		return false;
+	}
+	for (int i = 0; i < TRASH_MAX_ATTEMPTS; ++i)
+	{
+		char name[32];
+		snprintf(
+		  name,
+		  sizeof name,
+		  "%016" PRIx64,
+		  __atomic_fetch_add(&l_trash.next_name, 1, __ATOMIC_RELAXED));
+		if (fsu_renameat(in_dir, in_name, l_trash_dir, name))
+		{
+			l_trash.pending = true;
+			cnd_signal(&l_trash.wake);
+			mtx_unlock(&l_trash.mtx);
+			return true;
+		}
+		// unless the name is taken, it fails with any other name as well
+		if (fsu_ptypeat(l_trash_dir, name) == FSU_PATHTYPE_NONE)
+		{
+			break;
+		}
+	}
+	mtx_unlock(&l_trash.mtx);
+	LOG("could not move %s to the trash", in_name);
+	return false;
+}
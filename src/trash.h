@@ -0,0 +1,64 @@
+// vi: filetype=c
+#pragma once
+#ifndef MINIMOD_TRASH_H_INCLUDED
+#define MINIMOD_TRASH_H_INCLUDED
+
+/* Title: trash
+ *
+ * Topic: Introduction
+ *
+ * Files and directories are moved to a trash directory, which takes a
+ * single rename, and deleted from there by a thread of its own with low
+ * priority. Whatever is left when the thread stops is deleted once it is
+ * started again.
+ */
+
+#include "util.h"
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Section: API */
+
+/* Function: trash_start()
+ *
+ * Start deleting the contents of *in_path*, which is created if missing,
+ * including what is left from before.
+ *
+ * Returns:
+ *	false if already started, or if the directory or the thread could not
+ *	be created.
+ */
+bool
+trash_start(char const *in_path);
+
+/* Function: trash_stop()
+ *
+ * Stop deleting, leaving the rest for the next <trash_start()>. No entry
+ * is moved to the trash anymore once this returns.
+ */
+void
+trash_stop(void);
+
+/* Function: trash_moveat()
+ *
+ * Move the file or directory *in_name* in *in_dir* to the trash. May be
+ * called from any thread between <trash_start()> and <trash_stop()>.
+ *
+ * Returns:
+ *	false if not started, or if *in_dir* is not on the same file system
+ *	as the trash. *in_name* is still there then.
+ */
+bool
+trash_moveat(fsu_dir in_dir, char const *in_name);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -1,11 +1,23 @@
+#include "log.h"
 #include "util.h"
 
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 #pragma GCC diagnostic push
 #ifdef __clang__
@@ -13,19 +25,19 @@
 #endif
 #pragma GCC diagnostic ignored "-Wunused-macros"
 
-#ifdef MINIMOD_LOG_ENABLE
-#define LOG(FMT, ...) printf("[util] " FMT "\n", ##__VA_ARGS__)
-#else
-#define LOG(...)
-#endif
-#define LOGE(FMT, ...) fprintf(stderr, "[util] " FMT "\n", ##__VA_ARGS__)
+#define UNUSED(X) __attribute__((unused)) X
+
+#define LOG(FMT, ...) LOG_DEBUG("util", FMT, ##__VA_ARGS__)
+#define LOGE(FMT, ...) LOG_ERROR("util", FMT, ##__VA_ARGS__)
+// bypasses the queue, since the process stops right after
+#define LOGA(FMT, ...) fprintf(stderr, "[util] " FMT "\n", ##__VA_ARGS__)
 
 #define ASSERT(in_condition)                      \
 	do                                            \
 	{                                             \
 		if (__builtin_expect(!(in_condition), 0)) \
 		{                                         \
-			LOGE(                                 \
+			LOGA(                                 \
 			  "[assertion] %s:%i: '%s'",          \
 			  __FILE__,                           \
 			  __LINE__,                           \
@@ -37,27 +49,16 @@
 
 #pragma GCC diagnostic pop
 
+// CONFIG
+// ------
+// bytes copied at a time if the kernel cannot copy files on its own
+#define COPY_BUFFER_SIZE (64 * 1024)
+
+
 enum fsu_pathtype
 fsu_ptype(char const *in_path)
 {
-	struct stat sbuffer;
-	int const result = stat(in_path, &sbuffer);
-	if (result != 0)
-	{
-		return FSU_PATHTYPE_NONE;
-	}
-	else if (S_ISDIR(sbuffer.st_mode))
-	{
-		return FSU_PATHTYPE_DIR;
-	}
-	else if (S_ISREG(sbuffer.st_mode))
-	{
-		return FSU_PATHTYPE_FILE;
-	}
-	else
-	{
-		return FSU_PATHTYPE_OTHER;
-	}
+	return fsu_ptypeat(AT_FDCWD, in_path);
 }
 
 
@@ -73,45 +74,71 @@ fsu_fsize(char const *in_path)
 FILE *
 fsu_fopen(char const *in_path, char const *in_mode)
 {
-	// create directory if in_mode contains 'w'
-	if (strchr(in_mode, 'w'))
-	{
-		fsu_mkdir(in_path);
-	}
-	return fopen(in_path, in_mode);
+	return fsu_fopenat(AT_FDCWD, in_path, in_mode);
 }
 
 
-bool
-fsu_mkdir(char const *in_dir)
+// creates the directories of *io_path* up to its last '/', relative to
+// *in_dir*. *io_path* is changed on the way, but restored.
+static bool
+mkdir_parents(int in_dir, char *io_path)
 {
-	// check if directory already exists
-	struct stat sbuffer;
-	if (stat(in_dir, &sbuffer) == 0)
+	char *last = strrchr(io_path, '/');
+	if (!last || last == io_path)
 	{
 		return true;
 	}
 
-	char *dir = strdup(in_dir);
-	char *ptr = dir;
-	while (*(++ptr))
+	// usually the parent exists already
+	struct stat st;
+	*last = '\0';
+	bool const exists = 0 == fstatat(in_dir, io_path, &st, 0);
+	*last = '/';
+	if (exists)
+	{
+		return true;
+	}
+
+	for (char *ptr = io_path + 1; ptr <= last; ++ptr)
 	{
 		if (*ptr == '/')
 		{
 			*ptr = '\0';
-			if (mkdir(dir, 0777 /* octal mode */) == -1 && errno != EEXIST)
+			int const result = mkdirat(in_dir, io_path, 0777 /* octal mode */);
+			*ptr = '/';
+			if (result == -1 && errno != EEXIST)
 			{
-				free(dir);
 				return false;
 			}
-			*ptr = '/';
 		}
 	}
-	free(dir);
 	return true;
 }
 
 
+// mkdir_parents() on a copy of *in_path*, which can be at most PATH_MAX
+// bytes, as any path the system accepts
+static bool
+mkdir_parents_of(int in_dir, char const *in_path, char const *in_suffix)
+{
+	char path[PATH_MAX];
+	int const len = snprintf(path, sizeof path, "%s%s", in_path, in_suffix);
+	if (len < 0 || (size_t)len >= sizeof path)
+	{
+		errno = ENAMETOOLONG;
+		return false;
+	}
+	return mkdir_parents(in_dir, path);
+}
+
+
+bool
+fsu_mkdir(char const *in_dir)
+{
+	return mkdir_parents_of(AT_FDCWD, in_dir, "");
+}
+
+
 bool
 fsu_rmdir(char const *in_path)
 {
@@ -123,73 +150,103 @@ bool
 fsu_rmdir_recursive(char const *in_path)
 {
 	LOG("fsu_rmdir_recursive(%s)", in_path);
-	DIR *dir = opendir(in_path);
-	struct dirent *entry;
-	while ((entry = readdir(dir)))
+	return fsu_rmdirat_recursive(AT_FDCWD, in_path);
+}
+
+
+// copies the rest of *in_src* to *in_dst*, within the kernel where
+// possible
+static bool
+copy_data(int in_src, int in_dst)
+{
+#ifdef __linux__
+	for (;;)
 	{
-		if (entry->d_name[0] == '.')
+		ssize_t const nbytes =
+		  copy_file_range(in_src, NULL, in_dst, NULL, SSIZE_MAX, 0);
+		if (nbytes == 0)
 		{
-			/* do nothing - skip it */
+			return true;
 		}
-		else if (entry->d_type == DT_DIR)
+		if (nbytes == -1 && errno != EINTR)
 		{
-			char *subdir;
-			asprintf(&subdir, "%s/%s", in_path, entry->d_name);
-			fsu_rmdir_recursive(subdir);
-			free(subdir);
+			// older kernels do not copy across file systems, the file
+			// offsets tell where to continue
+			if (errno != EXDEV && errno != ENOSYS && errno != EINVAL &&
+			  errno != EOPNOTSUPP)
+			{
+				return false;
+			}
+			break;
 		}
-		else
+	}
+#endif
+
+	char buffer[COPY_BUFFER_SIZE];
+	for (;;)
+	{
+		ssize_t const nread = read(in_src, buffer, sizeof buffer);
+		if (nread == 0)
 		{
-			char *file;
-			asprintf(&file, "%s/%s", in_path, entry->d_name);
-			LOG("deleting file %s", file);
-			unlink(file);
-			free(file);
+			return true;
+		}
+		if (nread == -1)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return false;
+		}
+		for (ssize_t nwritten = 0; nwritten < nread;)
+		{
+			ssize_t const n =
+			  write(in_dst, buffer + nwritten, (size_t)(nread - nwritten));
+			if (n == -1 && errno != EINTR)
+			{
+				return false;
+			}
+			nwritten += n > 0 ? n : 0;
 		}
 	}
-	closedir(dir);
-
-	return 0 == rmdir(in_path);
 }
 
 
 static bool
 fsu_cpfile(char const *in_srcpath, char const *in_dstpath, bool in_replace)
 {
-	// fail if something does exist at the destination but in_replace is false
-	struct stat st = { 0 };
-	if (!in_replace && stat(in_dstpath, &st) == 0)
-	{
-		return false;
-	}
-
 	// if the file cannot be opened, all bets are off.
-	FILE *src = fopen(in_srcpath, "rb");
-	if (!src)
+	int const src = open(in_srcpath, O_RDONLY | O_CLOEXEC);
+	struct stat st;
+	if (src == -1 || 0 != fstat(src, &st))
 	{
+		if (src != -1)
+		{
+			close(src);
+		}
 		return false;
 	}
 
 	// make sure the destination directory exists.
 	fsu_mkdir(in_dstpath);
-	// either the file does not exist, or in_replace is true so make sure
-	// the old file does not exist anymore.
-	unlink(in_dstpath);
-
-	FILE *dst = fopen(in_dstpath, "wb");
-	if (dst)
+	// fail if something does exist at the destination but in_replace is
+	// false, otherwise the old file is truncated.
+	int const dst = open(
+	  in_dstpath,
+	  O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | (in_replace ? 0 : O_EXCL),
+	  st.st_mode & 0777);
+	bool is_copied = dst != -1 && copy_data(src, dst);
+	if (dst != -1)
 	{
-		char buffer[4096];
-		size_t nbytes = 0;
-		while ((nbytes = fread(buffer, 1, sizeof buffer, src)) > 0)
+		is_copied = 0 == close(dst) && is_copied;
+		if (!is_copied)
 		{
-			fwrite(buffer, 1, nbytes, dst);
+			unlink(in_dstpath);
 		}
-		fclose(dst);
 	}
-	fclose(src);
+	close(src);
 
-	return (dst);
+	return is_copied;
 }
 
 
@@ -214,7 +271,7 @@ fsu_mvfile(char const *in_srcpath, char const *in_dstpath, bool in_replace)
 	else if (rv == -1 && errno == EXDEV)
 	{
 		// if rename() failed because src and dst were on different
-		// file systems use mlfs_cpfile() and mlfs_rmfile()
+		// file systems use fsu_cpfile() and fsu_rmfile()
 		if (fsu_cpfile(in_srcpath, in_dstpath, in_replace))
 		{
 			fsu_rmfile(in_srcpath);
@@ -229,7 +286,48 @@ fsu_mvfile(char const *in_srcpath, char const *in_dstpath, bool in_replace)
 bool
 fsu_rmfile(char const *in_path)
 {
-	return (unlink(in_path) == 0);
+	return fsu_rmfileat(AT_FDCWD, in_path);
+}
+
+
+void const *
+fsu_mmap(char const *in_path, size_t *out_size)
+{
+	int fd = open(in_path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+	{
+		return NULL;
+	}
+
+	void *data = NULL;
+	struct stat st;
+	if (0 == fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0)
+	{
+		data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED)
+		{
+			LOGE("mmap of %s failed: %i", in_path, errno);
+			data = NULL;
+		}
+		else
+		{
+			*out_size = (size_t)st.st_size;
+		}
+	}
+
+	// the mapping keeps the file alive on its own
+	close(fd);
+	return data;
+}
+
+
+void
+fsu_munmap(void const *in_data, size_t in_size)
+{
+	if (in_data)
+	{
+		munmap((void *)(uintptr_t)in_data, in_size);
+	}
 }
 
 
@@ -268,6 +366,261 @@ fsu_enum_dir(
 }
 
 
+// open() flags of an fopen() mode
+static int
+open_flags(char const *in_mode)
+{
+	int const access = strchr(in_mode, '+') ? O_RDWR : 0;
+	switch (in_mode[0])
+	{
+	case 'w':
+		return (access ? access : O_WRONLY) | O_CREAT | O_TRUNC;
+	case 'a':
+		return (access ? access : O_WRONLY) | O_CREAT | O_APPEND;
+	default:
+		return access ? access : O_RDONLY;
+	}
+}
+
+
+fsu_dir
+fsu_opendir(char const *in_path, bool in_create)
+{
+	return fsu_opendirat(AT_FDCWD, in_path, in_create);
+}
+
+
+fsu_dir
+fsu_opendirat(fsu_dir in_dir, char const *in_name, bool in_create)
+{
+	int const flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+	int fd = openat(in_dir, in_name, flags);
+	// the directory is created as the parent of "<in_name>/"
+	if (fd == -1 && errno == ENOENT && in_create &&
+	  mkdir_parents_of(in_dir, in_name, "/"))
+	{
+		fd = openat(in_dir, in_name, flags);
+	}
+	return fd == -1 ? FSU_NODIR : fd;
+}
+
+
+void
+fsu_closedir(fsu_dir in_dir)
+{
+	if (in_dir != FSU_NODIR)
+	{
+		close(in_dir);
+	}
+}
+
+
+enum fsu_pathtype
+fsu_ptypeat(fsu_dir in_dir, char const *in_name)
+{
+	struct stat sbuffer;
+	int const result = fstatat(in_dir, in_name, &sbuffer, 0);
+	if (result != 0)
+	{
+		return FSU_PATHTYPE_NONE;
+	}
+	else if (S_ISDIR(sbuffer.st_mode))
+	{
+		return FSU_PATHTYPE_DIR;
+	}
+	else if (S_ISREG(sbuffer.st_mode))
+	{
+		return FSU_PATHTYPE_FILE;
+	}
+	else
+	{
+		return FSU_PATHTYPE_OTHER;
+	}
+}
+
+
+uint64_t
+fsu_mtimeat(fsu_dir in_dir, char const *in_name)
+{
+	struct stat st;
+	if (0 != fstatat(in_dir, in_name, &st, 0))
+	{
+		return 0;
+	}
+#ifdef __APPLE__
+	struct timespec const mtime = st.st_mtimespec;
+#else
+	struct timespec const mtime = st.st_mtim;
+#endif
+	return (uint64_t)mtime.tv_sec * 1000000000 + (uint64_t)mtime.tv_nsec;
+}
+
+
+FILE *
+fsu_fopenat(fsu_dir in_dir, char const *in_name, char const *in_mode)
+{
+	int const flags = open_flags(in_mode) | O_CLOEXEC;
+	int fd = openat(in_dir, in_name, flags, 0666);
+	// create missing directories, if the mode creates files
+	if (fd == -1 && errno == ENOENT && (flags & O_CREAT) &&
+	  mkdir_parents_of(in_dir, in_name, ""))
+	{
+		fd = openat(in_dir, in_name, flags, 0666);
+	}
+	if (fd == -1)
+	{
+		return NULL;
+	}
+	FILE *f = fdopen(fd, in_mode);
+	if (!f)
+	{
+		close(fd);
+	}
+	return f;
+}
+
+
+bool
+fsu_rmfileat(fsu_dir in_dir, char const *in_name)
+{
+	return 0 == unlinkat(in_dir, in_name, 0);
+}
+
+
+bool
+fsu_rmdirat_recursive(fsu_dir in_dir, char const *in_name)
+{
+	int const fd =
+	  openat(in_dir, in_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	DIR *dir = fd == -1 ? NULL : fdopendir(fd);
+	if (!dir)
+	{
+		if (fd != -1)
+		{
+			close(fd);
+		}
+		return false;
+	}
+
+	struct dirent *entry;
+	while ((entry = readdir(dir)))
+	{
+		char const *name = entry->d_name;
+		if (name[0] == '.' &&
+		  (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+		{
+			/* do nothing - skip it */
+		}
+		else if (entry->d_type == DT_DIR)
+		{
+			fsu_rmdirat_recursive(fd, name);
+		}
+		// without d_type the entry might still be a directory
+		else if (0 != unlinkat(fd, name, 0) && entry->d_type == DT_UNKNOWN)
+		{
+			fsu_rmdirat_recursive(fd, name);
+		}
+	}
+	// closes fd as well
+	closedir(dir);
+
+	return 0 == unlinkat(in_dir, in_name, AT_REMOVEDIR);
+}
+
+
+bool
+fsu_renameat(
+  fsu_dir in_srcdir,
+  char const *in_srcname,
+  fsu_dir in_dstdir,
+  char const *in_dstname)
+{
+	return 0 == renameat(in_srcdir, in_srcname, in_dstdir, in_dstname);
+}
+
+
+bool
+fsu_renameat_existed(void)
+{
+	// a directory which is not empty is never replaced
+	return errno == EEXIST || errno == ENOTEMPTY;
+}
+
+
+#if defined(__linux__) && defined(SYS_renameat2)
+bool
+fsu_exchangeat(
+  fsu_dir in_dir1,
+  char const *in_name1,
+  fsu_dir in_dir2,
+  char const *in_name2)
+{
+	// linux 3.15, not every file system supports it
+	unsigned int const rename_exchange = 1 << 1;
+	return 0 ==
+	  syscall(
+	    SYS_renameat2,
+	    in_dir1,
+	    in_name1,
+	    in_dir2,
+	    in_name2,
+	    rename_exchange);
+}
+#else
+bool
+fsu_exchangeat(
+  fsu_dir UNUSED(in_dir1),
+  char const *UNUSED(in_name1),
+  fsu_dir UNUSED(in_dir2),
+  char const *UNUSED(in_name2))
+{
+	return false;
+}
+#endif
+
+
+bool
+fsu_enum_dirat(
+  fsu_dir in_dir,
+  fsu_enum_dir_callback in_callback,
+  void *in_userdata)
+{
+	// a descriptor of its own, which closedir() closes, reading from the
+	// start of the directory
+	int const fd = openat(in_dir, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	DIR *dir = fd == -1 ? NULL : fdopendir(fd);
+	if (!dir)
+	{
+		if (fd != -1)
+		{
+			close(fd);
+		}
+		return false;
+	}
+
+	struct dirent *entry;
+	while ((entry = readdir(dir)))
+	{
+		if (entry->d_name[0] == '.')
+		{
+			/* do nothing - skip it */
+		}
+		else
+		{
+			in_callback(
+			  NULL,
+			  entry->d_name,
+			  entry->d_type == DT_DIR,
+			  in_userdata);
+		}
+	}
+
+	closedir(dir);
+
+	return true;
+}
+
+
 void
 sys_sleep(uint32_t ms)
 {
@@ -282,6 +635,42 @@ sys_seconds(void)
 }
 
 
+uint64_t
+sys_nanoseconds(void)
+{
+#ifdef __APPLE__
+	// clock_gettime() is not available before macOS 10.12
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0)
+	{
+		mach_timebase_info(&timebase);
+	}
+	return mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+
+void
+sys_thread_background(void)
+{
+#ifdef __linux__
+	// the nice value is per thread on linux, as is the IO priority of
+	// who 0, whose idle class only gets the disk when no one else needs it
+	pid_t const tid = (pid_t)syscall(SYS_gettid);
+	setpriority(PRIO_PROCESS, (id_t)tid, 19);
+	int const ioprio_who_process = 1;
+	int const ioprio_class_idle = 3 << 13;
+	syscall(SYS_ioprio_set, ioprio_who_process, 0, ioprio_class_idle);
+#elif defined(__APPLE__)
+	setiopolicy_np(IOPOL_TYPE_DISK, IOPOL_SCOPE_THREAD, IOPOL_THROTTLE);
+#endif
+}
+
+
 #ifndef UTIL_HAS_THREADS_H
 int
 mtx_init(mtx_t *mutex, int type)
@@ -321,4 +710,119 @@ mtx_unlock(mtx_t *mutex)
 #pragma GCC diagnostic pop
 #endif
 
+
+int
+cnd_init(cnd_t *cond)
+{
+	return pthread_cond_init(cond, NULL) == 0 ? thrd_success : thrd_error;
+}
+
+
+int
+cnd_signal(cnd_t *cond)
+{
+	return pthread_cond_signal(cond) == 0 ? thrd_success : thrd_error;
+}
+
+
+int
+cnd_wait(cnd_t *cond, mtx_t *mutex)
+{
+	return pthread_cond_wait(cond, mutex) == 0 ? thrd_success : thrd_error;
+}
+
+
+int
+cnd_timedwait(
+  cnd_t *cond,
+  mtx_t *mutex,
+  struct timespec const *time_point)
+{
+	int const result = pthread_cond_timedwait(cond, mutex, time_point);
+	if (result == ETIMEDOUT)
+	{
+		return thrd_timedout;
+	}
+	return result == 0 ? thrd_success : thrd_error;
+}
+
+
+void
+cnd_destroy(cnd_t *cond)
+{
+	pthread_cond_destroy(cond);
+}
+
+
+int
+tss_create(tss_t *key, tss_dtor_t dtor)
+{
+	return pthread_key_create(key, dtor) == 0 ? thrd_success : thrd_error;
+}
+
+
+void *
+tss_get(tss_t key)
+{
+	return pthread_getspecific(key);
+}
+
+
+int
+tss_set(tss_t key, void *value)
+{
+	return pthread_setspecific(key, value) == 0 ? thrd_success : thrd_error;
+}
+
+
+struct thrd_start
+{
+	thrd_start_t func;
+	void *arg;
+};
+
+
+static void *
+thrd_trampoline(void *in_start)
+{
+	struct thrd_start start = *(struct thrd_start *)in_start;
+	mem_free(in_start);
+	return (void *)(intptr_t)start.func(start.arg);
+}
+
+
+int
+thrd_create(thrd_t *thr, thrd_start_t func, void *arg)
+{
+	struct thrd_start *start = mem_alloc(sizeof *start);
+	if (!start)
+	{
+		return thrd_error;
+	}
+	start->func = func;
+	start->arg = arg;
+	if (pthread_create(thr, NULL, thrd_trampoline, start) != 0)
+	{
+		mem_free(start);
+		return thrd_error;
+	}
+	return thrd_success;
+}
+
+
+int
+thrd_join(thrd_t thr, int *res)
+{
+	void *value;
+	if (pthread_join(thr, &value) != 0)
+	{
+		return thrd_error;
+	}
+	if (res)
+	{
+		*res = (int)(intptr_t)value;
+	}
+	return thrd_success;
+}
+
 #endif
@@ -1,3 +1,4 @@
+#include "log.h"
 #include "util.h"
 
 #include <Windows.h>
@@ -5,25 +6,26 @@
 #include <string.h>
 #include <time.h>
 
+#if defined(_MSC_VER) && !defined(__clang__)
+#define UNUSED(X) __pragma(warning(suppress : 4100)) X
+#else
+#define UNUSED(X) __attribute__((unused)) X
+#endif
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wgnu-zero-variadic-macro-arguments"
 
-#ifdef MINIMOD_LOG_ENABLE
-#define LOG(FMT, ...) printf("[util] " FMT "\n", ##__VA_ARGS__)
-#define WLOG(FMT, ...) wprintf("[util] " FMT "\n", ##__VA_ARGS__)
-#else
-#define LOG(...)
-#define WLOG(...)
-#endif
-#define LOGE(FMT, ...) fprintf(stderr, "[util] " FMT "\n", ##__VA_ARGS__)
-#define WLOGE(FMT, ...) fwprintf(stderr, "[util] " FMT "\n", ##__VA_ARGS__)
+#define LOG(FMT, ...) LOG_DEBUG("util", FMT, ##__VA_ARGS__)
+#define LOGE(FMT, ...) LOG_ERROR("util", FMT, ##__VA_ARGS__)
+// bypasses the queue, since the process stops right after
+#define LOGA(FMT, ...) fprintf(stderr, "[util] " FMT "\n", ##__VA_ARGS__)
 
 #define ASSERT(in_condition)                      \
 	do                                            \
 	{                                             \
 		if (__builtin_expect(!(in_condition), 0)) \
 		{                                         \
-			LOGE(                                 \
+			LOGA(                                 \
 			  "[assertion] %s:%i: '%s'",          \
 			  __FILE__,                           \
 			  __LINE__,                           \
@@ -76,10 +78,10 @@ fsu_rmfile(char const *in_path)
 {
 	size_t nchars = sys_wchar_from_utf8(in_path, NULL, 0);
 	ASSERT(nchars > 0);
-	wchar_t *utf16 = malloc(nchars * sizeof *utf16);
+	wchar_t *utf16 = mem_alloc(nchars * sizeof *utf16);
 	sys_wchar_from_utf8(in_path, utf16, nchars);
 	bool result = (DeleteFileW(utf16) == TRUE);
-	free(utf16);
+	mem_free(utf16);
 	return result;
 }
 
@@ -90,11 +92,11 @@ fsu_ptype(char const *in_path)
 	// convert utf8 to utf16/wide char
 	size_t nchars = sys_wchar_from_utf8(in_path, NULL, 0);
 	ASSERT(nchars > 0);
-	wchar_t *utf16 = malloc(nchars * sizeof *utf16);
+	wchar_t *utf16 = mem_alloc(nchars * sizeof *utf16);
 	sys_wchar_from_utf8(in_path, utf16, nchars);
 
 	DWORD const result = GetFileAttributes(utf16);
-	free(utf16);
+	mem_free(utf16);
 	if (result == INVALID_FILE_ATTRIBUTES)
 	{
 		return FSU_PATHTYPE_NONE;
@@ -191,10 +193,10 @@ fsu_mkdir(char const *in_path)
 {
 	size_t nchars = sys_wchar_from_utf8(in_path, NULL, 0);
 	ASSERT(nchars > 0);
-	wchar_t *utf16 = malloc(nchars * sizeof *utf16);
+	wchar_t *utf16 = mem_alloc(nchars * sizeof *utf16);
 	sys_wchar_from_utf8(in_path, utf16, nchars);
 	bool result = fsu_recursive_mkdir(utf16);
-	free(utf16);
+	mem_free(utf16);
 	return result;
 }
 
@@ -205,12 +207,12 @@ fsu_rmdir(char const *in_path)
 	// convert to utf16
 	size_t nchars = sys_wchar_from_utf8(in_path, NULL, 0);
 	ASSERT(nchars > 0);
-	wchar_t *utf16 = malloc(nchars * sizeof *utf16);
+	wchar_t *utf16 = mem_alloc(nchars * sizeof *utf16);
 	sys_wchar_from_utf8(in_path, utf16, nchars);
 
 	RemoveDirectory(utf16);
 
-	free(utf16);
+	mem_free(utf16);
 
 	return true;
 }
@@ -221,7 +223,7 @@ fsu_rmdir_recursive_utf16(wchar_t const *in_path)
 {
 	// pa = path + asterisk
 	size_t clen = wcslen(in_path);
-	wchar_t *pa = malloc(2 * (clen + 3));
+	wchar_t *pa = mem_alloc(2 * (clen + 3));
 	memcpy(pa, in_path, 2 * clen);
 	if (pa[clen - 1] != '/')
 	{
@@ -250,7 +252,7 @@ fsu_rmdir_recursive_utf16(wchar_t const *in_path)
 				size_t path_len = wcslen(in_path);
 				size_t file_len = wcslen(fdata.cFileName);
 				size_t sub_len = path_len + 1 /*NUL*/ + file_len;
-				wchar_t *sub = malloc(sizeof *sub * (sub_len + 1));
+				wchar_t *sub = mem_alloc(sizeof *sub * (sub_len + 1));
 				memcpy(sub, in_path, 2 * path_len);
 				sub[path_len] = '/';
 				memcpy(
@@ -263,19 +265,19 @@ fsu_rmdir_recursive_utf16(wchar_t const *in_path)
 				}
 				else
 				{
-					WLOG(L"deleting file: %s", sub);
+					LOG("deleting file: %ls", sub);
 					DeleteFile(sub);
 				}
-				free(sub);
+				mem_free(sub);
 			}
 		} while (FindNextFile(h, &fdata));
 		FindClose(h);
 	}
 
-	WLOG(L"RemoveDirectory(%s)", in_path);
+	LOG("RemoveDirectory(%ls)", in_path);
 	if (!RemoveDirectory(in_path))
 	{
-		WLOGE(L"Failed to remove %s (%u)", in_path, GetLastError());
+		LOGE("Failed to remove %ls (%lu)", in_path, GetLastError());
 	}
 	return true;
 }
@@ -294,12 +296,12 @@ fsu_rmdir_recursive(char const *in_path)
 	// convert to utf16
 	size_t nchars = sys_wchar_from_utf8(in_path, NULL, 0);
 	ASSERT(nchars > 0);
-	wchar_t *utf16 = malloc(nchars * sizeof *utf16);
+	wchar_t *utf16 = mem_alloc(nchars * sizeof *utf16);
 	sys_wchar_from_utf8(in_path, utf16, nchars);
 
 	bool ok = fsu_rmdir_recursive_utf16(utf16);
 
-	free(utf16);
+	mem_free(utf16);
 
 	return ok;
 }
@@ -313,8 +315,8 @@ fsu_rmdir_recursive(char const *in_path)
 	size_t nchars = sys_wchar_from_utf8(in_path, NULL, 0);
 	ASSERT(nchars > 0);
 	// string to SHFileOperation needs to be double-NUL terminated.
-	wchar_t *utf16 = calloc(1, sizeof *utf16 * (nchars + 1));
-	wchar_t *utf16 = malloc(nchars * sizeof *utf16);
+	wchar_t *utf16 = mem_calloc(1, sizeof *utf16 * (nchars + 1));
+	wchar_t *utf16 = mem_alloc(nchars * sizeof *utf16);
 	sys_wchar_from_utf8(in_path, utf16, nchars);
 
 	SHFILEOPSTRUCT op = { 0 };
@@ -324,7 +326,7 @@ fsu_rmdir_recursive(char const *in_path)
 	int err = SHFileOperation(&op);
 	bool ok = fsu_rmdir_recursive_utf16(utf16);
 
-	free(utf16);
+	mem_free(utf16);
 
 	return !err;
 	return ok;
@@ -341,12 +343,12 @@ fsu_enum_dir(
 	// convert to utf16
 	size_t nchars = sys_wchar_from_utf8(in_dir, NULL, 0);
 	ASSERT(nchars > 0);
-	wchar_t *utf16 = malloc(nchars * sizeof *utf16);
+	wchar_t *utf16 = mem_alloc(nchars * sizeof *utf16);
 	sys_wchar_from_utf8(in_dir, utf16, nchars);
 
 	// pa = path + asterisk
 	size_t clen = wcslen(utf16);
-	wchar_t *pa = malloc(2 * (clen + 3));
+	wchar_t *pa = mem_alloc(2 * (clen + 3));
 	memcpy(pa, utf16, 2 * clen);
 	if (pa[clen - 1] != '/')
 	{
@@ -359,7 +361,7 @@ fsu_enum_dir(
 		pa[clen + 0] = '*';
 		pa[clen + 1] = '\0';
 	}
-	WLOG(L"enum-pa = '%s'", pa);
+	LOG("enum-pa = '%ls'", pa);
 
 	WIN32_FIND_DATA fdata;
 	HANDLE h = FindFirstFile(pa, &fdata);
@@ -374,7 +376,7 @@ fsu_enum_dir(
 			// convert fdata.cFileName
 			size_t nbytes = sys_utf8_from_wchar(fdata.cFileName, NULL, 0);
 			ASSERT(nbytes > 0);
-			char *utf8 = malloc(nbytes);
+			char *utf8 = mem_alloc(nbytes);
 			sys_utf8_from_wchar(fdata.cFileName, utf8, nbytes);
 
 			if (fdata.cFileName[0] == '.')
@@ -389,7 +391,7 @@ fsu_enum_dir(
 			{
 				in_callback(in_dir, utf8, false, in_userdata);
 			}
-			free(utf8);
+			mem_free(utf8);
 		} while (FindNextFile(h, &fdata));
 		FindClose(h);
 	}
@@ -406,7 +408,7 @@ fsu_fopen(char const *in_path, char const *in_mode)
 	// convert to utf16
 	size_t nchars = sys_wchar_from_utf8(in_path, NULL, 0);
 	ASSERT(nchars > 0);
-	wchar_t *utf16 = malloc(nchars * sizeof *utf16);
+	wchar_t *utf16 = mem_alloc(nchars * sizeof *utf16);
 	sys_wchar_from_utf8(in_path, utf16, nchars);
 
 	bool has_write = false;
@@ -428,7 +430,7 @@ fsu_fopen(char const *in_path, char const *in_mode)
 	}
 
 	FILE *f = _wfopen(utf16, wmode);
-	free(utf16);
+	mem_free(utf16);
 	return f;
 }
 
@@ -448,13 +450,13 @@ fsu_mvfile(char const *in_srcpath, char const *in_dstpath, bool in_replace)
 	// convert in_srcpath to utf16
 	size_t nchars = sys_wchar_from_utf8(in_srcpath, NULL, 0);
 	ASSERT(nchars > 0);
-	wchar_t *srcpath = malloc(nchars * sizeof *srcpath);
+	wchar_t *srcpath = mem_alloc(nchars * sizeof *srcpath);
 	sys_wchar_from_utf8(in_srcpath, srcpath, nchars);
 
 	// convert in_dstpath to utf16
 	nchars = sys_wchar_from_utf8(in_dstpath, NULL, 0);
 	ASSERT(nchars > 0);
-	wchar_t *dstpath = malloc(nchars * sizeof *dstpath);
+	wchar_t *dstpath = mem_alloc(nchars * sizeof *dstpath);
 	sys_wchar_from_utf8(in_dstpath, dstpath, nchars);
 
 	BOOL result = MoveFileExW(srcpath, dstpath, flags);
@@ -472,19 +474,82 @@ fsu_mvfile(char const *in_srcpath, char const *in_dstpath, bool in_replace)
 		}
 	}
 
-	free(srcpath);
-	free(dstpath);
+	mem_free(srcpath);
+	mem_free(dstpath);
 
 	return (result == TRUE);
 }
 
+void const *
+fsu_mmap(char const *in_path, size_t *out_size)
+{
+	// convert to utf16
+	size_t nchars = sys_wchar_from_utf8(in_path, NULL, 0);
+	ASSERT(nchars);
+	wchar_t *utf16 = mem_alloc(nchars * sizeof *utf16);
+	sys_wchar_from_utf8(in_path, utf16, nchars);
+
+	HANDLE file = CreateFile(
+	  utf16,
+	  GENERIC_READ,
+	  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+	  NULL,
+	  OPEN_EXISTING,
+	  FILE_ATTRIBUTE_NORMAL,
+	  NULL);
+	mem_free(utf16);
+
+	// early out on failure
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return NULL;
+	}
+
+	void const *data = NULL;
+	LARGE_INTEGER size;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0 &&
+	  (uint64_t)size.QuadPart <= SIZE_MAX)
+	{
+		HANDLE mapping =
+		  CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping)
+		{
+			data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			// the view keeps the mapping alive on its own
+			CloseHandle(mapping);
+		}
+		if (data)
+		{
+			*out_size = (size_t)size.QuadPart;
+		}
+		else
+		{
+			LOGE("mapping %s failed %lu", in_path, GetLastError());
+		}
+	}
+
+	CloseHandle(file);
+	return data;
+}
+
+
+void
+fsu_munmap(void const *in_data, size_t UNUSED(size))
+{
+	if (in_data)
+	{
+		UnmapViewOfFile(in_data);
+	}
+}
+
+
 int64_t
 fsu_fsize(char const *in_path)
 {
 	// convert to utf16
 	size_t nchars = sys_wchar_from_utf8(in_path, NULL, 0);
 	ASSERT(nchars);
-	wchar_t *utf16 = malloc(nchars * sizeof *utf16);
+	wchar_t *utf16 = mem_alloc(nchars * sizeof *utf16);
 	sys_wchar_from_utf8(in_path, utf16, nchars);
 
 	HANDLE file = CreateFile(
@@ -495,7 +560,7 @@ fsu_fsize(char const *in_path)
 	  OPEN_EXISTING,
 	  FILE_ATTRIBUTE_NORMAL,
 	  NULL);
-	free(utf16);
+	mem_free(utf16);
 
 	// early out on failure
 	if (file == INVALID_HANDLE_VALUE)
@@ -510,6 +575,217 @@ fsu_fsize(char const *in_path)
 }
 
 
+// the path of *in_name* within *in_dir*, to be freed by the caller
+static char *
+join_path(fsu_dir in_dir, char const *in_name)
+{
+	char *path;
+	mem_asprintf(&path, "%s%s", in_dir, in_name);
+	return path;
+}
+
+
+fsu_dir
+fsu_opendir(char const *in_path, bool in_create)
+{
+	// the path ends with '/', so that names are simply appended
+	size_t const len = strlen(in_path);
+	char *dir;
+	mem_asprintf(
+	  &dir,
+	  "%s%s",
+	  in_path,
+	  len > 0 && (in_path[len - 1] == '/' || in_path[len - 1] == '\\')
+	    ? ""
+	    : "/");
+	if (in_create)
+	{
+		fsu_mkdir(dir);
+	}
+	if (fsu_ptype(dir) != FSU_PATHTYPE_DIR)
+	{
+		mem_free(dir);
+		return FSU_NODIR;
+	}
+	return dir;
+}
+
+
+fsu_dir
+fsu_opendirat(fsu_dir in_dir, char const *in_name, bool in_create)
+{
+	char *path = join_path(in_dir, in_name);
+	fsu_dir dir = fsu_opendir(path, in_create);
+	mem_free(path);
+	return dir;
+}
+
+
+void
+fsu_closedir(fsu_dir in_dir)
+{
+	mem_free(in_dir);
+}
+
+
+enum fsu_pathtype
+fsu_ptypeat(fsu_dir in_dir, char const *in_name)
+{
+	char *path = join_path(in_dir, in_name);
+	enum fsu_pathtype const type = fsu_ptype(path);
+	mem_free(path);
+	return type;
+}
+
+
+uint64_t
+fsu_mtimeat(fsu_dir in_dir, char const *in_name)
+{
+	char *path = join_path(in_dir, in_name);
+	size_t nchars = sys_wchar_from_utf8(path, NULL, 0);
+	ASSERT(nchars > 0);
+	wchar_t *utf16 = mem_alloc(nchars * sizeof *utf16);
+	sys_wchar_from_utf8(path, utf16, nchars);
+	mem_free(path);
+
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	BOOL const ok = GetFileAttributesEx(utf16, GetFileExInfoStandard, &data);
+	mem_free(utf16);
+	if (!ok)
+	{
+		return 0;
+	}
+	// in 100 ns since 1601
+	FILETIME const mtime = data.ftLastWriteTime;
+	uint64_t const ticks =
+	  (uint64_t)mtime.dwHighDateTime << 32 | mtime.dwLowDateTime;
+	return (ticks - 116444736000000000ull) * 100;
+}
+
+
+FILE *
+fsu_fopenat(fsu_dir in_dir, char const *in_name, char const *in_mode)
+{
+	char *path = join_path(in_dir, in_name);
+	FILE *f = fsu_fopen(path, in_mode);
+	mem_free(path);
+	return f;
+}
+
+
+bool
+fsu_rmfileat(fsu_dir in_dir, char const *in_name)
+{
+	char *path = join_path(in_dir, in_name);
+	bool const result = fsu_rmfile(path);
+	mem_free(path);
+	return result;
+}
+
+
+bool
+fsu_rmdirat_recursive(fsu_dir in_dir, char const *in_name)
+{
+	char *path = join_path(in_dir, in_name);
+	bool const result = fsu_rmdir_recursive(path);
+	mem_free(path);
+	return result;
+}
+
+
+bool
+fsu_renameat(
+  fsu_dir in_srcdir,
+  char const *in_srcname,
+  fsu_dir in_dstdir,
+  char const *in_dstname)
+{
+	char *srcpath = join_path(in_srcdir, in_srcname);
+	char *dstpath = join_path(in_dstdir, in_dstname);
+
+	size_t nchars = sys_wchar_from_utf8(srcpath, NULL, 0);
+	ASSERT(nchars > 0);
+	wchar_t *wsrcpath = mem_alloc(nchars * sizeof *wsrcpath);
+	sys_wchar_from_utf8(srcpath, wsrcpath, nchars);
+
+	nchars = sys_wchar_from_utf8(dstpath, NULL, 0);
+	ASSERT(nchars > 0);
+	wchar_t *wdstpath = mem_alloc(nchars * sizeof *wdstpath);
+	sys_wchar_from_utf8(dstpath, wdstpath, nchars);
+
+	// without MOVEFILE_COPY_ALLOWED, so that it is never a copy
+	BOOL const result = MoveFileExW(wsrcpath, wdstpath, 0);
+	DWORD const error = result ? ERROR_SUCCESS : GetLastError();
+	if (!result)
+	{
+		LOGE("MoveFileEx failed %lu", error);
+	}
+
+	mem_free(wsrcpath);
+	mem_free(wdstpath);
+	mem_free(srcpath);
+	mem_free(dstpath);
+
+	// for fsu_renameat_existed(), past whatever logging and freeing set
+	SetLastError(error);
+	return (result == TRUE);
+}
+
+
+bool
+fsu_renameat_existed(void)
+{
+	DWORD const error = GetLastError();
+	return error == ERROR_ALREADY_EXISTS || error == ERROR_FILE_EXISTS;
+}
+
+
+bool
+fsu_exchangeat(
+  fsu_dir UNUSED(in_dir1),
+  char const *UNUSED(in_name1),
+  fsu_dir UNUSED(in_dir2),
+  char const *UNUSED(in_name2))
+{
+	// there is no atomic exchange of directories
+	return false;
+}
+
+
+struct enum_dirat
+{
+	fsu_enum_dir_callback callback;
+	void *userdata;
+};
+
+
+// hides the root, as the POSIX version does
+static void
+on_enum_dirat(
+  char const *UNUSED(root),
+  char const *name,
+  bool is_dir,
+  void *in_userdata)
+{
+	struct enum_dirat const *enumeration = in_userdata;
+	enumeration->callback(NULL, name, is_dir, enumeration->userdata);
+}
+
+
+bool
+fsu_enum_dirat(
+  fsu_dir in_dir,
+  fsu_enum_dir_callback in_callback,
+  void *in_userdata)
+{
+	struct enum_dirat enumeration = {
+		.callback = in_callback,
+		.userdata = in_userdata,
+	};
+	return fsu_enum_dir(in_dir, on_enum_dirat, &enumeration);
+}
+
+
 void
 sys_sleep(uint32_t ms)
 {
@@ -563,6 +839,31 @@ sys_seconds(void)
 }
 
 
+uint64_t
+sys_nanoseconds(void)
+{
+	static LARGE_INTEGER frequency;
+	if (frequency.QuadPart == 0)
+	{
+		QueryPerformanceFrequency(&frequency);
+	}
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	// split to avoid overflowing for long uptimes
+	uint64_t const freq = (uint64_t)frequency.QuadPart;
+	uint64_t const ticks = (uint64_t)counter.QuadPart;
+	return (ticks / freq) * 1000000000 + (ticks % freq) * 1000000000 / freq;
+}
+
+
+void
+sys_thread_background(void)
+{
+	// lowers the IO and memory priority as well
+	SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+}
+
+
 #ifndef UTIL_HAS_THREADS_H
 int
 mtx_init(mtx_t *mutex, int type)
@@ -594,4 +895,133 @@ mtx_unlock(mtx_t *mutex)
 	LeaveCriticalSection(mutex);
 	return 0;
 }
+
+
+int
+cnd_init(cnd_t *cond)
+{
+	InitializeConditionVariable(cond);
+	return thrd_success;
+}
+
+
+int
+cnd_signal(cnd_t *cond)
+{
+	WakeConditionVariable(cond);
+	return thrd_success;
+}
+
+
+int
+cnd_wait(cnd_t *cond, mtx_t *mutex)
+{
+	if (!SleepConditionVariableCS(cond, mutex, INFINITE))
+	{
+		return thrd_error;
+	}
+	return thrd_success;
+}
+
+
+int
+cnd_timedwait(
+  cnd_t *cond,
+  mtx_t *mutex,
+  struct timespec const *time_point)
+{
+	struct timespec now;
+	timespec_get(&now, TIME_UTC);
+	int64_t const ms = (time_point->tv_sec - now.tv_sec) * 1000 +
+	  (time_point->tv_nsec - now.tv_nsec) / 1000000;
+	if (!SleepConditionVariableCS(cond, mutex, ms > 0 ? (DWORD)ms : 0))
+	{
+		return GetLastError() == ERROR_TIMEOUT ? thrd_timedout : thrd_error;
+	}
+	return thrd_success;
+}
+
+
+void
+cnd_destroy(cnd_t *UNUSED(cond))
+{
+	// condition variables need no cleanup on windows
+}
+
+
+int
+tss_create(tss_t *key, tss_dtor_t dtor)
+{
+	// fiber local storage, since only FLS supports destructors.
+	// on x64 tss_dtor_t and PFLS_CALLBACK_FUNCTION are compatible.
+	*key = FlsAlloc(dtor);
+	return *key != FLS_OUT_OF_INDEXES ? thrd_success : thrd_error;
+}
+
+
+void *
+tss_get(tss_t key)
+{
+	return FlsGetValue(key);
+}
+
+
+int
+tss_set(tss_t key, void *value)
+{
+	return FlsSetValue(key, value) ? thrd_success : thrd_error;
+}
+
+
+struct thrd_start
+{
+	thrd_start_t func;
+	void *arg;
+};
+
+
+static DWORD WINAPI
+thrd_trampoline(LPVOID in_start)
+{
+	struct thrd_start start = *(struct thrd_start *)in_start;
+	mem_free(in_start);
+	return (DWORD)start.func(start.arg);
+}
+
+
+int
+thrd_create(thrd_t *thr, thrd_start_t func, void *arg)
+{
+	struct thrd_start *start = mem_alloc(sizeof *start);
+	if (!start)
+	{
+		return thrd_error;
+	}
+	start->func = func;
+	start->arg = arg;
+	*thr = CreateThread(NULL, 0, thrd_trampoline, start, 0, NULL);
+	if (!*thr)
+	{
+		mem_free(start);
+		return thrd_error;
+	}
+	return thrd_success;
+}
+
+
+int
+thrd_join(thrd_t thr, int *res)
+{
+	if (WaitForSingleObject(thr, INFINITE) != WAIT_OBJECT_0)
+	{
+		return thrd_error;
+	}
+	DWORD code;
+	if (res && GetExitCodeThread(thr, &code))
+	{
+		*res = (int)code;
+	}
+	CloseHandle(thr);
+	return thrd_success;
+}
 #endif
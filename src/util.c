@@ -1,24 +1,32 @@
+#include "log.h"
 #include "util.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define UNUSED(X) __pragma(warning(suppress : 4100)) X
+#else
+#define UNUSED(X) __attribute__((unused)) X
+#endif
+
 #pragma GCC diagnostic push
 #ifdef __clang__
 #pragma GCC diagnostic ignored "-Wgnu-zero-variadic-macro-arguments"
 #endif
 #pragma GCC diagnostic ignored "-Wunused-macros"
 
-#ifdef MINIMOD_LOG_ENABLE
-#define LOG(FMT, ...) printf("[util] " FMT "\n", ##__VA_ARGS__)
-#else
-#define LOG(...)
-#endif
-#define LOGE(FMT, ...) fprintf(stderr, "[util] " FMT "\n", ##__VA_ARGS__)
+#define LOG(FMT, ...) LOG_DEBUG("util", FMT, ##__VA_ARGS__)
+#define LOGE(FMT, ...) LOG_ERROR("util", FMT, ##__VA_ARGS__)
+// bypasses the queue, since the process stops right after
+#define LOGA(FMT, ...) fprintf(stderr, "[util] " FMT "\n", ##__VA_ARGS__)
 
 #define ASSERT(in_condition)                      \
 	do                                            \
 	{                                             \
 		if (__builtin_expect(!(in_condition), 0)) \
 		{                                         \
-			LOGE(                                 \
+			LOGA(                                 \
 			  "[assertion] %s:%i: '%s'",          \
 			  __FILE__,                           \
 			  __LINE__,                           \
@@ -31,6 +39,155 @@
 #pragma GCC diagnostic pop
 
 
+static void *
+default_alloc(void *UNUSED(userdata), size_t in_bytes)
+{
+	return malloc(in_bytes);
+}
+
+
+static void *
+default_realloc(void *UNUSED(userdata), void *in_ptr, size_t in_bytes)
+{
+	return realloc(in_ptr, in_bytes);
+}
+
+
+static void
+default_free(void *UNUSED(userdata), void *in_ptr)
+{
+	free(in_ptr);
+}
+
+
+struct mem
+{
+	mem_alloc_callback alloc;
+	mem_realloc_callback realloc;
+	mem_free_callback free;
+	void *userdata;
+};
+static struct mem l_mem = {
+	.alloc = default_alloc,
+	.realloc = default_realloc,
+	.free = default_free,
+};
+
+
+void
+mem_set_allocator(
+  mem_alloc_callback in_alloc,
+  mem_realloc_callback in_realloc,
+  mem_free_callback in_free,
+  void *in_userdata)
+{
+	if (in_alloc && in_realloc && in_free)
+	{
+		l_mem = (struct mem){
+			.alloc = in_alloc,
+			.realloc = in_realloc,
+			.free = in_free,
+			.userdata = in_userdata,
+		};
+	}
+	else
+	{
+		l_mem = (struct mem){
+			.alloc = default_alloc,
+			.realloc = default_realloc,
+			.free = default_free,
+		};
+	}
+}
+
+
+void *
+mem_alloc(size_t in_bytes)
+{
+	return l_mem.alloc(l_mem.userdata, in_bytes);
+}
+
+
+void *
+mem_calloc(size_t in_count, size_t in_bytes)
+{
+	if (in_bytes > 0 && in_count > SIZE_MAX / in_bytes)
+	{
+		return NULL;
+	}
+	void *ptr = mem_alloc(in_count * in_bytes);
+	if (ptr)
+	{
+		memset(ptr, 0, in_count * in_bytes);
+	}
+	return ptr;
+}
+
+
+void *
+mem_realloc(void *in_ptr, size_t in_bytes)
+{
+	return l_mem.realloc(l_mem.userdata, in_ptr, in_bytes);
+}
+
+
+void
+mem_free(void *in_ptr)
+{
+	if (in_ptr)
+	{
+		l_mem.free(l_mem.userdata, in_ptr);
+	}
+}
+
+
+char *
+mem_strdup(char const *in_str)
+{
+	size_t const nbytes = strlen(in_str) + 1;
+	char *str = mem_alloc(nbytes);
+	if (str)
+	{
+		memcpy(str, in_str, nbytes);
+	}
+	return str;
+}
+
+
+int
+mem_asprintf(char **out_str, char const *in_format, ...)
+{
+	va_list args;
+	va_start(args, in_format);
+	int const size = mem_vasprintf(out_str, in_format, args);
+	va_end(args);
+	return size;
+}
+
+
+int
+mem_vasprintf(char **out_str, char const *in_format, va_list in_args)
+{
+	*out_str = NULL;
+
+	va_list args;
+	va_copy(args, in_args);
+	int const size = vsnprintf(NULL, 0, in_format, args);
+	va_end(args);
+	if (size < 0)
+	{
+		return -1;
+	}
+
+	*out_str = mem_alloc((size_t)size + 1 /*NUL*/);
+	if (!*out_str)
+	{
+		return -1;
+	}
+	return vsnprintf(*out_str, (size_t)size + 1, in_format, in_args);
+}
+
+
 static int8_t const kTable[64] = {
 	'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M',
 	'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
@@ -13,12 +13,15 @@
 #ifndef __cplusplus
 #include <stdbool.h>
 #endif
+#include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h> // FILE
 #if __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
 #define UTIL_HAS_THREADS_H
 #include <threads.h>
 #else
+#include <time.h> // struct timespec
 #ifdef _WIN32
 #include <Windows.h>
 #else
@@ -32,6 +35,81 @@ extern "C" {
 
 /* Section: API */
 
+/* Callback: mem_alloc_callback()
+ *
+ * Like malloc(). See <mem_set_allocator()>.
+ */
+typedef void *(*mem_alloc_callback)(void *userdata, size_t bytes);
+
+/* Callback: mem_realloc_callback()
+ *
+ * Like realloc(). See <mem_set_allocator()>.
+ */
+typedef void *(*mem_realloc_callback)(void *userdata, void *ptr, size_t bytes);
+
+/* Callback: mem_free_callback()
+ *
+ * Like free(). See <mem_set_allocator()>.
+ */
+typedef void (*mem_free_callback)(void *userdata, void *ptr);
+
+/* Function: mem_set_allocator()
+ *
+ * Route all mem_*-functions through the given functions.
+ * If any of them is NULL, the C library's functions are used.
+ *
+ * Attention:
+ *	Not thread-safe. Memory has to be freed by the same allocator it was
+ *	allocated by.
+ */
+void
+mem_set_allocator(
+  mem_alloc_callback in_alloc,
+  mem_realloc_callback in_realloc,
+  mem_free_callback in_free,
+  void *in_userdata);
+
+/* Function: mem_alloc()
+ *
+ * Like malloc(), but uses the allocator set by <mem_set_allocator()>,
+ * as do the other mem_*-functions.
+ */
+void *
+mem_alloc(size_t in_bytes);
+
+/* Function: mem_calloc()
+ */
+void *
+mem_calloc(size_t in_count, size_t in_bytes);
+
+/* Function: mem_realloc()
+ */
+void *
+mem_realloc(void *in_ptr, size_t in_bytes);
+
+/* Function: mem_free()
+ */
+void
+mem_free(void *in_ptr);
+
+/* Function: mem_strdup()
+ */
+char *
+mem_strdup(char const *in_str);
+
+/* Function: mem_asprintf()
+ *
+ * Like asprintf(). On failure *out_str* is set to NULL.
+ */
+int
+mem_asprintf(char **out_str, char const *in_format, ...)
+  __attribute__((format(printf, 2, 3)));
+
+/* Function: mem_vasprintf()
+ */
+int
+mem_vasprintf(char **out_str, char const *in_format, va_list in_args);
+
 /* Function: enc_base64()
  *
  * Encode *in_srcbytes* bytes from *in_src* into *out_dst* buffer, of size
@@ -147,6 +225,24 @@ fsu_mvfile(char const *from, char const *to, bool in_replace);
 bool
 fsu_rmfile(char const *path);
 
+/* Function: fsu_mmap()
+ *
+ *	Map a file read-only into memory.
+ *
+ *	Returns:
+ *		NULL on error/if file does not exist or is empty.
+ *		Otherwise the file's data, and its size in *out_size*.
+ */
+void const *
+fsu_mmap(char const *path, size_t *out_size);
+
+/* Function: fsu_munmap()
+ *
+ *	Unmap a file mapped by <fsu_mmap()>.
+ */
+void
+fsu_munmap(void const *data, size_t size);
+
 /* Function: fsu_enum_dir()
  *
  * Enumerate a directory by calling in_callback function for every
@@ -164,6 +260,144 @@ fsu_enum_dir(
   fsu_enum_dir_callback in_callback,
   void *in_userdata);
 
+/* Type: fsu_dir
+ *
+ * An open directory, see <fsu_opendir()>. The *at-functions take names
+ * relative to it, thusly its path is not resolved again for each of them.
+ * On POSIX a file descriptor and the *at-functions allocate nothing, on
+ * Windows the directory's path, which they join names to.
+ *
+ * FSU_NODIR - Not a directory, returned on errors.
+ */
+#ifdef _WIN32
+typedef char *fsu_dir;
+#define FSU_NODIR NULL
+#else
+typedef int fsu_dir;
+#define FSU_NODIR (-1)
+#endif
+
+/* Function: fsu_opendir()
+ *
+ *	Open a directory.
+ *
+ *	Parameters:
+ *		in_create - Create the directory and any missing parents.
+ *
+ *	Returns:
+ *		FSU_NODIR on error/if the directory does not exist.
+ */
+fsu_dir
+fsu_opendir(char const *in_path, bool in_create);
+
+/* Function: fsu_opendirat()
+ *
+ *	Like <fsu_opendir()>, with *in_name* relative to *in_dir*.
+ */
+fsu_dir
+fsu_opendirat(fsu_dir in_dir, char const *in_name, bool in_create);
+
+/* Function: fsu_closedir()
+ *
+ *	Close a directory opened by <fsu_opendir()>, FSU_NODIR is ignored.
+ */
+void
+fsu_closedir(fsu_dir in_dir);
+
+/* Function: fsu_ptypeat()
+ *
+ *	<fsu_ptype()> relative to *in_dir*.
+ */
+enum fsu_pathtype
+fsu_ptypeat(fsu_dir in_dir, char const *in_name);
+
+/* Function: fsu_mtimeat()
+ *
+ *	When *in_name* in *in_dir* was last modified, for a directory when an
+ *	entry was last added, removed or renamed. "." is *in_dir* itself.
+ *
+ *	Returns:
+ *		Nanoseconds since 1970, 0 if it does not exist.
+ */
+uint64_t
+fsu_mtimeat(fsu_dir in_dir, char const *in_name);
+
+/* Function: fsu_fopenat()
+ *
+ *	<fsu_fopen()> relative to *in_dir*. Missing directories of *in_name*
+ *	are only created if opening the file fails without them.
+ */
+FILE *
+fsu_fopenat(fsu_dir in_dir, char const *in_name, char const *in_mode);
+
+/* Function: fsu_rmfileat()
+ *
+ *	<fsu_rmfile()> relative to *in_dir*.
+ */
+bool
+fsu_rmfileat(fsu_dir in_dir, char const *in_name);
+
+/* Function: fsu_rmdirat_recursive()
+ *
+ *	<fsu_rmdir_recursive()> relative to *in_dir*.
+ */
+bool
+fsu_rmdirat_recursive(fsu_dir in_dir, char const *in_name);
+
+/* Function: fsu_renameat()
+ *
+ *	Rename *in_srcname* in *in_srcdir* to *in_dstname* in *in_dstdir*,
+ *	which is atomic, thusly both have to be on the same file system.
+ *	Whether an existing *in_dstname* is replaced depends on the platform.
+ *
+ *	Returns:
+ *		false on error, i.e. if the directories are on different file
+ *		systems.
+ */
+bool
+fsu_renameat(
+  fsu_dir in_srcdir,
+  char const *in_srcname,
+  fsu_dir in_dstdir,
+  char const *in_dstname);
+
+/* Function: fsu_renameat_existed()
+ *
+ *	Whether the last <fsu_renameat()> of the calling thread failed since
+ *	*in_dstname* exists and the platform does not replace it, rather than
+ *	for any other reason. Only valid right after it failed.
+ */
+bool
+fsu_renameat_existed(void);
+
+/* Function: fsu_exchangeat()
+ *
+ *	Exchange *in_name1* in *in_dir1* and *in_name2* in *in_dir2*
+ *	atomically, thusly no one sees either of them missing. Both have to
+ *	exist and to be on the same file system.
+ *
+ *	Returns:
+ *		false on error, or if the platform or file system cannot exchange
+ *		them. Then nothing changed.
+ */
+bool
+fsu_exchangeat(
+  fsu_dir in_dir1,
+  char const *in_name1,
+  fsu_dir in_dir2,
+  char const *in_name2);
+
+/* Function: fsu_enum_dirat()
+ *
+ *	<fsu_enum_dir()> of *in_dir*. The callback's *root* is NULL, use
+ *	*in_dir* with the *at-functions instead.
+ */
+bool
+fsu_enum_dirat(
+  fsu_dir in_dir,
+  fsu_enum_dir_callback in_callback,
+  void *in_userdata);
+
 /* Function: sys_sleep()
  *
  * Sleep thread for certain amount of milliseconds.
@@ -181,20 +415,55 @@ sys_sleep(uint32_t ms);
 time_t
 sys_seconds(void);
 
+/* Function: sys_nanoseconds()
+ *
+ * Gets a monotonic timestamp in nanoseconds, for measuring durations.
+ *
+ * Attention:
+ *  The reference point is arbitrary and may differ between processes.
+ */
+uint64_t
+sys_nanoseconds(void);
+
+/* Function: sys_thread_background()
+ *
+ * Lower the CPU and, where supported, the IO priority of the calling
+ * thread, for work which is not waited for.
+ */
+void
+sys_thread_background(void);
+
 #ifndef UTIL_HAS_THREADS_H
 // if there is no system/compiler provided implementation of C11's threads.h
-// use this barebones mtx-functions to provide the required functionality.
+// use this barebones mtx/cnd/tss/thrd-functions to provide the required
+// functionality.
 #ifdef _WIN32
 typedef CRITICAL_SECTION mtx_t;
+typedef CONDITION_VARIABLE cnd_t;
+typedef DWORD tss_t;
+typedef HANDLE thrd_t;
 #else
 typedef pthread_mutex_t mtx_t;
+typedef pthread_cond_t cnd_t;
+typedef pthread_key_t tss_t;
+typedef pthread_t thrd_t;
 #endif
 
+typedef void (*tss_dtor_t)(void *);
+typedef int (*thrd_start_t)(void *);
+
 enum mtx_types
 {
 	mtx_plain = 0,
 };
 
+enum thrd_results
+{
+	thrd_success = 0,
+	thrd_timedout = 1,
+	thrd_error = 2,
+};
+
 int
 mtx_init(mtx_t *mutex, int type);
 
@@ -207,6 +476,39 @@ mtx_unlock(mtx_t *mutex);
 void
 mtx_destroy(mtx_t *mutex);
 
+int
+cnd_init(cnd_t *cond);
+
+int
+cnd_signal(cnd_t *cond);
+
+int
+cnd_wait(cnd_t *cond, mtx_t *mutex);
+
+int
+cnd_timedwait(
+  cnd_t *cond,
+  mtx_t *mutex,
+  struct timespec const *time_point);
+
+void
+cnd_destroy(cnd_t *cond);
+
+int
+tss_create(tss_t *key, tss_dtor_t dtor);
+
+void *
+tss_get(tss_t key);
+
+int
+tss_set(tss_t key, void *value);
+
+int
+thrd_create(thrd_t *thr, thrd_start_t func, void *arg);
+
+int
+thrd_join(thrd_t thr, int *res);
+
 #endif
 
 #ifdef _WIN32
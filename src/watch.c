@@ -0,0 +1,437 @@
+#include "watch.h"
+
+#include "log.h"
+#include "util.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __linux__
+#define HAS_INOTIFY
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define UNUSED(X) __pragma(warning(suppress : 4100)) X
+#else
+#define UNUSED(X) __attribute__((unused)) X
+#endif
+
+#pragma GCC diagnostic push
+#ifdef __clang__
+#pragma GCC diagnostic ignored "-Wgnu-zero-variadic-macro-arguments"
+#endif
+#pragma GCC diagnostic ignored "-Wunused-macros"
+
+#define LOG(FMT, ...) LOG_DEBUG("watch", FMT, ##__VA_ARGS__)
+#define LOGE(FMT, ...) LOG_ERROR("watch", FMT, ##__VA_ARGS__)
+
+#pragma GCC diagnostic pop
+
+// CONFIG
+// ------
+// how long the polling thread sleeps before it checks whether it shall stop
+#define WATCH_IDLE_MS 100
+// how often the directory is polled without inotify
+#define WATCH_POLL_MS 2000
+
+
+// a directory within the watched one
+struct subdir
+{
+	char *name;
+	int wd;
+	char _padding[4];
+};
+
+
+struct watch
+{
+	char *root;
+	watch_callback callback;
+	void *userdata;
+	// the directories within root and their inotify watches
+	struct subdir *subdirs;
+	size_t nsubdirs;
+	size_t subdirs_capacity;
+	thrd_t thread;
+	// inotify instance and the watch of root, both -1 while polling
+	int fd;
+	int root_wd;
+	// written by watch_stop() to end the thread's wait for events, -1
+	// without inotify. it outlives fd, which the thread may close.
+	int wake_fd;
+	bool running;
+	char _padding[3];
+};
+static struct watch l_watch;
+
+
+#ifdef HAS_INOTIFY
+#define ROOT_EVENTS                                                     \
+	(IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR | \
+	  IN_DELETE_SELF | IN_MOVE_SELF)
+// IN_CLOSE_WRITE, since a file is of no use while it is still written
+#define SUBDIR_EVENTS                                                   \
+	(IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR | \
+	  IN_CLOSE_WRITE)
+
+
+// closes the inotify instance, which removes all watches, so that the
+// directory is polled from there on
+static void
+stop_inotify(void)
+{
+	if (l_watch.fd >= 0)
+	{
+		close(l_watch.fd);
+	}
+	l_watch.fd = -1;
+	l_watch.root_wd = -1;
+	for (size_t i = 0; i < l_watch.nsubdirs; ++i)
+	{
+		mem_free(l_watch.subdirs[i].name);
+	}
+	mem_free(l_watch.subdirs);
+	l_watch.subdirs = NULL;
+	l_watch.nsubdirs = 0;
+	l_watch.subdirs_capacity = 0;
+}
+
+
+// by its watch or, if *in_name* is not NULL, by its name
+static struct subdir *
+find_subdir(int in_wd, char const *in_name)
+{
+	for (size_t i = 0; i < l_watch.nsubdirs; ++i)
+	{
+		struct subdir *subdir = &l_watch.subdirs[i];
+		if (in_name ? 0 == strcmp(subdir->name, in_name) : subdir->wd == in_wd)
+		{
+			return subdir;
+		}
+	}
+	return NULL;
+}
+
+
+static void
+remove_subdir(struct subdir *in_subdir)
+{
+	mem_free(in_subdir->name);
+	*in_subdir = l_watch.subdirs[--l_watch.nsubdirs];
+}
+
+
+static void
+add_subdir(char const *in_name)
+{
+	char *path;
+	mem_asprintf(&path, "%s%s", l_watch.root, in_name);
+	int const wd = inotify_add_watch(l_watch.fd, path, SUBDIR_EVENTS);
+	if (wd < 0)
+	{
+		// i.e. the limit of watches is reached
+		LOGE("could not watch %s, polling instead", path);
+		mem_free(path);
+		stop_inotify();
+		return;
+	}
+	mem_free(path);
+
+	// already watched, i.e. found by the listing and then created
+	if (find_subdir(wd, NULL))
+	{
+		return;
+	}
+
+	if (l_watch.nsubdirs == l_watch.subdirs_capacity)
+	{
+		size_t const capacity = l_watch.subdirs_capacity * 2 + 16;
+		struct subdir *subdirs =
+		  mem_realloc(l_watch.subdirs, capacity * sizeof *subdirs);
+		if (!subdirs)
+		{
+			inotify_rm_watch(l_watch.fd, wd);
+			stop_inotify();
+			return;
+		}
+		l_watch.subdirs = subdirs;
+		l_watch.subdirs_capacity = capacity;
+	}
+	l_watch.subdirs[l_watch.nsubdirs++] = (struct subdir){
+		.name = mem_strdup(in_name),
+		.wd = wd,
+	};
+}
+
+
+static void
+on_root_entry(
+  char const *UNUSED(root),
+  char const *name,
+  bool is_dir,
+  void *UNUSED(userdata))
+{
+	if (is_dir && l_watch.fd >= 0)
+	{
+		add_subdir(name);
+	}
+}
+
+
+static bool
+start_inotify(void)
+{
+	l_watch.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (l_watch.wake_fd < 0)
+	{
+		return false;
+	}
+	l_watch.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (l_watch.fd < 0)
+	{
+		return false;
+	}
+	l_watch.root_wd = inotify_add_watch(l_watch.fd, l_watch.root, ROOT_EVENTS);
+	if (l_watch.root_wd < 0)
+	{
+		stop_inotify();
+		return false;
+	}
+	fsu_enum_dir(l_watch.root, on_root_entry, NULL);
+	return l_watch.fd >= 0;
+}
+
+
+static void
+handle_event(struct inotify_event const *in_event)
+{
+	if (in_event->mask & IN_Q_OVERFLOW)
+	{
+		l_watch.callback(l_watch.userdata, NULL, NULL);
+		return;
+	}
+
+	if (in_event->wd == l_watch.root_wd)
+	{
+		if (in_event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+		{
+			LOGE("%s is gone, polling instead", l_watch.root);
+			stop_inotify();
+		}
+		else if (in_event->len > 0 && (in_event->mask & IN_ISDIR))
+		{
+			if (in_event->mask & (IN_CREATE | IN_MOVED_TO))
+			{
+				add_subdir(in_event->name);
+			}
+			else
+			{
+				// a directory moved within root is watched anew under its
+				// new name, with the next event
+				struct subdir *subdir = find_subdir(-1, in_event->name);
+				if (subdir)
+				{
+					inotify_rm_watch(l_watch.fd, subdir->wd);
+					remove_subdir(subdir);
+				}
+			}
+			// whatever it contains appeared or disappeared with it
+			l_watch.callback(l_watch.userdata, in_event->name, NULL);
+		}
+		return;
+	}
+
+	struct subdir *subdir = find_subdir(in_event->wd, NULL);
+	if (!subdir)
+	{
+		return;
+	}
+	if (in_event->mask & IN_IGNORED)
+	{
+		// removed, which root's events report
+		remove_subdir(subdir);
+	}
+	else if ((in_event->mask & (IN_CREATE | IN_ISDIR)) == IN_CREATE)
+	{
+		// created files are reported by IN_CLOSE_WRITE, once written
+	}
+	else if (in_event->len > 0)
+	{
+		l_watch.callback(l_watch.userdata, subdir->name, in_event->name);
+	}
+}
+
+
+// ends the thread's wait in read_events()
+static void
+wake_thread(void)
+{
+	if (l_watch.wake_fd >= 0)
+	{
+		// which stays readable, since nobody reads it
+		uint64_t const one = 1;
+		if (write(l_watch.wake_fd, &one, sizeof one) < 0)
+		{
+			LOGE("could not wake the watching thread");
+		}
+	}
+}
+
+
+static void
+close_wake(void)
+{
+	if (l_watch.wake_fd >= 0)
+	{
+		close(l_watch.wake_fd);
+	}
+	l_watch.wake_fd = -1;
+}
+
+
+// waits for events until there are some or the thread shall stop
+static void
+read_events(void)
+{
+	struct pollfd fds[] = {
+		{ .fd = l_watch.fd, .events = POLLIN },
+		{ .fd = l_watch.wake_fd, .events = POLLIN },
+	};
+	if (poll(fds, 2, -1) <= 0 || !(fds[0].revents & POLLIN))
+	{
+		return;
+	}
+
+	char buffer[4096]
+	  __attribute__((aligned(__alignof__(struct inotify_event))));
+	ssize_t len;
+	while (l_watch.fd >= 0 &&
+	  (len = read(l_watch.fd, buffer, sizeof buffer)) > 0)
+	{
+		for (char const *p = buffer; p < buffer + len && l_watch.fd >= 0;)
+		{
+			struct inotify_event const *event = (void const *)p;
+			handle_event(event);
+			p += sizeof *event + event->len;
+		}
+	}
+}
+#else
+// l_watch.fd stays -1, so the directory is always polled
+static bool
+start_inotify(void)
+{
+	return false;
+}
+
+
+static void
+stop_inotify(void)
+{
+}
+
+
+static void
+wake_thread(void)
+{
+}
+
+
+static void
+close_wake(void)
+{
+}
+
+
+static void
+read_events(void)
+{
+}
+#endif
+
+
+static int
+run(void *UNUSED(in_userdata))
+{
+	l_watch.callback(l_watch.userdata, NULL, NULL);
+	uint64_t polled = sys_nanoseconds();
+	while (__atomic_load_n(&l_watch.running, __ATOMIC_ACQUIRE))
+	{
+		if (l_watch.fd >= 0)
+		{
+			read_events();
+			continue;
+		}
+		sys_sleep(WATCH_IDLE_MS);
+		uint64_t const now = sys_nanoseconds();
+		if (now - polled >= WATCH_POLL_MS * 1000000ull)
+		{
+			polled = now;
+			l_watch.callback(l_watch.userdata, NULL, NULL);
+		}
+	}
+	return 0;
+}
+
+
+bool
+watch_start(
+  char const *in_root,
+  watch_callback in_callback,
+  void *in_userdata)
+{
+	if (l_watch.running)
+	{
+		return false;
+	}
+	l_watch.root = mem_strdup(in_root);
+	l_watch.callback = in_callback;
+	l_watch.userdata = in_userdata;
+	l_watch.fd = -1;
+	l_watch.root_wd = -1;
+	l_watch.wake_fd = -1;
+
+	if (start_inotify())
+	{
+		LOG("watching %s with inotify", l_watch.root);
+	}
+	else
+	{
+		LOG("polling %s every %i ms", l_watch.root, WATCH_POLL_MS);
+	}
+
+	__atomic_store_n(&l_watch.running, true, __ATOMIC_RELEASE);
+	if (thrd_create(&l_watch.thread, run, NULL) != thrd_success)
+	{
+		LOGE("could not start watching %s", l_watch.root);
+		__atomic_store_n(&l_watch.running, false, __ATOMIC_RELEASE);
+		watch_stop();
+		return false;
+	}
+	return true;
+}
+
+
+void
+watch_stop(void)
+{
+	if (!l_watch.root)
+	{
+		return;
+	}
+	if (__atomic_load_n(&l_watch.running, __ATOMIC_ACQUIRE))
+	{
+		__atomic_store_n(&l_watch.running, false, __ATOMIC_RELEASE);
+		wake_thread();
+		thrd_join(l_watch.thread, NULL);
+	}
+	stop_inotify();
+	close_wake();
+	mem_free(l_watch.root);
+	l_watch = (struct watch){ 0 };
+}
@@ -0,0 +1,70 @@
+// vi: filetype=c
+#pragma once
+#ifndef MINIMOD_WATCH_H_INCLUDED
+#define MINIMOD_WATCH_H_INCLUDED
+
+/* Title: watch
+ *
+ * Topic: Introduction
+ *
+ * Reports changes to a directory and to the directories within it, but not
+ * to anything deeper. On Linux inotify tells which entries changed,
+ * elsewhere, or if inotify is not available, the directory is polled and
+ * every poll reports that anything might have changed.
+ *
+ * Changes are reported from a thread of its own, thusly the callback has
+ * to be thread-safe. Only one directory can be watched at a time.
+ */
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Section: API */
+
+/* Callback: watch_callback()
+ *
+ * Called once right after <watch_start()>, with *in_dir* and *in_name*
+ * NULL, so that the state read before watching can be brought up to date.
+ *
+ * Parameters:
+ *	in_dir - Name of the directory within the watched directory in which
+ *		something changed. NULL if anything might have changed.
+ *	in_name - Name of the entry within *in_dir* which changed. NULL if
+ *		anything within *in_dir* might have changed, i.e. because it was
+ *		created or removed.
+ */
+typedef void (*watch_callback)(
+  void *in_userdata,
+  char const *in_dir,
+  char const *in_name);
+
+/* Function: watch_start()
+ *
+ * Start watching *in_root*, which has to exist and end with '/'.
+ *
+ * Returns:
+ *	false if already watching or if the thread could not be started.
+ */
+bool
+watch_start(
+  char const *in_root,
+  watch_callback in_callback,
+  void *in_userdata);
+
+/* Function: watch_stop()
+ *
+ * Stop watching. The callback is not called anymore once this returns.
+ */
+void
+watch_stop(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,446 @@
+#include "zipfs.h"
+
+#include "log.h"
+#include "util.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+#include "miniz/miniz.h"
+#pragma GCC diagnostic pop
+
+#include <string.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define UNUSED(X) __pragma(warning(suppress : 4100)) X
+#else
+#define UNUSED(X) __attribute__((unused)) X
+#endif
+
+#pragma GCC diagnostic push
+#ifdef __clang__
+#pragma GCC diagnostic ignored "-Wgnu-zero-variadic-macro-arguments"
+#endif
+#pragma GCC diagnostic ignored "-Wunused-macros"
+
+#define LOG(FMT, ...) LOG_DEBUG("zipfs", FMT, ##__VA_ARGS__)
+#define LOGE(FMT, ...) LOG_ERROR("zipfs", FMT, ##__VA_ARGS__)
+
+#pragma GCC diagnostic pop
+
+// CONFIG
+// ------
+// bytes of a deflated file which are inflated at a time
+#define ZIPFS_BLOCK_SIZE (64 * 1024)
+// inflated blocks kept per zip, the least recently used one is replaced
+#define ZIPFS_CACHED_BLOCKS 64
+
+// no block, i.e. of a file's buffer before it is first filled
+#define NO_BLOCK UINT64_MAX
+
+
+// an inflated block of a file
+struct block
+{
+	char *data;
+	size_t size;
+	// of zipfs.tick, 0 while unused
+	uint64_t used;
+	uint64_t index;
+	mz_uint file;
+	char _padding[4];
+};
+
+
+struct zipfs
+{
+	mz_zip_archive zip;
+	void const *data;
+	size_t size;
+	// guards zip, as miniz records errors in it, and the blocks
+	mtx_t mtx;
+	struct block blocks[ZIPFS_CACHED_BLOCKS];
+	uint64_t tick;
+};
+
+
+struct zipfs_file
+{
+	struct zipfs *zip;
+	// of a stored file within the mapping, NULL if deflated
+	char const *data;
+	uint64_t size;
+	uint64_t position;
+	// the rest is of deflated files only. the inflator, and the bytes it
+	// inflated so far.
+	mz_zip_reader_extract_iter_state *iter;
+	uint64_t inflated;
+	// the block inflated last
+	char *buffer;
+	size_t buffer_size;
+	uint64_t buffer_index;
+	mz_uint index;
+	char _padding[4];
+};
+
+
+// miniz's allocation hooks
+static void *
+zip_realloc(
+  void *UNUSED(opaque),
+  void *in_ptr,
+  size_t in_items,
+  size_t in_size)
+{
+	if (in_size > 0 && in_items > SIZE_MAX / in_size)
+	{
+		return NULL;
+	}
+	return mem_realloc(in_ptr, in_items * in_size);
+}
+
+
+static void *
+zip_alloc(void *in_opaque, size_t in_items, size_t in_size)
+{
+	return zip_realloc(in_opaque, NULL, in_items, in_size);
+}
+
+
+static void
+zip_free(void *UNUSED(opaque), void *in_ptr)
+{
+	mem_free(in_ptr);
+}
+
+
+struct zipfs *
+zipfs_open(char const *in_path)
+{
+	size_t size;
+	void const *data = fsu_mmap(in_path, &size);
+	if (!data)
+	{
+		LOGE("could not map %s", in_path);
+		return NULL;
+	}
+
+	struct zipfs *zip = mem_calloc(1, sizeof *zip);
+	if (!zip)
+	{
+		fsu_munmap(data, size);
+		return NULL;
+	}
+	zip->data = data;
+	zip->size = size;
+	zip->zip.m_pAlloc = zip_alloc;
+	zip->zip.m_pFree = zip_free;
+	zip->zip.m_pRealloc = zip_realloc;
+	// sorts the central directory, thusly files are found by bisection
+	if (!mz_zip_reader_init_mem(&zip->zip, data, size, 0))
+	{
+		LOGE("%s is no zip: %i", in_path, zip->zip.m_last_error);
+		fsu_munmap(data, size);
+		mem_free(zip);
+		return NULL;
+	}
+	mtx_init(&zip->mtx, mtx_plain);
+	LOG("%s contains %u files",
+	  in_path,
+	  mz_zip_reader_get_num_files(&zip->zip));
+	return zip;
+}
+
+
+void
+zipfs_close(struct zipfs *in_zip)
+{
+	if (!in_zip)
+	{
+		return;
+	}
+	for (size_t i = 0; i < ZIPFS_CACHED_BLOCKS; ++i)
+	{
+		mem_free(in_zip->blocks[i].data);
+	}
+	mz_zip_reader_end(&in_zip->zip);
+	mtx_destroy(&in_zip->mtx);
+	fsu_munmap(in_zip->data, in_zip->size);
+	mem_free(in_zip);
+}
+
+
+// restarts inflating the file from its start, since a deflate stream
+// cannot be entered in the middle. locks the zip.
+static bool
+restart(struct zipfs_file *io_file)
+{
+	struct zipfs *zip = io_file->zip;
+	mtx_lock(&zip->mtx);
+	if (io_file->iter)
+	{
+		mz_zip_reader_extract_iter_free(io_file->iter);
+	}
+	io_file->iter =
+	  mz_zip_reader_extract_iter_new(&zip->zip, io_file->index, 0);
+	mtx_unlock(&zip->mtx);
+	io_file->inflated = 0;
+	return io_file->iter != NULL;
+}
+
+
+struct zipfs_file *
+zipfs_file_open(struct zipfs *in_zip, char const *in_name)
+{
+	mtx_lock(&in_zip->mtx);
+	int const index =
+	  mz_zip_reader_locate_file(&in_zip->zip, in_name, NULL, 0);
+	mz_zip_archive_file_stat stat;
+	if (index < 0 ||
+	  !mz_zip_reader_file_stat(&in_zip->zip, (mz_uint)index, &stat))
+	{
+		mtx_unlock(&in_zip->mtx);
+		return NULL;
+	}
+	mtx_unlock(&in_zip->mtx);
+	if (stat.m_is_directory)
+	{
+		return NULL;
+	}
+	if (stat.m_method != 0 && stat.m_method != MZ_DEFLATED)
+	{
+		LOGE("cannot read %s, method %u", in_name, stat.m_method);
+		return NULL;
+	}
+
+	struct zipfs_file *file = mem_calloc(1, sizeof *file);
+	if (!file)
+	{
+		return NULL;
+	}
+	file->zip = in_zip;
+	file->size = stat.m_uncomp_size;
+	file->index = (mz_uint)index;
+	file->buffer_index = NO_BLOCK;
+	// which also checks the local header and the bounds of the data
+	if (!restart(file))
+	{
+		LOGE("%s is corrupt", in_name);
+		zipfs_file_close(file);
+		return NULL;
+	}
+	if (stat.m_method == 0)
+	{
+		// in a zip in memory miniz reads straight from it
+		file->data = file->iter->pRead_buf;
+		mtx_lock(&in_zip->mtx);
+		mz_zip_reader_extract_iter_free(file->iter);
+		mtx_unlock(&in_zip->mtx);
+		file->iter = NULL;
+	}
+	return file;
+}
+
+
+void
+zipfs_file_close(struct zipfs_file *in_file)
+{
+	if (!in_file)
+	{
+		return;
+	}
+	if (in_file->iter)
+	{
+		mtx_lock(&in_file->zip->mtx);
+		mz_zip_reader_extract_iter_free(in_file->iter);
+		mtx_unlock(&in_file->zip->mtx);
+	}
+	mem_free(in_file->buffer);
+	mem_free(in_file);
+}
+
+
+// copies from the cached block of the file, if there is one. returns the
+// bytes copied, 0 if the block is not cached.
+static size_t
+copy_cached(
+  struct zipfs_file *in_file,
+  uint64_t in_index,
+  size_t in_offset,
+  void *out_data,
+  size_t in_bytes)
+{
+	struct zipfs *zip = in_file->zip;
+	size_t copied = 0;
+	mtx_lock(&zip->mtx);
+	for (size_t i = 0; i < ZIPFS_CACHED_BLOCKS; ++i)
+	{
+		struct block *block = &zip->blocks[i];
+		if (block->used && block->file == in_file->index &&
+		  block->index == in_index)
+		{
+			block->used = ++zip->tick;
+			copied = block->size - in_offset;
+			copied = copied < in_bytes ? copied : in_bytes;
+			memcpy(out_data, block->data + in_offset, copied);
+			break;
+		}
+	}
+	mtx_unlock(&zip->mtx);
+	return copied;
+}
+
+
+// adds the file's buffer to the cache, in place of the least recently used
+// block
+static void
+cache_buffer(struct zipfs_file const *in_file)
+{
+	struct zipfs *zip = in_file->zip;
+	mtx_lock(&zip->mtx);
+	struct block *lru = &zip->blocks[0];
+	for (size_t i = 0; i < ZIPFS_CACHED_BLOCKS; ++i)
+	{
+		struct block *block = &zip->blocks[i];
+		if (block->used && block->file == in_file->index &&
+		  block->index == in_file->buffer_index)
+		{
+			// cached by another file meanwhile
+			lru = NULL;
+			break;
+		}
+		if (block->used < lru->used)
+		{
+			lru = block;
+		}
+	}
+	if (lru && !lru->data)
+	{
+		lru->data = mem_alloc(ZIPFS_BLOCK_SIZE);
+	}
+	if (lru && lru->data)
+	{
+		memcpy(lru->data, in_file->buffer, in_file->buffer_size);
+		lru->size = in_file->buffer_size;
+		lru->used = ++zip->tick;
+		lru->index = in_file->buffer_index;
+		lru->file = in_file->index;
+	}
+	mtx_unlock(&zip->mtx);
+}
+
+
+// inflates the file up to and including the block *in_index* into its
+// buffer, caching the blocks on the way
+static bool
+inflate_block(struct zipfs_file *io_file, uint64_t in_index)
+{
+	uint64_t const start = in_index * ZIPFS_BLOCK_SIZE;
+	if (io_file->inflated > start && !restart(io_file))
+	{
+		return false;
+	}
+	if (!io_file->buffer)
+	{
+		io_file->buffer = mem_alloc(ZIPFS_BLOCK_SIZE);
+		if (!io_file->buffer)
+		{
+			return false;
+		}
+	}
+	while (io_file->inflated <= start)
+	{
+		uint64_t const left = io_file->size - io_file->inflated;
+		size_t const bytes =
+		  left < ZIPFS_BLOCK_SIZE ? (size_t)left : ZIPFS_BLOCK_SIZE;
+		// the inflator is the file's own, the zip is only read
+		if (mz_zip_reader_extract_iter_read(
+		      io_file->iter,
+		      io_file->buffer,
+		      bytes) != bytes)
+		{
+			io_file->buffer_index = NO_BLOCK;
+			return false;
+		}
+		io_file->buffer_index = io_file->inflated / ZIPFS_BLOCK_SIZE;
+		io_file->buffer_size = bytes;
+		io_file->inflated += bytes;
+		cache_buffer(io_file);
+	}
+	return true;
+}
+
+
+size_t
+zipfs_file_read(struct zipfs_file *in_file, void *out_data, size_t in_bytes)
+{
+	uint64_t const left = in_file->size - in_file->position;
+	size_t const bytes = left < in_bytes ? (size_t)left : in_bytes;
+	if (in_file->data)
+	{
+		memcpy(out_data, in_file->data + in_file->position, bytes);
+		in_file->position += bytes;
+		return bytes;
+	}
+
+	char *out = out_data;
+	size_t done = 0;
+	while (done < bytes)
+	{
+		uint64_t const index = in_file->position / ZIPFS_BLOCK_SIZE;
+		size_t const offset = (size_t)(in_file->position % ZIPFS_BLOCK_SIZE);
+		size_t copied = 0;
+		if (index == in_file->buffer_index)
+		{
+			copied = in_file->buffer_size - offset;
+			copied = copied < bytes - done ? copied : bytes - done;
+			memcpy(out + done, in_file->buffer + offset, copied);
+		}
+		else if (!(copied = copy_cached(
+		             in_file,
+		             index,
+		             offset,
+		             out + done,
+		             bytes - done)) &&
+		  !inflate_block(in_file, index))
+		{
+			LOGE("could not inflate file %u", in_file->index);
+			break;
+		}
+		done += copied;
+		in_file->position += copied;
+	}
+	return done;
+}
+
+
+bool
+zipfs_file_seek(struct zipfs_file *in_file, uint64_t in_position)
+{
+	if (in_position > in_file->size)
+	{
+		return false;
+	}
+	in_file->position = in_position;
+	return true;
+}
+
+
+uint64_t
+zipfs_file_tell(struct zipfs_file const *in_file)
+{
+	return in_file->position;
+}
+
+
+uint64_t
+zipfs_file_size(struct zipfs_file const *in_file)
+{
+	return in_file->size;
+}
+
+
+void const *
+zipfs_file_data(struct zipfs_file const *in_file)
+{
+	return in_file->data;
+}
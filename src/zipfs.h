@@ -0,0 +1,113 @@
+// vi: filetype=c
+#pragma once
+#ifndef MINIMOD_ZIPFS_H_INCLUDED
+#define MINIMOD_ZIPFS_H_INCLUDED
+
+/* Title: zipfs
+ *
+ * Topic: Introduction
+ *
+ * Reads the files within a zip without extracting it. The zip is mapped
+ * into memory and its central directory is read once when it is opened.
+ * Stored files are read straight from the mapping. Deflated files are
+ * inflated block by block as they are read, and the blocks are kept in a
+ * cache shared by all files of the zip, so that seeking back does not
+ * inflate a file from its start again.
+ *
+ * A zip may be used from several threads at once, a single file may not.
+ */
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Section: API */
+
+struct zipfs;
+struct zipfs_file;
+
+/* Function: zipfs_open()
+ *
+ * Returns:
+ *	NULL if *in_path* cannot be mapped or is not a zip.
+ */
+struct zipfs *
+zipfs_open(char const *in_path);
+
+/* Function: zipfs_close()
+ *
+ * All files of the zip have to be closed before.
+ */
+void
+zipfs_close(struct zipfs *in_zip);
+
+/* Function: zipfs_file_open()
+ *
+ * Parameters:
+ *	in_name - Path of the file within the zip, using '/', the case does
+ *		not matter.
+ *
+ * Returns:
+ *	NULL if there is no such file, or if it is neither stored nor
+ *	deflated.
+ */
+struct zipfs_file *
+zipfs_file_open(struct zipfs *in_zip, char const *in_name);
+
+/* Function: zipfs_file_close()
+ */
+void
+zipfs_file_close(struct zipfs_file *in_file);
+
+/* Function: zipfs_file_read()
+ *
+ * Read up to *in_bytes* from the current position, which advances past
+ * them.
+ *
+ * Returns:
+ *	The bytes read, less than *in_bytes* at the end of the file or if
+ *	the file is corrupt.
+ */
+size_t
+zipfs_file_read(struct zipfs_file *in_file, void *out_data, size_t in_bytes);
+
+/* Function: zipfs_file_seek()
+ *
+ * Set the current position, which may be the size of the file at most.
+ */
+bool
+zipfs_file_seek(struct zipfs_file *in_file, uint64_t in_position);
+
+/* Function: zipfs_file_tell()
+ */
+uint64_t
+zipfs_file_tell(struct zipfs_file const *in_file);
+
+/* Function: zipfs_file_size()
+ *
+ * Returns:
+ *	The uncompressed size.
+ */
+uint64_t
+zipfs_file_size(struct zipfs_file const *in_file);
+
+/* Function: zipfs_file_data()
+ *
+ * Returns:
+ *	The contents of a stored file within the mapping of the zip, which is
+ *	valid until the zip is closed. NULL if the file is deflated.
+ */
+void const *
+zipfs_file_data(struct zipfs_file const *in_file);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
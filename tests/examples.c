@@ -44,13 +44,26 @@ sys_sleep(uint32_t ms)
 // ===================================================================
 // JUST INIT+DEINIT
 // -------------------------------------------------------------------
+static void
+on_log(void *UNUSED(in_udata), struct minimod_log_message const *in_message)
+{
+	printf(
+	  "  [%s %.3fms] %s\n",
+	  in_message->module,
+	  (double)in_message->time / 1e6,
+	  in_message->text);
+}
+
+
 static void
 test_init(void)
 {
 	printf("\n= Simple init()/deinit() test\n");
+	minimod_set_log(MINIMOD_LOGLEVEL_DEBUG, on_log, NULL);
 	minimod_init(API_KEY_TEST, NULL, 0, MINIMOD_CURRENT_ABI);
 
 	minimod_deinit();
+	minimod_set_log(MINIMOD_LOGLEVEL_ERROR, NULL, NULL);
 }
 
 
@@ -97,6 +110,39 @@ test_get_all_games(void)
 }
 
 
+static void
+test_record_replay(void)
+{
+	printf("\n= Recording and replaying list of live games\n");
+	char const *path = "games.mmtrace";
+
+	// record
+	minimod_set_transport(MINIMOD_TRANSPORT_RECORD, path);
+	minimod_init(API_KEY_LIVE, NULL, 0, MINIMOD_CURRENT_ABI);
+	int nrequests_completed = 0;
+	minimod_get_games(NULL, get_all_games_callback, &nrequests_completed);
+	while (nrequests_completed == 0)
+	{
+		sys_sleep(10);
+	}
+	minimod_deinit();
+
+	// replay without network access
+	printf("== Replay:\n");
+	minimod_set_transport(MINIMOD_TRANSPORT_REPLAY, path);
+	minimod_init(API_KEY_LIVE, NULL, 0, MINIMOD_CURRENT_ABI);
+	nrequests_completed = 0;
+	minimod_get_games(NULL, get_all_games_callback, &nrequests_completed);
+	while (nrequests_completed == 0)
+	{
+		sys_sleep(10);
+	}
+	minimod_deinit();
+
+	minimod_set_transport(MINIMOD_TRANSPORT_NETWORK, NULL);
+}
+
+
 // ===================================================================
 // GET MODS
 // -------------------------------------------------------------------
@@ -117,6 +163,35 @@ on_get_all_mods(
 }
 
 
+static void
+print_stats(enum minimod_endpoint endpoint)
+{
+	static char const *const phases[MINIMOD_PHASE_COUNT] = {
+		"network", "decode", "parse", "populate", "callback", "extract",
+	};
+
+	struct minimod_endpoint_stats stats;
+	minimod_get_stats(endpoint, &stats);
+	printf(
+	  "%" PRIu64 " requests, %" PRIu64 " failed, %" PRIu64 " bytes\n",
+	  stats.nrequests,
+	  stats.nfailed,
+	  stats.nbytes);
+	for (size_t i = 0; i < MINIMOD_PHASE_COUNT; ++i)
+	{
+		struct minimod_histogram const *h = &stats.phases[i];
+		if (h->count > 0)
+		{
+			printf(
+			  "- %-8s avg %" PRIu64 " us, max %" PRIu64 " us\n",
+			  phases[i],
+			  h->total_us / h->count,
+			  h->max_us);
+		}
+	}
+}
+
+
 static void
 test_get_all_mods(uint64_t game_id)
 {
@@ -155,6 +230,42 @@ test_get_all_mods(uint64_t game_id)
 		sys_sleep(10);
 	}
 
+	print_stats(MINIMOD_ENDPOINT_MODS);
+
+	minimod_deinit();
+}
+
+
+// ===================================================================
+// PREWARM
+// -------------------------------------------------------------------
+static void
+test_prewarm(void)
+{
+	printf("\n= Requesting list of mods on a prewarmed connection\n");
+	minimod_init(
+	  API_KEY_TEST,
+	  NULL,
+	  MINIMOD_INITFLAG_TESTENV | MINIMOD_INITFLAG_PREWARM,
+	  MINIMOD_CURRENT_ABI);
+	minimod_prewarm(MINIMOD_PREWARM_DOWNLOAD);
+
+	// give the connections some time to be established
+	sys_sleep(1000);
+
+	int nrequests_completed = 0;
+	minimod_get_mods(
+	  NULL,
+	  GAME_ID_TEST,
+	  0,
+	  on_get_all_mods,
+	  &nrequests_completed);
+
+	while (nrequests_completed < 1)
+	{
+		sys_sleep(10);
+	}
+
 	minimod_deinit();
 }
 
@@ -373,6 +484,21 @@ on_installed(
 }
 
 
+static void
+on_installed_changed(
+  void *UNUSED(in_userdata),
+  uint64_t in_game_id,
+  uint64_t in_mod_id,
+  bool in_installed)
+{
+	printf(
+	  "== mod %" PRIu64 ":%" PRIu64 " %s\n",
+	  in_game_id,
+	  in_mod_id,
+	  in_installed ? "appeared" : "disappeared");
+}
+
+
 static void
 installed_mod_enumerator(
   void *UNUSED(in_userdata),
@@ -384,6 +510,24 @@ installed_mod_enumerator(
 }
 
 
+static void
+on_installed_mods(
+  void *UNUSED(in_userdata),
+  size_t in_nmods,
+  struct minimod_installed_mod const *in_mods)
+{
+	for (size_t i = 0; i < in_nmods; ++i)
+	{
+		printf(
+		  "- %" PRIu64 ":%" PRIu64 " %s (%" PRIu64 " bytes)\n",
+		  in_mods[i].game_id,
+		  in_mods[i].mod_id,
+		  in_mods[i].name,
+		  in_mods[i].filesize);
+	}
+}
+
+
 static void
 on_installed_mod(
   void *in_userdata,
@@ -409,6 +553,12 @@ test_installation(void)
 	  MINIMOD_INITFLAG_TESTENV | MINIMOD_INITFLAG_UNZIP,
 	  MINIMOD_CURRENT_ABI);
 
+	// be told about mods appearing and disappearing, by whomever
+	minimod_watch_installed(on_installed_changed, NULL);
+
+	// record a timeline of the installation
+	minimod_set_tracing(true);
+
 	// install the mod
 	int wait = 1;
 	minimod_install(GAME_ID_TEST, MOD_ID_TEST, 0, on_installed, &wait);
@@ -418,13 +568,23 @@ test_installation(void)
 		sys_sleep(10);
 	}
 
+	minimod_set_tracing(false);
+	printf(
+	  "== Trace written: %s\n",
+	  minimod_write_trace("install-trace.json") ? "YES" : "NO");
+
 	// make sure the mod is installed
 	bool is_installed = minimod_is_installed(GAME_ID_TEST, MOD_ID_TEST);
 	printf("== Mod is installed: %s\n", is_installed ? "YES" : "NO");
+	printf(
+	  "== Installed modfile: %" PRIu64 "\n",
+	  minimod_get_installed_modfile_id(GAME_ID_TEST, MOD_ID_TEST));
 
 	// enum all installed mods
 	printf("== Installed mods:\n");
 	minimod_enum_installed_mods(0, installed_mod_enumerator, NULL);
+	printf("== Installed mods of the game:\n");
+	minimod_get_installed_mods(GAME_ID_TEST, on_installed_mods, NULL);
 
 	// get data for the installed mod
 	printf("== Get installed mods:\n");
@@ -447,6 +607,275 @@ test_installation(void)
 }
 
 
+// ===================================================================
+// MOD FILES
+// -------------------------------------------------------------------
+// of deflated files, as documented with minimod_mod_open()
+#define MOD_CACHED_BYTES (64 * 64 * 1024)
+// not a multiple of the blocks, thusly reads cross their boundaries
+#define MOD_READ_BYTES 100000
+
+struct zip_entry
+{
+	char name[256];
+	uint64_t size;
+};
+
+
+static void
+on_mod_path(
+  void *in_userdata,
+  uint64_t UNUSED(in_game_id),
+  uint64_t in_mod_id,
+  char const *in_path)
+{
+	if (in_mod_id == MOD_ID_TEST)
+	{
+		snprintf(in_userdata, 1024, "%s", in_path);
+	}
+}
+
+
+// installs the test mod below *in_root*, and writes the path of its zip,
+// or of the directory it was extracted to, to *out_path*
+static void
+install_test_mod(char const *in_root, bool in_unzip, char *out_path)
+{
+	minimod_init(
+	  API_KEY_TEST,
+	  in_root,
+	  MINIMOD_INITFLAG_TESTENV | (in_unzip ? MINIMOD_INITFLAG_UNZIP : 0),
+	  MINIMOD_CURRENT_ABI);
+	int wait = 1;
+	minimod_install(GAME_ID_TEST, MOD_ID_TEST, 0, on_installed, &wait);
+	while (wait)
+	{
+		sys_sleep(10);
+	}
+	out_path[0] = '\0';
+	minimod_enum_installed_mods(GAME_ID_TEST, on_mod_path, out_path);
+}
+
+
+static char *
+read_file(char const *in_path, size_t *out_size)
+{
+	FILE *file = fopen(in_path, "rb");
+	if (!file)
+	{
+		return NULL;
+	}
+	fseek(file, 0, SEEK_END);
+	long const size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	char *data = size >= 0 ? malloc((size_t)size + 1) : NULL;
+	if (data && fread(data, 1, (size_t)size, file) != (size_t)size)
+	{
+		free(data);
+		data = NULL;
+	}
+	fclose(file);
+	*out_size = data ? (size_t)size : 0;
+	return data;
+}
+
+
+static uint32_t
+read_le(unsigned char const *in_data, size_t in_bytes)
+{
+	uint32_t value = 0;
+	for (size_t i = in_bytes; i-- > 0;)
+	{
+		value = (value << 8) | in_data[i];
+	}
+	return value;
+}
+
+
+// finds the first stored and the largest deflated file in the central
+// directory of the zip, zip64 aside
+static void
+find_zip_entries(
+  char const *in_path,
+  struct zip_entry *out_stored,
+  struct zip_entry *out_deflated)
+{
+	*out_stored = (struct zip_entry){ 0 };
+	*out_deflated = (struct zip_entry){ 0 };
+	size_t size;
+	unsigned char *zip = (unsigned char *)read_file(in_path, &size);
+	if (!zip || size < 22)
+	{
+		free(zip);
+		return;
+	}
+
+	// the end of central directory record, which a comment may follow
+	size_t end = size - 22;
+	while (end > 0 && read_le(zip + end, 4) != 0x06054b50)
+	{
+		--end;
+	}
+	size_t const nentries = read_le(zip + end + 10, 2);
+	size_t offset = read_le(zip + end + 16, 4);
+	for (size_t i = 0; i < nentries && offset + 46 <= size; ++i)
+	{
+		unsigned char const *header = zip + offset;
+		uint32_t const method = read_le(header + 10, 2);
+		uint64_t const uncompressed = read_le(header + 24, 4);
+		size_t const nname = read_le(header + 28, 2);
+		offset += 46 + nname + read_le(header + 30, 2) +
+		  read_le(header + 32, 2);
+		// skips directories
+		if (read_le(header, 4) != 0x02014b50 || offset > size ||
+		  nname == 0 || nname >= sizeof out_stored->name ||
+		  header[46 + nname - 1] == '/')
+		{
+			continue;
+		}
+
+		struct zip_entry *entry = NULL;
+		if (method == 0 && out_stored->size == 0 && uncompressed > 0)
+		{
+			entry = out_stored;
+		}
+		else if (method == 8 && uncompressed > out_deflated->size)
+		{
+			entry = out_deflated;
+		}
+		if (entry)
+		{
+			memcpy(entry->name, header + 46, nname);
+			entry->name[nname] = '\0';
+			entry->size = uncompressed;
+		}
+	}
+	free(zip);
+}
+
+
+// reads up to MOD_READ_BYTES at *in_position* of the file and compares
+// them with the extracted file
+static bool
+compare_at(
+  struct minimod_modfs_file *in_file,
+  char const *in_expected,
+  size_t in_size,
+  size_t in_position)
+{
+	static char buffer[MOD_READ_BYTES];
+	size_t const left = in_size - in_position;
+	size_t const bytes = left < sizeof buffer ? left : sizeof buffer;
+	return minimod_mod_file_seek(in_file, in_position) &&
+	  minimod_mod_file_read(in_file, buffer, sizeof buffer) == bytes &&
+	  memcmp(buffer, in_expected + in_position, bytes) == 0 &&
+	  minimod_mod_file_tell(in_file) == in_position + bytes;
+}
+
+
+static void
+test_mod_file(
+  struct minimod_modfs *in_mod,
+  char const *in_dir,
+  struct zip_entry const *in_entry,
+  bool in_deflated)
+{
+	char path[1024];
+	snprintf(path, sizeof path, "%s%s", in_dir, in_entry->name);
+	size_t size;
+	char *expected = read_file(path, &size);
+	struct minimod_modfs_file *file =
+	  minimod_mod_file_open(in_mod, in_entry->name);
+	bool same = expected && file && minimod_mod_file_size(file) == size;
+
+	if (same && !in_deflated)
+	{
+		void const *data = minimod_mod_file_data(file);
+		same = data && memcmp(data, expected, size) == 0;
+	}
+	// front to back, which leaves the last blocks of a deflated file cached
+	for (size_t i = 0; same && i < size; i += MOD_READ_BYTES)
+	{
+		same = compare_at(file, expected, size, i);
+	}
+	// back to the start, which has to be inflated again once it is no
+	// longer cached, then to the middle and the end
+	same = same && compare_at(file, expected, size, 0) &&
+	  compare_at(file, expected, size, size / 2 + 1) &&
+	  compare_at(file, expected, size, size - size / 8) &&
+	  compare_at(file, expected, size, size) &&
+	  !minimod_mod_file_seek(file, (uint64_t)size + 1);
+
+	printf(
+	  "== %s %s: %zu bytes, %s\n",
+	  in_deflated ? "Deflated" : "Stored",
+	  in_entry->name,
+	  size,
+	  same ? "same as extracted" : "DIFFERENT");
+	if (in_deflated)
+	{
+		printf(
+		  "== Seeked back past the cached blocks: %s\n",
+		  size > MOD_CACHED_BYTES ? "YES" : "NO, the file is too small");
+	}
+	minimod_mod_file_close(file);
+	free(expected);
+}
+
+
+static void
+test_mod_files(void)
+{
+	printf("\n= Reading files of an installed mod\n");
+
+	// extracted, to compare with
+	char dir[1024];
+	install_test_mod("modfs-unzip", true, dir);
+	struct minimod_modfs *mod = minimod_mod_open(GAME_ID_TEST, MOD_ID_TEST);
+	printf("== Extracted mod opened: %s\n", mod ? "YES" : "NO");
+	minimod_mod_close(mod);
+	minimod_deinit();
+
+	char zip[1024];
+	install_test_mod("modfs", false, zip);
+	mod = minimod_mod_open(GAME_ID_TEST, MOD_ID_TEST);
+	printf("== Mod opened: %s\n", mod ? "YES" : "NO");
+	if (mod)
+	{
+		struct zip_entry stored;
+		struct zip_entry deflated;
+		find_zip_entries(zip, &stored, &deflated);
+		if (stored.size > 0)
+		{
+			test_mod_file(mod, dir, &stored, false);
+		}
+		else
+		{
+			printf("== The mod stores no file\n");
+		}
+		if (deflated.size > 0)
+		{
+			test_mod_file(mod, dir, &deflated, true);
+		}
+		else
+		{
+			printf("== The mod deflates no file\n");
+		}
+		minimod_mod_close(mod);
+	}
+	minimod_uninstall(GAME_ID_TEST, MOD_ID_TEST);
+	minimod_deinit();
+
+	minimod_init(
+	  API_KEY_TEST,
+	  "modfs-unzip",
+	  MINIMOD_INITFLAG_TESTENV | MINIMOD_INITFLAG_UNZIP,
+	  MINIMOD_CURRENT_ABI);
+	minimod_uninstall(GAME_ID_TEST, MOD_ID_TEST);
+	minimod_deinit();
+}
+
+
 // ===================================================================
 // RATINGS
 // -------------------------------------------------------------------
@@ -689,6 +1118,311 @@ test_dependencies(void)
 }
 
 
+// ===================================================================
+// CUSTOM ALLOCATOR
+// -------------------------------------------------------------------
+struct allocations
+{
+	size_t count;
+	size_t live;
+};
+
+
+static void *
+counting_alloc(void *in_udata, size_t in_bytes)
+{
+	struct allocations *a = in_udata;
+	__atomic_add_fetch(&a->count, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&a->live, 1, __ATOMIC_RELAXED);
+	return malloc(in_bytes);
+}
+
+
+static void *
+counting_realloc(void *in_udata, void *in_ptr, size_t in_bytes)
+{
+	struct allocations *a = in_udata;
+	__atomic_add_fetch(&a->count, 1, __ATOMIC_RELAXED);
+	if (!in_ptr)
+	{
+		__atomic_add_fetch(&a->live, 1, __ATOMIC_RELAXED);
+	}
+	return realloc(in_ptr, in_bytes);
+}
+
+
+static void
+counting_free(void *in_udata, void *in_ptr)
+{
+	struct allocations *a = in_udata;
+	if (in_ptr)
+	{
+		__atomic_sub_fetch(&a->live, 1, __ATOMIC_RELAXED);
+	}
+	free(in_ptr);
+}
+
+
+static void
+test_allocator(void)
+{
+	printf("\n= Custom allocator:\n");
+	struct allocations a = { 0 };
+	minimod_set_allocator(counting_alloc, counting_realloc, counting_free, &a);
+	test_get_all_games();
+	printf("  %zu allocations, %zu not freed\n", a.count, a.live);
+	minimod_set_allocator(NULL, NULL, NULL, NULL);
+}
+
+
+// ===================================================================
+// BATCHES
+// -------------------------------------------------------------------
+static void
+on_get_mods_batch(
+  void *udata,
+  size_t nmods,
+  struct minimod_mod const *mods,
+  struct minimod_pagination const *pagi)
+{
+	printf("  batch of %zu mods", nmods);
+	if (nmods > 0)
+	{
+		printf(", starting with '%s'", mods[0].name);
+	}
+	printf("\n");
+
+	// the last call carries the pagination, as does the only call of a
+	// failed request
+	if (pagi || nmods == 0)
+	{
+		++(*(int *)udata);
+	}
+}
+
+
+static void
+test_batches(void)
+{
+	printf("\n= Requesting list of mods in batches of 5\n");
+	minimod_init(
+	  API_KEY_TEST,
+	  NULL,
+	  MINIMOD_INITFLAG_TESTENV,
+	  MINIMOD_CURRENT_ABI);
+	minimod_set_batch_size(5);
+
+	int nrequests_completed = 0;
+	minimod_get_mods(
+	  "_limit=20",
+	  GAME_ID_TEST,
+	  0,
+	  on_get_mods_batch,
+	  &nrequests_completed);
+
+	while (nrequests_completed < 1)
+	{
+		sys_sleep(10);
+	}
+
+	// minimod's own requests are not batched, so installing is unaffected
+	printf("== Installing Mod in batch mode\n");
+	minimod_set_batch_size(1);
+	int wait = 1;
+	minimod_install(GAME_ID_TEST, MOD_ID_TEST, 0, on_installed, &wait);
+	while (wait)
+	{
+		sys_sleep(10);
+	}
+	minimod_uninstall(GAME_ID_TEST, MOD_ID_TEST);
+
+	minimod_set_batch_size(0);
+	minimod_deinit();
+}
+
+
+// ===================================================================
+// RETAIN
+// -------------------------------------------------------------------
+static void
+on_get_mods_retain(
+  void *udata,
+  size_t nmods,
+  struct minimod_mod const *mods,
+  struct minimod_pagination const *UNUSED(pagi))
+{
+	struct minimod_mod *kept = udata;
+	if (nmods > 0 && minimod_retain(mods[0].more))
+	{
+		*kept = mods[0];
+	}
+	else
+	{
+		kept->id = UINT64_MAX;
+	}
+}
+
+
+static void
+test_retain(void)
+{
+	printf("\n= Keeping a mod after its callback returned\n");
+	minimod_init(
+	  API_KEY_TEST,
+	  NULL,
+	  MINIMOD_INITFLAG_TESTENV,
+	  MINIMOD_CURRENT_ABI);
+
+	struct minimod_mod mod = { 0 };
+	minimod_get_mods(NULL, GAME_ID_TEST, 0, on_get_mods_retain, &mod);
+
+	while (mod.id == 0)
+	{
+		sys_sleep(10);
+	}
+
+	if (mod.id != UINT64_MAX)
+	{
+		struct minimod_path *logo = minimod_path_compile("logo.thumb_320x180");
+		printf(
+		  "  %s: %s\n  %s\n  %s\n",
+		  mod.name,
+		  mod.summary,
+		  minimod_get_more_string(mod.more, "profile_url"),
+		  minimod_path_get_string(mod.more, logo));
+		minimod_path_free(logo);
+		minimod_release(mod.more);
+	}
+
+	minimod_deinit();
+}
+
+
+// ===================================================================
+// PATHS
+// -------------------------------------------------------------------
+static void
+print_path(void const *in_more, char const *in_path)
+{
+	struct minimod_path *path = minimod_path_compile(in_path);
+	if (!path)
+	{
+		printf("  %s: invalid\n", in_path);
+		return;
+	}
+	char const *string = minimod_path_get_string(in_more, path);
+	printf("  %s: %s\n", in_path, string ? string : "(none)");
+	minimod_path_free(path);
+}
+
+
+static void
+test_paths(void)
+{
+	printf("\n= Looking up nested data by paths\n");
+	minimod_init(
+	  API_KEY_TEST,
+	  NULL,
+	  MINIMOD_INITFLAG_TESTENV,
+	  MINIMOD_CURRENT_ABI);
+
+	struct minimod_mod mod = { 0 };
+	minimod_get_mods(NULL, GAME_ID_TEST, 0, on_get_mods_retain, &mod);
+
+	while (mod.id == 0)
+	{
+		sys_sleep(10);
+	}
+
+	if (mod.id != UINT64_MAX)
+	{
+		// objects and array elements
+		print_path(mod.more, "logo.original");
+		print_path(mod.more, "modfile.filehash.md5");
+		print_path(mod.more, "tags[0].name");
+		print_path(mod.more, "tags[1000].name");
+
+		// the path does not match the data, which is no error
+		print_path(mod.more, "name.original");
+		print_path(mod.more, "logo[0]");
+		print_path(mod.more, "tags.name");
+		print_path(mod.more, "modfile.id.x");
+
+		// invalid paths
+		print_path(mod.more, "");
+		print_path(mod.more, "logo.");
+		print_path(mod.more, "tags[x]");
+		print_path(mod.more, "tags[0");
+
+		struct minimod_path *size = minimod_path_compile("modfile.filesize");
+		printf(
+		  "  modfile.filesize: %" PRIi64 "\n",
+		  minimod_path_get_int(mod.more, size));
+		minimod_path_free(size);
+
+		minimod_release(mod.more);
+	}
+
+	minimod_deinit();
+}
+
+
+// ===================================================================
+// COLUMNS
+// -------------------------------------------------------------------
+static void
+on_get_mods_columns(
+  void *udata,
+  struct minimod_mod_columns const *mods,
+  struct minimod_pagination const *UNUSED(pagi))
+{
+	size_t best = 0;
+	for (size_t i = 1; i < mods->count; ++i)
+	{
+		if (mods->ndownloads[i] > mods->ndownloads[best])
+		{
+			best = i;
+		}
+	}
+	if (mods->count > 0)
+	{
+		printf(
+		  "  most downloaded of %zu: %s (%" PRIu64 " downloads)\n",
+		  mods->count,
+		  mods->name[best],
+		  mods->ndownloads[best]);
+	}
+
+	++(*(int *)udata);
+}
+
+
+static void
+test_mods_columns(void)
+{
+	printf("\n= Requesting list of mods as columns\n");
+	minimod_init(
+	  API_KEY_TEST,
+	  NULL,
+	  MINIMOD_INITFLAG_TESTENV,
+	  MINIMOD_CURRENT_ABI);
+
+	int nrequests_completed = 0;
+	minimod_get_mods_columns(
+	  NULL,
+	  GAME_ID_TEST,
+	  on_get_mods_columns,
+	  &nrequests_completed);
+
+	while (nrequests_completed < 1)
+	{
+		sys_sleep(10);
+	}
+
+	minimod_deinit();
+}
+
+
 int
 main(void)
 {
@@ -696,16 +1430,24 @@ main(void)
 
 	test_init();
 	test_get_all_games();
+	test_record_replay();
 	test_get_all_mods(1);
+	test_prewarm();
 	test_authentication();
 	test_me();
 	test_get_modfiles();
 	test_installation();
+	test_mod_files();
 	test_rating();
 	test_subscription();
 	test_mod_events();
 	test_user_events();
 	test_dependencies();
+	test_allocator();
+	test_batches();
+	test_retain();
+	test_paths();
+	test_mods_columns();
 
 	printf("[test] Done\n");
 
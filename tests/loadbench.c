@@ -0,0 +1,274 @@
+// Drives minimod with concurrent callers against tests/mockserver.c and
+// reports throughput, latency percentiles, CPU time and peak RSS.
+//
+// usage: loadbench <endpoint> [callers] [requests] [installs]
+//
+// Every caller issues its share of *requests* minimod_get_mods() calls,
+// waiting for each callback before the next call, then its share of
+// *installs* minimod_install() + minimod_uninstall() round-trips.
+
+#include "minimod/minimod.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define UNUSED(X) __pragma(warning(suppress : 4100)) X
+#else
+#define UNUSED(X) __attribute__((unused)) X
+#endif
+
+// CONFIG
+// ------
+// any well-formed key is accepted by the mock server
+#define API_KEY "00000000000000000000000000000000"
+#define ROOT_PATH "_loadbench"
+#define GAME_ID 1
+// needs to match mockserver's number of mods
+#define NMODS 1000
+
+
+struct caller
+{
+	pthread_mutex_t mtx;
+	pthread_cond_t cond;
+	pthread_t thread;
+	uint64_t *latencies;
+	size_t nlatencies;
+	uint64_t start;
+	size_t count;
+	size_t first_mod;
+	bool done;
+	bool failed;
+	char _padding[6];
+};
+
+
+static uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+
+static double
+cpu_seconds(void)
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return (double)usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+	  (double)usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+
+static double
+peak_rss_mib(void)
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+	return (double)usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+	return (double)usage.ru_maxrss / 1024.0;
+#endif
+}
+
+
+static void
+finish(struct caller *c, bool success)
+{
+	uint64_t const end = now_ns();
+	pthread_mutex_lock(&c->mtx);
+	c->latencies[c->nlatencies++] = end - c->start;
+	c->failed |= !success;
+	c->done = true;
+	pthread_cond_signal(&c->cond);
+	pthread_mutex_unlock(&c->mtx);
+}
+
+
+static void
+wait_done(struct caller *c)
+{
+	pthread_mutex_lock(&c->mtx);
+	while (!c->done)
+	{
+		pthread_cond_wait(&c->cond, &c->mtx);
+	}
+	c->done = false;
+	pthread_mutex_unlock(&c->mtx);
+}
+
+
+static void
+on_get_mods(
+  void *in_udata,
+  size_t in_nmods,
+  struct minimod_mod const *UNUSED(mods),
+  struct minimod_pagination const *UNUSED(pagi))
+{
+	finish(in_udata, in_nmods > 0);
+}
+
+
+static void *
+run_requests(void *in_caller)
+{
+	struct caller *c = in_caller;
+	for (size_t i = 0; i < c->count; ++i)
+	{
+		c->start = now_ns();
+		minimod_get_mods(NULL, GAME_ID, 0, on_get_mods, c);
+		wait_done(c);
+	}
+	return NULL;
+}
+
+
+static void
+on_installed(
+  void *in_udata,
+  bool in_success,
+  uint64_t UNUSED(game_id),
+  uint64_t UNUSED(mod_id))
+{
+	finish(in_udata, in_success);
+}
+
+
+static void *
+run_installs(void *in_caller)
+{
+	struct caller *c = in_caller;
+	for (size_t i = 0; i < c->count; ++i)
+	{
+		// callers use distinct ranges of mods, so that they never
+		// install the same one at the same time
+		uint64_t const mod_id = 1 + (c->first_mod + i) % NMODS;
+		c->start = now_ns();
+		minimod_install(GAME_ID, mod_id, 0, on_installed, c);
+		wait_done(c);
+		minimod_uninstall(GAME_ID, mod_id);
+	}
+	return NULL;
+}
+
+
+static int
+compare_u64(void const *a, void const *b)
+{
+	uint64_t const x = *(uint64_t const *)a;
+	uint64_t const y = *(uint64_t const *)b;
+	return (x > y) - (x < y);
+}
+
+
+static bool
+run_phase(
+  char const *in_name,
+  void *(*in_func)(void *),
+  size_t in_ncallers,
+  size_t in_total)
+{
+	if (in_total == 0)
+	{
+		return true;
+	}
+
+	struct caller *callers = calloc(in_ncallers, sizeof *callers);
+	uint64_t *latencies = calloc(in_total, sizeof *latencies);
+	size_t offset = 0;
+	for (size_t i = 0; i < in_ncallers; ++i)
+	{
+		struct caller *c = &callers[i];
+		c->count = in_total / in_ncallers + (i < in_total % in_ncallers);
+		c->latencies = latencies + offset;
+		c->first_mod = offset;
+		offset += c->count;
+		pthread_mutex_init(&c->mtx, NULL);
+		pthread_cond_init(&c->cond, NULL);
+	}
+
+	double const cpu_start = cpu_seconds();
+	uint64_t const start = now_ns();
+	for (size_t i = 0; i < in_ncallers; ++i)
+	{
+		pthread_create(&callers[i].thread, NULL, in_func, &callers[i]);
+	}
+	bool failed = false;
+	for (size_t i = 0; i < in_ncallers; ++i)
+	{
+		pthread_join(callers[i].thread, NULL);
+		failed |= callers[i].failed;
+		pthread_mutex_destroy(&callers[i].mtx);
+		pthread_cond_destroy(&callers[i].cond);
+	}
+	double const seconds = (double)(now_ns() - start) / 1e9;
+	double const cpu = cpu_seconds() - cpu_start;
+
+	qsort(latencies, in_total, sizeof *latencies, compare_u64);
+	printf(
+	  "%-9s %7zu in %7.3fs  %9.1f/s  %9.1f/min  "
+	  "p50 %8.3fms  p99 %8.3fms  max %8.3fms  cpu %7.3fs%s\n",
+	  in_name,
+	  in_total,
+	  seconds,
+	  (double)in_total / seconds,
+	  (double)in_total / seconds * 60.0,
+	  (double)latencies[in_total / 2] / 1e6,
+	  (double)latencies[in_total * 99 / 100] / 1e6,
+	  (double)latencies[in_total - 1] / 1e6,
+	  cpu,
+	  failed ? "  (FAILURES)" : "");
+
+	free(latencies);
+	free(callers);
+	return !failed;
+}
+
+
+int
+main(int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		fprintf(
+		  stderr,
+		  "usage: %s <endpoint> [callers] [requests] [installs]\n",
+		  argv[0]);
+		return 2;
+	}
+	size_t const ncallers = argc > 2 ? strtoul(argv[2], NULL, 10) : 8;
+	size_t const nrequests = argc > 3 ? strtoul(argv[3], NULL, 10) : 2000;
+	size_t const ninstalls = argc > 4 ? strtoul(argv[4], NULL, 10) : 100;
+	if (ncallers == 0)
+	{
+		return 2;
+	}
+
+	minimod_set_endpoint(argv[1]);
+	if (minimod_init(
+	      API_KEY,
+	      ROOT_PATH,
+	      MINIMOD_INITFLAG_UNZIP,
+	      MINIMOD_CURRENT_ABI) != MINIMOD_ERR_OK)
+	{
+		fprintf(stderr, "minimod_init() failed\n");
+		return 1;
+	}
+
+	printf("%s, %zu callers\n", argv[1], ncallers);
+	bool ok = run_phase("get_mods", run_requests, ncallers, nrequests);
+	ok &= run_phase("install", run_installs, ncallers, ninstalls);
+	printf("peak RSS %.1f MiB\n", peak_rss_mib());
+
+	minimod_deinit();
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,455 @@
+// Local stand-in for the mod.io API, serving synthetic games, mods,
+// modfiles and zip payloads over plain HTTP/1.1 for tests/loadbench.c
+//
+// usage: mockserver [port] [nmods] [zip-kib]
+//
+// Only the routes minimod uses for listing and installing mods exist:
+//	/v1/games
+//	/v1/games/{game}/mods
+//	/v1/games/{game}/mods/{mod}
+//	/v1/games/{game}/mods/{mod}/files
+//	/v1/games/{game}/mods/{mod}/files/{modfile}
+//	/files/{game}/{mod}.zip
+// Query parameters are ignored. Every connection is served by its own
+// thread, with keep-alive.
+
+#include "miniz.h"
+
+#include <arpa/inet.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// CONFIG
+// ------
+#define DEFAULT_PORT 8977
+#define DEFAULT_NMODS 1000
+#define DEFAULT_ZIP_KIB 256
+#define MAX_REQUEST 8192
+#define DATE 1570000000
+
+
+struct buffer
+{
+	char *data;
+	size_t len;
+	size_t capacity;
+};
+
+
+static struct
+{
+	int port;
+	uint64_t nmods;
+	// the same payload is served for every mod
+	void *zip;
+	size_t nzip;
+} l_mock;
+
+
+static void
+append(struct buffer *buf, char const *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	va_list copy;
+	va_copy(copy, args);
+	int const n = vsnprintf(NULL, 0, fmt, copy);
+	va_end(copy);
+
+	if (buf->len + (size_t)n + 1 > buf->capacity)
+	{
+		buf->capacity = (buf->len + (size_t)n + 1) * 2;
+		buf->data = realloc(buf->data, buf->capacity);
+	}
+	vsnprintf(buf->data + buf->len, (size_t)n + 1, fmt, args);
+	buf->len += (size_t)n;
+	va_end(args);
+}
+
+
+static void
+append_game(struct buffer *buf, uint64_t game_id)
+{
+	append(
+	  buf,
+	  "{\"id\":%" PRIu64 ",\"status\":1,\"date_added\":%d,"
+	  "\"name\":\"Game %" PRIu64 "\",\"name_id\":\"game%" PRIu64 "\"}",
+	  game_id,
+	  DATE,
+	  game_id,
+	  game_id);
+}
+
+
+static void
+append_modfile(struct buffer *buf, uint64_t game_id, uint64_t mod_id)
+{
+	append(
+	  buf,
+	  "{\"id\":%" PRIu64 ",\"mod_id\":%" PRIu64 ",\"date_added\":%d,"
+	  "\"filesize\":%zu,\"filename\":\"mod%" PRIu64 ".zip\","
+	  "\"filehash\":{\"md5\":\"00000000000000000000000000000000\"},"
+	  "\"download\":{\"binary_url\":"
+	  "\"http://127.0.0.1:%d/files/%" PRIu64 "/%" PRIu64 ".zip\","
+	  "\"date_expires\":%d}}",
+	  mod_id,
+	  mod_id,
+	  DATE,
+	  l_mock.nzip,
+	  mod_id,
+	  l_mock.port,
+	  game_id,
+	  mod_id,
+	  DATE + 3600);
+}
+
+
+static void
+append_mod(struct buffer *buf, uint64_t game_id, uint64_t mod_id)
+{
+	append(
+	  buf,
+	  "{\"id\":%" PRIu64 ",\"game_id\":%" PRIu64 ",\"status\":1,"
+	  "\"date_added\":%d,\"date_updated\":%d,"
+	  "\"name\":\"Mod %" PRIu64 "\",\"name_id\":\"mod%" PRIu64 "\","
+	  "\"summary\":\"Synthetic mod for benchmarking minimod.\","
+	  "\"description\":\"<p>Nothing to see here.</p>\","
+	  "\"tags\":[{\"name\":\"bench\"},{\"name\":\"synthetic\"}],"
+	  "\"submitted_by\":{\"id\":1,\"name_id\":\"bench\","
+	  "\"username\":\"bench\"},"
+	  "\"stats\":{\"mod_id\":%" PRIu64 ",\"downloads_total\":%" PRIu64 ","
+	  "\"subscribers_total\":%" PRIu64 ",\"ratings_positive\":10,"
+	  "\"ratings_negative\":1},"
+	  "\"modfile\":",
+	  mod_id,
+	  game_id,
+	  DATE,
+	  DATE,
+	  mod_id,
+	  mod_id,
+	  mod_id,
+	  mod_id * 100,
+	  mod_id * 10);
+	append_modfile(buf, game_id, mod_id);
+	append(buf, "}");
+}
+
+
+static void
+append_list_end(struct buffer *buf, uint64_t count)
+{
+	append(
+	  buf,
+	  "],\"result_count\":%" PRIu64 ",\"result_offset\":0,"
+	  "\"result_limit\":100,\"result_total\":%" PRIu64 "}",
+	  count,
+	  count);
+}
+
+
+// fills *out_body* with the response body and returns the HTTP status
+static int
+route(char const *in_path, struct buffer *out_body, bool *out_is_zip)
+{
+	uint64_t game = 0, mod = 0, file = 0;
+	int consumed = 0;
+	*out_is_zip = false;
+
+	if (0 == strcmp(in_path, "/v1/games"))
+	{
+		append(out_body, "{\"data\":[");
+		append_game(out_body, 1);
+		append_list_end(out_body, 1);
+		return 200;
+	}
+	if (sscanf(in_path, "/files/%" SCNu64 "/%" SCNu64 ".zip", &game, &mod) ==
+	  2)
+	{
+		*out_is_zip = true;
+		return 200;
+	}
+	if (sscanf(in_path, "/v1/games/%" SCNu64 "%n", &game, &consumed) != 1)
+	{
+		return 404;
+	}
+	in_path += consumed;
+
+	if (0 == strcmp(in_path, "/mods"))
+	{
+		uint64_t const n = l_mock.nmods < 100 ? l_mock.nmods : 100;
+		append(out_body, "{\"data\":[");
+		for (uint64_t i = 1; i <= n; ++i)
+		{
+			append(out_body, i > 1 ? "," : "");
+			append_mod(out_body, game, i);
+		}
+		append_list_end(out_body, n);
+		return 200;
+	}
+	if (sscanf(in_path, "/mods/%" SCNu64 "%n", &mod, &consumed) != 1 ||
+	  mod == 0 || mod > l_mock.nmods)
+	{
+		return 404;
+	}
+	in_path += consumed;
+
+	if (in_path[0] == '\0')
+	{
+		append_mod(out_body, game, mod);
+		return 200;
+	}
+	if (0 == strcmp(in_path, "/files"))
+	{
+		append(out_body, "{\"data\":[");
+		append_modfile(out_body, game, mod);
+		append_list_end(out_body, 1);
+		return 200;
+	}
+	if (sscanf(in_path, "/files/%" SCNu64, &file) == 1)
+	{
+		append_modfile(out_body, game, mod);
+		return 200;
+	}
+	return 404;
+}
+
+
+static bool
+send_all(int fd, void const *data, size_t len)
+{
+	char const *p = data;
+	while (len > 0)
+	{
+		ssize_t const n = send(fd, p, len, 0);
+		if (n <= 0)
+		{
+			return false;
+		}
+		p += n;
+		len -= (size_t)n;
+	}
+	return true;
+}
+
+
+static bool
+respond(int fd, char const *in_path)
+{
+	struct buffer body = { 0 };
+	bool is_zip;
+	int const status = route(in_path, &body, &is_zip);
+	if (status == 404)
+	{
+		body.len = 0;
+		append(
+		  &body,
+		  "{\"error\":{\"code\":404,\"message\":\"Not found: %s\"}}",
+		  in_path);
+	}
+
+	void const *data = is_zip ? l_mock.zip : body.data;
+	size_t const ndata = is_zip ? l_mock.nzip : body.len;
+
+	char header[256];
+	int const nheader = snprintf(
+	  header,
+	  sizeof header,
+	  "HTTP/1.1 %d %s\r\n"
+	  "Content-Type: %s\r\n"
+	  "Content-Length: %zu\r\n"
+	  "Connection: keep-alive\r\n"
+	  "\r\n",
+	  status,
+	  status == 200 ? "OK" : "Not Found",
+	  is_zip ? "application/zip" : "application/json",
+	  ndata);
+
+	bool const ok = send_all(fd, header, (size_t)nheader) &&
+	  send_all(fd, data, ndata);
+	free(body.data);
+	return ok;
+}
+
+
+static void *
+serve_connection(void *in_fd)
+{
+	int const fd = (int)(intptr_t)in_fd;
+	char request[MAX_REQUEST + 1];
+	size_t len = 0;
+
+	for (;;)
+	{
+		// read until the end of the request header
+		char *end;
+		request[len] = '\0';
+		while (!(end = strstr(request, "\r\n\r\n")))
+		{
+			if (len == MAX_REQUEST)
+			{
+				goto done;
+			}
+			ssize_t const n = recv(fd, request + len, MAX_REQUEST - len, 0);
+			if (n <= 0)
+			{
+				goto done;
+			}
+			len += (size_t)n;
+			request[len] = '\0';
+		}
+		size_t const nheader = (size_t)(end - request) + 4;
+
+		// skip the request body, if any
+		size_t nbody = 0;
+		char const *cl = strcasestr(request, "\r\nContent-Length:");
+		if (cl && cl < end)
+		{
+			nbody = strtoul(cl + 17, NULL, 10);
+		}
+
+		char path[1024] = { 0 };
+		if (sscanf(request, "%*s %1023s", path) != 1)
+		{
+			goto done;
+		}
+		char *query = strchr(path, '?');
+		if (query)
+		{
+			*query = '\0';
+		}
+		if (!respond(fd, path))
+		{
+			goto done;
+		}
+
+		// keep what belongs to the next request
+		size_t const consumed = nheader + nbody;
+		if (consumed <= len)
+		{
+			memmove(request, request + consumed, len - consumed);
+			len -= consumed;
+			continue;
+		}
+		for (size_t skip = consumed - len; skip > 0;)
+		{
+			size_t const chunk = skip < MAX_REQUEST ? skip : MAX_REQUEST;
+			ssize_t const n = recv(fd, request, chunk, 0);
+			if (n <= 0)
+			{
+				goto done;
+			}
+			skip -= (size_t)n;
+		}
+		len = 0;
+	}
+
+done:
+	close(fd);
+	return NULL;
+}
+
+
+static bool
+create_zip(size_t in_kib)
+{
+	// compressible, but not trivially so
+	size_t const size = in_kib * 1024;
+	unsigned char *content = malloc(size);
+	uint32_t x = 2463534242;
+	for (size_t i = 0; i < size; ++i)
+	{
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		content[i] = (unsigned char)('a' + (x % 16));
+	}
+
+	mz_zip_archive zip = { 0 };
+	bool ok = mz_zip_writer_init_heap(&zip, 0, 0) &&
+	  mz_zip_writer_add_mem(
+	    &zip,
+	    "data/content.txt",
+	    content,
+	    size,
+	    MZ_DEFAULT_COMPRESSION) &&
+	  mz_zip_writer_add_mem(
+	    &zip,
+	    "readme.txt",
+	    "synthetic mod\n",
+	    14,
+	    MZ_DEFAULT_COMPRESSION) &&
+	  mz_zip_writer_finalize_heap_archive(&zip, &l_mock.zip, &l_mock.nzip);
+	mz_zip_writer_end(&zip);
+	free(content);
+	return ok;
+}
+
+
+int
+main(int argc, char **argv)
+{
+	l_mock.port = argc > 1 ? atoi(argv[1]) : DEFAULT_PORT;
+	l_mock.nmods = argc > 2 ? strtoull(argv[2], NULL, 10) : DEFAULT_NMODS;
+	size_t const kib = argc > 3 ? strtoul(argv[3], NULL, 10) : DEFAULT_ZIP_KIB;
+
+	if (!create_zip(kib))
+	{
+		fprintf(stderr, "[mock] could not create zip\n");
+		return 1;
+	}
+
+	int const listener = socket(AF_INET, SOCK_STREAM, 0);
+	int const yes = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof yes);
+	struct sockaddr_in addr = { 0 };
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons((uint16_t)l_mock.port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(listener, (struct sockaddr *)&addr, sizeof addr) != 0 ||
+	  listen(listener, 128) != 0)
+	{
+		perror("[mock] bind/listen");
+		return 1;
+	}
+
+	signal(SIGPIPE, SIG_IGN);
+	printf(
+	  "[mock] listening on http://127.0.0.1:%d/v1 (%" PRIu64
+	  " mods, %zu byte zip)\n",
+	  l_mock.port,
+	  l_mock.nmods,
+	  l_mock.nzip);
+	fflush(stdout);
+
+	for (;;)
+	{
+		int const fd = accept(listener, NULL, NULL);
+		if (fd < 0)
+		{
+			continue;
+		}
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof yes);
+		pthread_t thread;
+		if (pthread_create(
+		      &thread,
+		      NULL,
+		      serve_connection,
+		      (void *)(intptr_t)fd) != 0)
+		{
+			close(fd);
+			continue;
+		}
+		pthread_detach(thread);
+	}
+}
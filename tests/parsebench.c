@@ -0,0 +1,894 @@
+// Microbenchmark of turning API responses into minimod's structs, using
+// generated responses of 1 to 100 items.
+//
+// usage: parsebench [milliseconds per measurement] [recording]
+//
+// For every endpoint and response size it measures separately:
+// - size:     QAJ4C_calculate_max_buffer_size_n()
+// - parse:    QAJ4C_parse_opt()
+// - tree:     jsontree_parse(), building the same values from the
+//   structural characters, see ENABLE_JSONTREE in the Makefile
+// - populate: populate_*() of all items and the pagination
+// - handle:   the complete response handler, including its allocations
+// - batched:  the handler, delivering items in batches of BATCH_SIZE
+// - first:    time until the batched handler delivers its first batch
+// - scalar, sse2, avx2: finding all structural characters with jsonindex,
+//   the way the batched handler splits the items, for each instruction
+//   set the build and the CPU support
+//
+// Before measuring, the items split by jsonindex are checked against the
+// items of the document parsed as a whole, with every instruction set, and
+// the values built by jsontree against those parsed by QAJ4C. The latter
+// is also checked with the responses of a recording, see
+// minimod_set_transport(), if one is given.
+//
+// It includes src/minimod.c to get at its internal functions, so it is
+// linked against the library's objects instead of the library.
+
+#include "../src/minimod.c"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// CONFIG
+// ------
+// default duration of each measurement, in milliseconds
+#define DEFAULT_DURATION 200
+// every measurement runs at least this often
+#define MIN_ITERATIONS 10
+// items per call in the batched stages, see minimod_set_batch_size()
+#define BATCH_SIZE 10
+
+
+struct json
+{
+	char *data;
+	size_t len;
+	size_t capacity;
+};
+
+
+struct fixture
+{
+	char const *name;
+	void (*generate)(struct json *, size_t);
+	response_handler handler;
+	enum minimod_endpoint endpoint;
+	char _padding[4];
+};
+
+
+// accumulated by the callbacks, so nothing is optimized away
+static uint64_t l_sink;
+// allocations done by minimod, see minimod_set_allocator()
+static size_t l_nallocs;
+// sys_nanoseconds() of the first callback since it was reset
+static uint64_t l_first_call;
+
+
+static void *
+counting_alloc(void *UNUSED(userdata), size_t in_bytes)
+{
+	++l_nallocs;
+	return malloc(in_bytes);
+}
+
+
+static void *
+counting_realloc(void *UNUSED(userdata), void *in_ptr, size_t in_bytes)
+{
+	++l_nallocs;
+	return realloc(in_ptr, in_bytes);
+}
+
+
+static void
+counting_free(void *UNUSED(userdata), void *in_ptr)
+{
+	free(in_ptr);
+}
+
+
+static void
+append(struct json *out, char const *in_format, ...)
+{
+	for (;;)
+	{
+		va_list args;
+		va_start(args, in_format);
+		size_t const available = out->capacity - out->len;
+		int const n =
+		  vsnprintf(out->data + out->len, available, in_format, args);
+		va_end(args);
+		ASSERT(n >= 0);
+		if ((size_t)n < available)
+		{
+			out->len += (size_t)n;
+			return;
+		}
+		out->capacity = out->capacity * 2 + (size_t)n;
+		out->data = realloc(out->data, out->capacity);
+	}
+}
+
+
+// deterministic, so that all runs use the same responses
+static uint32_t
+next_random(uint32_t *io_state)
+{
+	uint32_t x = *io_state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *io_state = x;
+}
+
+
+// HTML the way mod.io returns it: escaped quotes, slashes and newlines
+static void
+append_text(struct json *out, uint32_t *io_random, size_t in_bytes)
+{
+	static char const *const words[] = {
+		"mod",    "texture", "the",   "\\\"improved\\\"", "map",
+		"and",    "version", "with",  "<\\/p>\\n<p>",     "weapons",
+		"of",     "fixes",   "a",     "<strong>new<\\/strong>",
+		"sounds", "for",     "UI",    "compatible",       "patch",
+	};
+	size_t const nwords = sizeof words / sizeof *words;
+	size_t const end = out->len + in_bytes;
+	append(out, "<p>");
+	while (out->len < end)
+	{
+		append(out, "%s ", words[next_random(io_random) % nwords]);
+	}
+	append(out, "<\\/p>");
+}
+
+
+static void
+append_modfile(struct json *out, uint32_t *io_random, size_t in_id)
+{
+	append(
+	  out,
+	  "{\"id\":%zu,\"mod_id\":%zu,\"date_added\":1565731452,"
+	  "\"date_scanned\":1565731500,\"virus_status\":1,\"virus_positive\":0,"
+	  "\"virustotal_hash\":null,\"filesize\":%u,"
+	  "\"filehash\":{\"md5\":\"2d4a0e2d7273db6b0a94b0740a88ad0d\"},"
+	  "\"filename\":\"mod-%zu.zip\",\"version\":\"1.%u.0\",\"changelog\":\"",
+	  in_id * 7,
+	  in_id,
+	  next_random(io_random) % (64 << 20),
+	  in_id,
+	  next_random(io_random) % 20);
+	append_text(out, io_random, 64 + next_random(io_random) % 1024);
+	append(
+	  out,
+	  "\",\"metadata_blob\":null,\"download\":{\"binary_url\":"
+	  "\"https:\\/\\/api.mod.io\\/v1\\/games\\/1\\/mods\\/%zu\\/files\\/%zu"
+	  "\\/download\\/c489a0354111a4d76640d47f0cdcb294\","
+	  "\"date_expires\":1579316848}}",
+	  in_id,
+	  in_id * 7);
+}
+
+
+static void
+append_image(struct json *out, char const *in_name, size_t in_id)
+{
+	append(
+	  out,
+	  "\"%s\":{\"filename\":\"%zu.png\",\"original\":"
+	  "\"https:\\/\\/static.mod.io\\/v1\\/images\\/branding\\/%zu.png\","
+	  "\"thumb_320x180\":"
+	  "\"https:\\/\\/static.mod.io\\/v1\\/images\\/branding\\/%zu_320.png\","
+	  "\"thumb_640x360\":"
+	  "\"https:\\/\\/static.mod.io\\/v1\\/images\\/branding\\/%zu_640.png\"}",
+	  in_name,
+	  in_id,
+	  in_id,
+	  in_id,
+	  in_id);
+}
+
+
+static void
+append_pagination(struct json *out, size_t in_count)
+{
+	append(
+	  out,
+	  "],\"result_count\":%zu,\"result_offset\":0,\"result_limit\":100,"
+	  "\"result_total\":%zu}",
+	  in_count,
+	  in_count * 10);
+}
+
+
+static void
+generate_mods(struct json *out, size_t in_count)
+{
+	uint32_t random = 0x9e3779b9u;
+	append(out, "{\"data\":[");
+	for (size_t i = 1; i <= in_count; ++i)
+	{
+		append(
+		  out,
+		  "%s{\"id\":%zu,\"game_id\":1,\"status\":1,\"visible\":1,"
+		  "\"submitted_by\":{\"id\":%zu,\"name_id\":\"user-%zu\","
+		  "\"username\":\"User %zu\",\"date_online\":1509922961,",
+		  i > 1 ? "," : "",
+		  i,
+		  i * 3,
+		  i * 3,
+		  i * 3);
+		append_image(out, "avatar", i * 3);
+		append(
+		  out,
+		  ",\"timezone\":\"\",\"language\":\"\","
+		  "\"profile_url\":\"https:\\/\\/mod.io\\/members\\/user-%zu\"},"
+		  "\"date_added\":1492564103,\"date_updated\":%u,"
+		  "\"date_live\":1499841403,\"maturity_option\":0,",
+		  i * 3,
+		  1499841487 + next_random(&random) % 10000000);
+		append_image(out, "logo", i);
+		append(
+		  out,
+		  ",\"homepage_url\":null,\"name\":\"Mod Number %zu\","
+		  "\"name_id\":\"mod-number-%zu\",\"summary\":\"",
+		  i,
+		  i);
+		append_text(out, &random, 100 + next_random(&random) % 150);
+		append(out, "\",\"description\":\"");
+		append_text(out, &random, 256 + next_random(&random) % 6000);
+		append(out, "\",\"description_plaintext\":\"");
+		append_text(out, &random, 128 + next_random(&random) % 3000);
+		append(
+		  out,
+		  "\",\"metadata_blob\":null,"
+		  "\"profile_url\":\"https:\\/\\/mod.io\\/g\\/game\\/m\\/mod-%zu\","
+		  "\"media\":{\"youtube\":[],\"sketchfab\":[],\"images\":[{",
+		  i);
+		append_image(out, "image", i * 5);
+		append(out, "}]},\"modfile\":");
+		append_modfile(out, &random, i);
+		append(
+		  out,
+		  ",\"metadata_kvp\":[{\"metakey\":\"pistol-dmg\","
+		  "\"metavalue\":\"800\"}],\"tags\":[{\"name\":\"Unity\","
+		  "\"date_added\":1499841487},{\"name\":\"Maps\","
+		  "\"date_added\":1499841487}],"
+		  "\"stats\":{\"mod_id\":%zu,\"popularity_rank_position\":%u,"
+		  "\"popularity_rank_total_mods\":1000,\"downloads_total\":%u,"
+		  "\"subscribers_total\":%u,\"ratings_total\":1230,"
+		  "\"ratings_positive\":1047,\"ratings_negative\":183,"
+		  "\"ratings_percentage_positive\":91,"
+		  "\"ratings_weighted_aggregate\":0.87,"
+		  "\"ratings_display_text\":\"Very Positive\","
+		  "\"date_expires\":1492564103}}",
+		  i,
+		  next_random(&random) % 1000,
+		  next_random(&random) % 1000000,
+		  next_random(&random) % 100000);
+	}
+	append_pagination(out, in_count);
+}
+
+
+static void
+generate_modfiles(struct json *out, size_t in_count)
+{
+	uint32_t random = 0x2545f491u;
+	append(out, "{\"data\":[");
+	for (size_t i = 1; i <= in_count; ++i)
+	{
+		append(out, "%s", i > 1 ? "," : "");
+		append_modfile(out, &random, i);
+	}
+	append_pagination(out, in_count);
+}
+
+
+static void
+generate_events(struct json *out, size_t in_count)
+{
+	static char const *const types[] = {
+		"MODFILE_CHANGED", "MOD_AVAILABLE",  "MOD_UNAVAILABLE",
+		"MOD_EDITED",      "MOD_DELETED",    "USER_SUBSCRIBE",
+		"USER_UNSUBSCRIBE", "USER_TEAM_JOIN", "USER_TEAM_LEAVE",
+	};
+	uint32_t random = 0x6b8b4567u;
+	append(out, "{\"data\":[");
+	for (size_t i = 1; i <= in_count; ++i)
+	{
+		append(
+		  out,
+		  "%s{\"id\":%zu,\"mod_id\":%u,\"user_id\":%u,"
+		  "\"date_added\":%u,\"event_type\":\"%s\"}",
+		  i > 1 ? "," : "",
+		  i,
+		  next_random(&random) % 100000,
+		  next_random(&random) % 100000,
+		  1499846132 + next_random(&random) % 10000000,
+		  types[next_random(&random) % (sizeof types / sizeof *types)]);
+	}
+	append_pagination(out, in_count);
+}
+
+
+static void
+on_mods(
+  void *UNUSED(udata),
+  size_t in_nmods,
+  struct minimod_mod const *in_mods,
+  struct minimod_pagination const *UNUSED(pagi))
+{
+	if (!l_first_call)
+	{
+		l_first_call = sys_nanoseconds();
+	}
+	for (size_t i = 0; i < in_nmods; ++i)
+	{
+		l_sink += in_mods[i].id + in_mods[i].modfile_id;
+	}
+}
+
+
+static void
+on_modfiles(
+  void *UNUSED(udata),
+  size_t in_nmodfiles,
+  struct minimod_modfile const *in_modfiles,
+  struct minimod_pagination const *UNUSED(pagi))
+{
+	if (!l_first_call)
+	{
+		l_first_call = sys_nanoseconds();
+	}
+	for (size_t i = 0; i < in_nmodfiles; ++i)
+	{
+		l_sink += in_modfiles[i].id + in_modfiles[i].filesize;
+	}
+}
+
+
+static void
+on_events(
+  void *UNUSED(udata),
+  size_t in_nevents,
+  struct minimod_event const *in_events,
+  struct minimod_pagination const *UNUSED(pagi))
+{
+	if (!l_first_call)
+	{
+		l_first_call = sys_nanoseconds();
+	}
+	for (size_t i = 0; i < in_nevents; ++i)
+	{
+		l_sink += in_events[i].id + (uint64_t)in_events[i].type;
+	}
+}
+
+
+static void
+populate_all(
+  enum minimod_endpoint in_endpoint,
+  QAJ4C_Value const *in_document,
+  void *out_items)
+{
+	QAJ4C_Value const *data = QAJ4C_object_get(in_document, "data");
+	size_t const n = QAJ4C_array_size(data);
+	for (size_t i = 0; i < n; ++i)
+	{
+		QAJ4C_Value const *node = QAJ4C_array_get(data, i);
+		switch (in_endpoint)
+		{
+		case MINIMOD_ENDPOINT_MODS:
+			populate_mod((struct minimod_mod *)out_items + i, node);
+			break;
+		case MINIMOD_ENDPOINT_MODFILES:
+			populate_modfile((struct minimod_modfile *)out_items + i, node);
+			break;
+		default:
+			populate_event((struct minimod_event *)out_items + i, node);
+			break;
+		}
+	}
+	struct minimod_pagination pagi;
+	populate_pagination(&pagi, in_document);
+	l_sink += pagi.total;
+}
+
+
+static void
+call_handler(struct fixture const *in_fixture, struct json const *in_json)
+{
+	struct task *task = alloc_task();
+	task->endpoint = in_fixture->endpoint;
+	switch (in_fixture->endpoint)
+	{
+	case MINIMOD_ENDPOINT_MODS:
+		task->callback.fptr.get_mods = on_mods;
+		break;
+	case MINIMOD_ENDPOINT_MODFILES:
+		task->callback.fptr.get_modfiles = on_modfiles;
+		break;
+	default:
+		task->callback.fptr.get_events = on_events;
+		break;
+	}
+	in_fixture->handler(task, in_json->data, in_json->len, 200, NULL);
+}
+
+
+enum stage
+{
+	STAGE_SIZE,
+	STAGE_PARSE,
+	STAGE_TREE,
+	STAGE_POPULATE,
+	STAGE_HANDLE,
+	STAGE_BATCHED,
+	STAGE_FIRST,
+	STAGE_SCALAR,
+	STAGE_SSE2,
+	STAGE_AVX2,
+	STAGE_COUNT,
+};
+
+
+static char const *const stage_names[STAGE_COUNT] = {
+	"size",
+	"parse",
+	"tree",
+	"populate",
+	"handle",
+	"batched",
+	"first",
+	"scalar",
+	"sse2",
+	"avx2",
+};
+
+
+static uint64_t
+item_id(enum minimod_endpoint in_endpoint, QAJ4C_Value const *in_node)
+{
+	struct minimod_mod mod;
+	struct minimod_modfile modfile;
+	struct minimod_event event;
+	switch (in_endpoint)
+	{
+	case MINIMOD_ENDPOINT_MODS:
+		populate_mod(&mod, in_node);
+		return mod.id + mod.modfile_id;
+	case MINIMOD_ENDPOINT_MODFILES:
+		populate_modfile(&modfile, in_node);
+		return modfile.id + modfile.filesize;
+	default:
+		populate_event(&event, in_node);
+		return event.id + (uint64_t)event.type;
+	}
+}
+
+
+// compares the items split by jsonindex with *in_isa* with the items of
+// *in_document*, which is *in_json* parsed as a whole
+static bool
+validate(
+  enum jsonindex_isa in_isa,
+  struct fixture const *in_fixture,
+  struct json const *in_json,
+  QAJ4C_Value const *in_document)
+{
+	if (!jsonindex_use(in_isa))
+	{
+		return true;
+	}
+	QAJ4C_Value const *data = QAJ4C_object_get(in_document, "data");
+	struct arena_mark const mark = arena_mark();
+	struct scan scan = { .pos = 0 };
+	jsonindex_init(&scan.index, in_json->data, in_json->len);
+	bool valid = scan_to_data(&scan);
+	size_t nitems = 0;
+	char const *item;
+	size_t nitem;
+	while (valid && scan_item(&scan, &item, &nitem))
+	{
+		QAJ4C_Value const *node = parse_json(item, nitem);
+		valid = QAJ4C_is_object(node) && nitems < QAJ4C_array_size(data) &&
+		  item_id(in_fixture->endpoint, node) ==
+		    item_id(in_fixture->endpoint, QAJ4C_array_get(data, nitems));
+		++nitems;
+	}
+	arena_release(mark);
+	jsonindex_start();
+	return valid && nitems == QAJ4C_array_size(data) &&
+	  scan.pos < in_json->len && in_json->data[scan.pos] == ']';
+}
+
+
+// with QAJ4C, regardless of ENABLE_JSONTREE
+static QAJ4C_Value const *
+parse_reference(char const *in_data, size_t in_len)
+{
+	size_t const nbuffer = QAJ4C_calculate_max_buffer_size_n(in_data, in_len);
+	QAJ4C_Value const *document = NULL;
+	QAJ4C_parse_opt(
+	  in_data,
+	  in_len,
+	  0,
+	  arena_alloc(nbuffer),
+	  nbuffer,
+	  &document);
+	return document;
+}
+
+
+static bool
+same_values(QAJ4C_Value const *in_a, QAJ4C_Value const *in_b)
+{
+	if (QAJ4C_is_object(in_a))
+	{
+		if (!QAJ4C_is_object(in_b) ||
+		  QAJ4C_object_size(in_a) != QAJ4C_object_size(in_b))
+		{
+			return false;
+		}
+		for (size_t i = 0; i < QAJ4C_object_size(in_a); ++i)
+		{
+			QAJ4C_Member const *member = QAJ4C_object_get_member(in_a, i);
+			QAJ4C_Value const *key = QAJ4C_member_get_key(member);
+			QAJ4C_Value const *other =
+			  QAJ4C_object_get(in_b, QAJ4C_get_string(key));
+			if (!other || !same_values(QAJ4C_member_get_value(member), other))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	if (QAJ4C_is_array(in_a))
+	{
+		if (!QAJ4C_is_array(in_b) ||
+		  QAJ4C_array_size(in_a) != QAJ4C_array_size(in_b))
+		{
+			return false;
+		}
+		for (size_t i = 0; i < QAJ4C_array_size(in_a); ++i)
+		{
+			if (!same_values(
+			      QAJ4C_array_get(in_a, i),
+			      QAJ4C_array_get(in_b, i)))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	if (QAJ4C_is_string(in_a))
+	{
+		size_t const len = QAJ4C_get_string_length(in_a);
+		return QAJ4C_is_string(in_b) &&
+		  QAJ4C_get_string_length(in_b) == len &&
+		  0 == memcmp(QAJ4C_get_string(in_a), QAJ4C_get_string(in_b), len);
+	}
+	if (QAJ4C_is_uint64(in_a))
+	{
+		return QAJ4C_is_uint64(in_b) &&
+		  QAJ4C_get_uint64(in_a) == QAJ4C_get_uint64(in_b);
+	}
+	if (QAJ4C_is_int64(in_a))
+	{
+		return QAJ4C_is_int64(in_b) &&
+		  QAJ4C_get_int64(in_a) == QAJ4C_get_int64(in_b);
+	}
+	if (QAJ4C_is_double(in_a))
+	{
+		return QAJ4C_is_double(in_b) &&
+		  QAJ4C_get_double(in_a) == QAJ4C_get_double(in_b);
+	}
+	if (QAJ4C_is_bool(in_a))
+	{
+		return QAJ4C_is_bool(in_b) &&
+		  QAJ4C_get_bool(in_a) == QAJ4C_get_bool(in_b);
+	}
+	return QAJ4C_is_null(in_a) ? QAJ4C_is_null(in_b)
+	                           : QAJ4C_is_error(in_b);
+}
+
+
+// compares the values jsontree builds from *in_data* with *in_document*,
+// which is *in_data* parsed by QAJ4C
+static bool
+validate_tree(
+  char const *in_data,
+  size_t in_len,
+  QAJ4C_Value const *in_document)
+{
+	struct arena_mark const mark = arena_mark();
+	size_t const nbuffer = jsontree_buffer_size(in_data, in_len);
+	QAJ4C_Value const *tree =
+	  jsontree_parse(in_data, in_len, arena_alloc(nbuffer), nbuffer);
+	bool const valid =
+	  same_values(in_document, tree) && same_values(tree, in_document);
+	arena_release(mark);
+	return valid;
+}
+
+
+struct replays
+{
+	size_t nchecked;
+	size_t nfailed;
+};
+
+
+static void
+on_replay(
+  void *in_udata,
+  void const *in_data,
+  size_t in_len,
+  int UNUSED(error),
+  struct netw_header const *in_header)
+{
+	struct replays *replays = in_udata;
+	void *decoded = NULL;
+	size_t ndecoded = 0;
+	if (!decode_body(in_data, in_len, in_header, &decoded, &ndecoded))
+	{
+		return;
+	}
+	char const *data = decoded ? decoded : in_data;
+	size_t const len = decoded ? ndecoded : in_len;
+	// error pages and empty bodies are not parsed either
+	if (len > 0 && (data[0] == '{' || data[0] == '['))
+	{
+		struct arena_mark const mark = arena_mark();
+		++replays->nchecked;
+		if (!validate_tree(data, len, parse_reference(data, len)))
+		{
+			++replays->nfailed;
+		}
+		arena_release(mark);
+	}
+	mem_free(decoded);
+}
+
+
+// returns nanoseconds per run of *in_stage*
+static double
+measure(
+  enum stage in_stage,
+  struct fixture const *in_fixture,
+  struct json const *in_json,
+  uint64_t in_duration,
+  double *out_nallocs)
+{
+	size_t const nbuffer =
+	  QAJ4C_calculate_max_buffer_size_n(in_json->data, in_json->len);
+	void *buffer = malloc(nbuffer);
+	QAJ4C_Value const *document = NULL;
+	QAJ4C_parse_opt(
+	  in_json->data,
+	  in_json->len,
+	  0,
+	  buffer,
+	  nbuffer,
+	  &document);
+	size_t const ntree = jsontree_buffer_size(in_json->data, in_json->len);
+	void *tree = malloc(ntree);
+	// large enough for all kinds of items
+	void *items = calloc(100, sizeof(struct minimod_mod));
+
+	bool const is_batched =
+	  in_stage == STAGE_BATCHED || in_stage == STAGE_FIRST;
+	minimod_set_batch_size(is_batched ? BATCH_SIZE : 0);
+	if (in_stage >= STAGE_SCALAR)
+	{
+		jsonindex_use((enum jsonindex_isa)(in_stage - STAGE_SCALAR));
+	}
+
+	size_t const nallocs = l_nallocs;
+	uint64_t first_call = 0;
+	uint64_t iterations = 0;
+	uint64_t const start = sys_nanoseconds();
+	uint64_t now = start;
+	while (iterations < MIN_ITERATIONS || now - start < in_duration)
+	{
+		switch (in_stage)
+		{
+		case STAGE_SIZE:
+			l_sink +=
+			  QAJ4C_calculate_max_buffer_size_n(in_json->data, in_json->len);
+			break;
+		case STAGE_PARSE:
+			QAJ4C_parse_opt(
+			  in_json->data,
+			  in_json->len,
+			  0,
+			  buffer,
+			  nbuffer,
+			  &document);
+			break;
+		case STAGE_TREE:
+			jsontree_parse(in_json->data, in_json->len, tree, ntree);
+			break;
+		case STAGE_POPULATE:
+			populate_all(in_fixture->endpoint, document, items);
+			break;
+		case STAGE_SCALAR:
+		case STAGE_SSE2:
+		case STAGE_AVX2:
+		{
+			struct jsonindex index;
+			jsonindex_init(&index, in_json->data, in_json->len);
+			while (jsonindex_next(&index) < in_json->len)
+			{
+				++l_sink;
+			}
+			break;
+		}
+		case STAGE_FIRST:
+		{
+			l_first_call = 0;
+			uint64_t const called = sys_nanoseconds();
+			call_handler(in_fixture, in_json);
+			first_call += l_first_call - called;
+			break;
+		}
+		default:
+			call_handler(in_fixture, in_json);
+			break;
+		}
+		++iterations;
+		now = sys_nanoseconds();
+	}
+	*out_nallocs = (double)(l_nallocs - nallocs) / (double)iterations;
+	minimod_set_batch_size(0);
+	jsonindex_start();
+
+	free(items);
+	free(tree);
+	free(buffer);
+	if (in_stage == STAGE_FIRST)
+	{
+		return (double)first_call / (double)iterations;
+	}
+	return (double)(now - start) / (double)iterations;
+}
+
+
+int
+main(int argc, char **argv)
+{
+	uint64_t const duration =
+	  (argc > 1 ? strtoull(argv[1], NULL, 10) : DEFAULT_DURATION) * 1000000;
+
+	minimod_set_allocator(
+	  counting_alloc,
+	  counting_realloc,
+	  counting_free,
+	  NULL);
+	// the parts of minimod_init() the handlers depend on
+	arena_start();
+	enum jsonindex_isa const isa = jsonindex_start();
+	prepare_schemas();
+	mtx_init(&l_mmi.free_tasks_mtx, mtx_plain);
+	mtx_init(&l_mmi.documents_mtx, mtx_plain);
+
+	if (argc > 2)
+	{
+		struct replays replays = { 0 };
+		if (!transport_configure(MINIMOD_TRANSPORT_REPLAY, argv[2]))
+		{
+			fprintf(stderr, "could not read %s\n", argv[2]);
+			return 1;
+		}
+		struct arena_mark const mark = arena_mark();
+		transport_enum_replays(on_replay, &replays);
+		arena_release(mark);
+		transport_configure(MINIMOD_TRANSPORT_NETWORK, NULL);
+		printf(
+		  "%s: %zu responses, %zu built differently by jsontree\n",
+		  argv[2],
+		  replays.nchecked,
+		  replays.nfailed);
+		if (replays.nfailed > 0)
+		{
+			return 1;
+		}
+	}
+
+	struct fixture const fixtures[] = {
+		{ "get_mods",
+		  generate_mods,
+		  handle_get_mods,
+		  MINIMOD_ENDPOINT_MODS,
+		  { 0 } },
+		{ "get_modfiles",
+		  generate_modfiles,
+		  handle_get_modfiles,
+		  MINIMOD_ENDPOINT_MODFILES,
+		  { 0 } },
+		{ "get_events",
+		  generate_events,
+		  handle_get_events,
+		  MINIMOD_ENDPOINT_EVENTS,
+		  { 0 } },
+	};
+	size_t const counts[] = { 1, 10, 100 };
+
+	printf(
+	  "%-12s %5s %9s  %-8s %12s %10s %10s %8s\n",
+	  "endpoint",
+	  "items",
+	  "bytes",
+	  "stage",
+	  "ns/response",
+	  "ns/item",
+	  "MB/s",
+	  "allocs");
+	for (size_t f = 0; f < sizeof fixtures / sizeof *fixtures; ++f)
+	{
+		for (size_t c = 0; c < sizeof counts / sizeof *counts; ++c)
+		{
+			struct json json = { 0 };
+			fixtures[f].generate(&json, counts[c]);
+			struct arena_mark const mark = arena_mark();
+			QAJ4C_Value const *document =
+			  parse_reference(json.data, json.len);
+			if (!validate_tree(json.data, json.len, document))
+			{
+				fprintf(
+				  stderr,
+				  "%s: jsontree built %zu items differently\n",
+				  fixtures[f].name,
+				  counts[c]);
+				return 1;
+			}
+			for (int i = 0; i <= (int)isa; ++i)
+			{
+				enum jsonindex_isa const other = (enum jsonindex_isa)i;
+				if (!validate(other, &fixtures[f], &json, document))
+				{
+					fprintf(
+					  stderr,
+					  "%s: %s split %zu items differently\n",
+					  fixtures[f].name,
+					  stage_names[STAGE_SCALAR + i],
+					  counts[c]);
+					return 1;
+				}
+			}
+			for (int s = 0; s < STAGE_COUNT; ++s)
+			{
+				if (s > STAGE_SCALAR + (int)isa)
+				{
+					continue;
+				}
+				double nallocs;
+				double const ns = measure(
+				  (enum stage)s,
+				  &fixtures[f],
+				  &json,
+				  duration,
+				  &nallocs);
+				printf(
+				  "%-12s %5zu %9zu  %-8s %12.0f %10.1f %10.1f %8.1f\n",
+				  fixtures[f].name,
+				  counts[c],
+				  json.len,
+				  stage_names[s],
+				  ns,
+				  ns / (double)counts[c],
+				  (double)json.len / ns * 1e3,
+				  nallocs);
+			}
+			arena_release(mark);
+			free(json.data);
+		}
+	}
+
+	// keeps l_sink alive
+	return l_sink == 42 ? 1 : 0;
+}